@@ -0,0 +1,40 @@
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+namespace bench {
+
+/// Keeps the optimizer from discarding a computed value.
+template <typename T> inline void do_not_optimize(T const &value) {
+#if defined(__GNUC__)
+  asm volatile("" : : "r,m"(value) : "memory");
+#else
+  static const void *volatile sink;
+  sink = &value;
+#endif
+}
+
+/// Runs `fn` `iterations` times and returns the mean time per run in
+/// nanoseconds.
+template <typename Fn> double measure(std::size_t iterations, Fn &&fn) {
+  using clock = std::chrono::steady_clock;
+  const auto start = clock::now();
+  for (std::size_t i = 0; i != iterations; ++i)
+    fn();
+  const auto elapsed = clock::now() - start;
+  return std::chrono::duration<double, std::nano>(elapsed).count() /
+         static_cast<double>(iterations);
+}
+
+inline void report(const char *name, double ns) {
+  std::printf("%-40s %14.1f ns\n", name, ns);
+}
+
+/// First command line argument as a size, or `fallback`.
+inline std::size_t arg_or(int argc, char **argv, std::size_t fallback) {
+  return argc > 1 ? std::strtoull(argv[1], nullptr, 10) : fallback;
+}
+
+} // namespace bench
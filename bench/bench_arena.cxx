@@ -0,0 +1,38 @@
+#include "bench.hpp"
+
+#include <utl/arena.hpp>
+#include <utl/string.hpp>
+#include <utl/vector.hpp>
+
+// Simulates a request handler that builds a few dozen short-lived vectors and
+// strings per request.
+template <typename IntAlloc, typename CharAlloc>
+static void handle_request(const IntAlloc &ia, const CharAlloc &ca) {
+  using string = utl::basic_string<char, std::char_traits<char>, CharAlloc>;
+
+  for (int i = 0; i != 32; ++i) {
+    utl::vector<int, IntAlloc> v(ia);
+    for (int j = 0; j != 24; ++j)
+      v.push_back(j);
+    string s(40, 'x', ca);
+    bench::do_not_optimize(v.data());
+    bench::do_not_optimize(s.data());
+  }
+}
+
+int main(int argc, char **argv) {
+  const auto requests = bench::arg_or(argc, argv, 20000);
+
+  const auto heap = bench::measure(requests, [] {
+    handle_request(utl::allocator<int>(), utl::allocator<char>());
+  });
+  bench::report("utl::allocator, per request", heap);
+
+  utl::arena arena;
+  const auto bump = bench::measure(requests, [&arena] {
+    handle_request(utl::arena_allocator<int>(arena),
+                   utl::arena_allocator<char>(arena));
+    arena.reset();
+  });
+  bench::report("utl::arena_allocator, per request", bump);
+}
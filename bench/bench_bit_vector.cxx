@@ -0,0 +1,51 @@
+#include "bench.hpp"
+
+#include <utl/bit_vector.hpp>
+#include <utl/vector.hpp>
+
+#include <cstdint>
+#include <random>
+
+// Population count over N flags stored one per byte and packed, and rank /
+// select queries on the packed form with and without the sampled index.
+int main(int argc, char **argv) {
+  const auto count = bench::arg_or(argc, argv, std::size_t(1) << 27);
+
+  std::mt19937_64 rng(1);
+  utl::vector<std::uint8_t> bytes(count);
+  utl::bit_vector bits(count);
+  for (std::size_t i = 0; i != count; ++i) {
+    const bool value = rng() & 1;
+    bytes[i] = value;
+    bits.set(i, value);
+  }
+  std::printf("%zu flags: %zu MiB as bytes, %zu MiB packed\n", count,
+              count >> 20, count >> 23);
+
+  bench::report("vector<uint8_t>: count", bench::measure(5, [&] {
+                  std::size_t n = 0;
+                  for (const auto b : bytes)
+                    n += b;
+                  bench::do_not_optimize(n);
+                }));
+  bench::report("bit_vector: count", bench::measure(5, [&] {
+                  bench::do_not_optimize(bits.count());
+                }));
+
+  const std::size_t queries = 1000;
+  const auto ones = bits.count();
+  auto query = [&](const char *rank_name, const char *select_name) {
+    std::size_t pos = 0;
+    bench::report(rank_name, bench::measure(queries, [&] {
+                    pos = (pos + 0x9e3779b97f4a7c15u) % count;
+                    bench::do_not_optimize(bits.rank(pos));
+                  }));
+    bench::report(select_name, bench::measure(queries, [&] {
+                    pos = (pos + 0x9e3779b97f4a7c15u) % ones;
+                    bench::do_not_optimize(bits.select(pos));
+                  }));
+  };
+  query("bit_vector: rank (scan)", "bit_vector: select (scan)");
+  bits.build_index();
+  query("bit_vector: rank (indexed)", "bit_vector: select (indexed)");
+}
@@ -0,0 +1,39 @@
+#include "bench.hpp"
+
+#include <utl/vector.hpp>
+
+#include <cstdint>
+
+// Many small vectors kept inside an outer vector, as in an adjacency list:
+// the 16-byte compact_vector header against the 24-byte vector one. Fills
+// every inner vector with a few elements, then sums them all.
+template <typename Inner>
+static void run(const char *name, std::size_t count) {
+  utl::vector<Inner> outer;
+  char label[64];
+  std::snprintf(label, sizeof(label), "%s fill", name);
+  bench::report(label, bench::measure(3, [&] {
+                  outer = utl::vector<Inner>(count);
+                  for (std::size_t i = 0; i != count; ++i)
+                    for (std::uint32_t j = 0; j != i % 4; ++j)
+                      outer[i].push_back(j);
+                  bench::do_not_optimize(outer.data());
+                }));
+  std::snprintf(label, sizeof(label), "%s sum", name);
+  bench::report(label, bench::measure(10, [&] {
+                  std::uint64_t sum = 0;
+                  for (const auto &inner : outer)
+                    for (const auto x : inner)
+                      sum += x;
+                  bench::do_not_optimize(sum);
+                }));
+}
+
+int main(int argc, char **argv) {
+  const auto count = bench::arg_or(argc, argv, std::size_t(1) << 22);
+  std::printf("vector %zu bytes, compact_vector %zu bytes\n",
+              sizeof(utl::vector<std::uint32_t>),
+              sizeof(utl::compact_vector<std::uint32_t>));
+  run<utl::vector<std::uint32_t>>("vector", count);
+  run<utl::compact_vector<std::uint32_t>>("compact_vector", count);
+}
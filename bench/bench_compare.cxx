@@ -0,0 +1,82 @@
+#include "bench.hpp"
+
+#include <utl/vector.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+
+// Sorts and deduplicates many short integer vectors, as a dedup stage
+// does, once with utl::vector's comparisons and once with element-wise
+// std::lexicographical_compare and std::equal. Pointers are sorted so only
+// the comparisons are timed. Then compares two long vectors that differ
+// only in their last element.
+template <typename T>
+static void run(const char *name, std::size_t count, std::size_t length) {
+  std::mt19937 rng(42);
+  std::uniform_int_distribution<int> value(0, 3);
+  utl::vector<utl::vector<T>> input;
+  for (std::size_t i = 0; i != count; ++i) {
+    utl::vector<T> v;
+    for (std::size_t j = 0; j != length; ++j)
+      v.push_back(static_cast<T>(value(rng)));
+    input.push_back(std::move(v));
+  }
+
+  utl::vector<const utl::vector<T> *> order;
+  for (const auto &v : input)
+    order.push_back(&v);
+
+  char label[64];
+  std::snprintf(label, sizeof(label), "%s x%zu dedup, utl", name, length);
+  bench::report(label, bench::measure(5, [&] {
+                  auto work = order;
+                  std::sort(work.begin(), work.end(),
+                            [](auto a, auto b) { return *a < *b; });
+                  bench::do_not_optimize(
+                      std::unique(work.begin(), work.end(),
+                                  [](auto a, auto b) { return *a == *b; }) -
+                      work.begin());
+                }));
+
+  std::snprintf(label, sizeof(label), "%s x%zu dedup, std", name, length);
+  bench::report(label, bench::measure(5, [&] {
+                  auto work = order;
+                  std::sort(work.begin(), work.end(), [](auto a, auto b) {
+                    return std::lexicographical_compare(a->begin(), a->end(),
+                                                        b->begin(), b->end());
+                  });
+                  bench::do_not_optimize(
+                      std::unique(work.begin(), work.end(),
+                                  [](auto a, auto b) {
+                                    return std::equal(a->begin(), a->end(),
+                                                      b->begin(), b->end());
+                                  }) -
+                      work.begin());
+                }));
+}
+
+template <typename T> static void run_long(const char *name, std::size_t n) {
+  utl::vector<T> a(n, T{1});
+  auto b = a;
+  b.back() = T{2};
+  char label[64];
+  std::snprintf(label, sizeof(label), "%s x%zu operator<", name, n);
+  bench::report(label, bench::measure(1000, [&] {
+                  bench::do_not_optimize(a < b);
+                }));
+  std::snprintf(label, sizeof(label), "%s x%zu std::lexicographical", name,
+                n);
+  bench::report(label, bench::measure(1000, [&] {
+                  bench::do_not_optimize(std::lexicographical_compare(
+                      a.begin(), a.end(), b.begin(), b.end()));
+                }));
+}
+
+int main(int argc, char **argv) {
+  const auto count = bench::arg_or(argc, argv, 200000);
+  run<std::int32_t>("int32", count, 16);
+  run<std::uint8_t>("uint8", count, 32);
+  run_long<std::int32_t>("int32", 100000);
+  run_long<std::uint16_t>("uint16", 100000);
+}
@@ -0,0 +1,56 @@
+#include "bench.hpp"
+
+#include <utl/concurrent_vector.hpp>
+#include <utl/vector.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+// Threads append to one shared container: a utl::vector behind a mutex or
+// a concurrent_vector. Reports total appends per second.
+struct locked_vector {
+  void push_back(std::uint64_t value) {
+    std::lock_guard<std::mutex> lock(mutex);
+    data.push_back(value);
+  }
+
+  std::mutex mutex;
+  utl::vector<std::uint64_t> data;
+};
+
+template <typename Container>
+static double run(unsigned threads, std::size_t per_thread) {
+  using clock = std::chrono::steady_clock;
+  Container c;
+  const auto start = clock::now();
+
+  utl::vector<std::thread> workers;
+  for (unsigned t = 0; t != threads; ++t)
+    workers.emplace_back([&c, per_thread] {
+      for (std::size_t i = 0; i != per_thread; ++i)
+        c.push_back(i);
+    });
+  for (auto &worker : workers)
+    worker.join();
+
+  const std::chrono::duration<double> elapsed = clock::now() - start;
+  bench::do_not_optimize(c);
+  return static_cast<double>(threads * per_thread) / elapsed.count();
+}
+
+int main(int argc, char **argv) {
+  const auto per_thread = bench::arg_or(argc, argv, 1000000);
+  const auto max_threads =
+      utl::max(std::thread::hardware_concurrency(), 2u);
+
+  std::printf("%8s %24s %24s\n", "threads", "mutex + vector (ops/s)",
+              "concurrent_vector (ops/s)");
+  for (unsigned threads = 1; threads <= max_threads; threads *= 2) {
+    const auto locked = run<locked_vector>(threads, per_thread);
+    const auto lock_free =
+        run<utl::concurrent_vector<std::uint64_t>>(threads, per_thread);
+    std::printf("%8u %24.0f %24.0f\n", threads, locked, lock_free);
+  }
+}
@@ -0,0 +1,42 @@
+#include "bench.hpp"
+
+#include <utl/deque.hpp>
+#include <utl/vector.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+
+// Appends integers one at a time, timing every push_back, and reports the
+// mean and worst-case latency and how many calls took over 100 us. vector's
+// slow calls are reallocations; a deque only ever allocates a block or
+// copies its block map.
+template <typename Container>
+static void run(const char *name, std::size_t count) {
+  using clock = std::chrono::steady_clock;
+  Container c;
+  clock::duration worst{};
+  std::size_t slow = 0;
+  const auto start = clock::now();
+  for (std::size_t i = 0; i != count; ++i) {
+    const auto before = clock::now();
+    c.push_back(i);
+    const auto elapsed = clock::now() - before;
+    worst = std::max(worst, elapsed);
+    slow += elapsed > std::chrono::microseconds(100);
+  }
+  const std::chrono::duration<double, std::nano> total = clock::now() - start;
+  bench::do_not_optimize(c.back());
+
+  const std::chrono::duration<double, std::micro> max = worst;
+  std::printf("%-32s %10.1f ns mean %12.1f us max %8zu slow\n", name,
+              total.count() / static_cast<double>(count), max.count(), slow);
+}
+
+int main(int argc, char **argv) {
+  const auto count = bench::arg_or(argc, argv, std::size_t(1) << 25);
+  run<utl::vector<std::uint64_t>>("utl::vector<uint64_t>", count);
+  run<std::deque<std::uint64_t>>("std::deque<uint64_t>", count);
+  run<utl::deque<std::uint64_t>>("utl::deque<uint64_t>", count);
+}
@@ -0,0 +1,73 @@
+#include "bench.hpp"
+
+#include <utl/vector.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+
+// Filters a vector of random values with an unpredictable predicate
+// (about half the elements go): the remove_if + erase idiom against
+// utl::erase_if and utl::erase_if_unordered. Each run restores the input
+// first; the copy is timed on its own and should be subtracted. The last
+// rows remove only 1% of the elements.
+template <typename T>
+static void run(const char *name, std::size_t count) {
+  std::mt19937_64 rng(7);
+  utl::vector<T> input(count);
+  for (auto &x : input)
+    x = static_cast<T>(rng() % 1000);
+  utl::vector<T> work;
+  const auto pred = [](T x) { return x < T(500); };
+
+  char label[64];
+  std::snprintf(label, sizeof(label), "%s copy", name);
+  bench::report(label, bench::measure(10, [&] {
+                  work = input;
+                  bench::do_not_optimize(work.data());
+                }));
+  std::snprintf(label, sizeof(label), "%s remove_if + erase", name);
+  bench::report(label, bench::measure(10, [&] {
+                  work = input;
+                  work.erase(std::remove_if(work.begin(), work.end(), pred),
+                             work.end());
+                  bench::do_not_optimize(work.size());
+                }));
+  std::snprintf(label, sizeof(label), "%s erase_if", name);
+  bench::report(label, bench::measure(10, [&] {
+                  work = input;
+                  bench::do_not_optimize(utl::erase_if(work, pred));
+                }));
+  std::snprintf(label, sizeof(label), "%s erase_if_unordered", name);
+  bench::report(label, bench::measure(10, [&] {
+                  work = input;
+                  bench::do_not_optimize(utl::erase_if_unordered(work, pred));
+                }));
+  std::snprintf(label, sizeof(label), "%s remove_if + erase, 1%%", name);
+  bench::report(label, bench::measure(10, [&] {
+                  work = input;
+                  work.erase(std::remove_if(work.begin(), work.end(),
+                                            [](T x) { return x < T(10); }),
+                             work.end());
+                  bench::do_not_optimize(work.size());
+                }));
+  std::snprintf(label, sizeof(label), "%s erase_if, 1%%", name);
+  bench::report(label, bench::measure(10, [&] {
+                  work = input;
+                  bench::do_not_optimize(
+                      utl::erase_if(work, [](T x) { return x < T(10); }));
+                }));
+  std::snprintf(label, sizeof(label), "%s erase_if_unordered, 1%%", name);
+  bench::report(label, bench::measure(10, [&] {
+                  work = input;
+                  bench::do_not_optimize(utl::erase_if_unordered(
+                      work, [](T x) { return x < T(10); }));
+                }));
+}
+
+int main(int argc, char **argv) {
+  const auto count = bench::arg_or(argc, argv, std::size_t(1) << 24);
+  run<std::int32_t>("int32", count);
+  run<float>("float", count);
+  run<std::uint64_t>("uint64", count);
+}
@@ -0,0 +1,62 @@
+#include "bench.hpp"
+
+#include <utl/flat_map.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <random>
+#include <utility>
+#include <vector>
+
+// Builds a table of random 64-bit keys and looks up a million keys in
+// it: std::map against utl::flat_map, whose search is branchless and
+// reads only the keys, and std::lower_bound over the same sorted keys.
+int main(int argc, char **argv) {
+  const auto count = bench::arg_or(argc, argv, std::size_t(1) << 20);
+  constexpr std::size_t lookups = std::size_t(1) << 20;
+  std::mt19937_64 rng(1);
+  std::vector<std::pair<std::uint64_t, std::uint64_t>> elems(count);
+  for (auto &elem : elems)
+    elem = {rng(), rng()};
+  std::vector<std::uint64_t> queries(lookups);
+  for (auto &q : queries)
+    q = elems[rng() % count].first;
+
+  bench::report("std::map build", bench::measure(3, [&] {
+                  std::map<std::uint64_t, std::uint64_t> m(elems.begin(),
+                                                           elems.end());
+                  bench::do_not_optimize(m.size());
+                }));
+  bench::report("flat_map build", bench::measure(3, [&] {
+                  utl::flat_map<std::uint64_t, std::uint64_t> m(elems.begin(),
+                                                                elems.end());
+                  bench::do_not_optimize(m.size());
+                }));
+
+  const std::map<std::uint64_t, std::uint64_t> tree(elems.begin(),
+                                                    elems.end());
+  const utl::flat_map<std::uint64_t, std::uint64_t> flat(elems.begin(),
+                                                         elems.end());
+  bench::report("std::map find", bench::measure(5, [&] {
+                  std::uint64_t sum = 0;
+                  for (const auto q : queries)
+                    sum += tree.find(q)->second;
+                  bench::do_not_optimize(sum);
+                }));
+  bench::report("std::lower_bound", bench::measure(5, [&] {
+                  const auto &keys = flat.keys();
+                  std::uint64_t sum = 0;
+                  for (const auto q : queries)
+                    sum += flat.values()[static_cast<std::size_t>(
+                        std::lower_bound(keys.begin(), keys.end(), q) -
+                        keys.begin())];
+                  bench::do_not_optimize(sum);
+                }));
+  bench::report("flat_map find", bench::measure(5, [&] {
+                  std::uint64_t sum = 0;
+                  for (const auto q : queries)
+                    sum += flat.find(q)->second;
+                  bench::do_not_optimize(sum);
+                }));
+}
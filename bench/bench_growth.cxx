@@ -0,0 +1,60 @@
+#include "bench.hpp"
+
+#include <utl/vector.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// Grows a vector of 64-bit integers one push_back at a time, once per
+// container and growth policy. Each run happens in its own process so that
+// the peak RSS figures are independent.
+template <typename Vector> static void grow(std::size_t count) {
+  using clock = std::chrono::steady_clock;
+  const auto start = clock::now();
+
+  Vector v;
+  for (std::size_t i = 0; i != count; ++i)
+    v.push_back(i);
+  bench::do_not_optimize(v.data());
+
+  const std::chrono::duration<double, std::milli> elapsed =
+      clock::now() - start;
+  rusage usage{};
+  getrusage(RUSAGE_SELF, &usage);
+  std::printf("%14.1f ms %14ld KiB %14zu KiB\n", elapsed.count(),
+              usage.ru_maxrss, v.capacity() * sizeof(v[0]) / 1024);
+}
+
+template <typename GrowthPolicy>
+using policy_vector = utl::vector<std::uint64_t, utl::allocator<std::uint64_t>,
+                                  GrowthPolicy>;
+
+template <typename Vector>
+static void run(const char *name, std::size_t count) {
+  std::printf("%-32s", name);
+  std::fflush(stdout);
+  if (const auto pid = fork()) {
+    int status;
+    waitpid(pid, &status, 0);
+  } else {
+    grow<Vector>(count);
+    std::exit(0);
+  }
+}
+
+int main(int argc, char **argv) {
+  const auto count = bench::arg_or(argc, argv, std::size_t(1) << 26);
+
+  std::printf("%-32s%17s%18s%18s\n", "push_back", "time", "peak RSS",
+              "capacity");
+  run<std::vector<std::uint64_t>>("std::vector<uint64_t>", count);
+  run<utl::vector<std::uint64_t>>("utl::vector<uint64_t>", count);
+  run<policy_vector<utl::half_growth>>("  half_growth", count);
+  run<policy_vector<utl::size_class_growth<>>>("  size_class_growth", count);
+  run<policy_vector<utl::linear_growth<>>>("  linear_growth", count);
+}
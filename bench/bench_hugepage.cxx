@@ -0,0 +1,91 @@
+#include "bench.hpp"
+
+#include <utl/hugepage_allocator.hpp>
+#include <utl/vector.hpp>
+
+#include <cstdint>
+#include <cstring>
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// Counts data TLB load misses of the calling thread, if the kernel lets us.
+class tlb_miss_counter {
+public:
+  tlb_miss_counter() noexcept {
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HW_CACHE;
+    attr.config = PERF_COUNT_HW_CACHE_DTLB |
+                  (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                  (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    m_fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+  }
+
+  ~tlb_miss_counter() {
+    if (m_fd >= 0)
+      close(m_fd);
+  }
+
+  void start() noexcept {
+    if (m_fd >= 0) {
+      ioctl(m_fd, PERF_EVENT_IOC_RESET, 0);
+      ioctl(m_fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+  }
+
+  /// Misses since start(), or -1 when counters are unavailable.
+  long long stop() noexcept {
+    long long count = -1;
+    if (m_fd >= 0) {
+      ioctl(m_fd, PERF_EVENT_IOC_DISABLE, 0);
+      if (read(m_fd, &count, sizeof(count)) != sizeof(count))
+        count = -1;
+    }
+    return count;
+  }
+
+private:
+  int m_fd;
+};
+
+template <typename Alloc>
+static void run(const char *name, std::size_t count, std::size_t lookups) {
+  utl::vector<std::uint64_t, Alloc> table(count);
+  for (std::size_t i = 0; i != count; ++i)
+    table[i] = i * 0x9e3779b97f4a7c15ull;
+
+  tlb_miss_counter counter;
+  std::uint64_t x = 88172645463325252ull, sum = 0;
+  counter.start();
+  const auto ns = bench::measure(lookups, [&] {
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    sum += table[x % count];
+  });
+  const auto misses = counter.stop();
+  bench::do_not_optimize(sum);
+
+  std::printf("%-28s %10.2f ns/lookup", name, ns);
+  if (misses >= 0)
+    std::printf(" %10.3f dTLB misses/lookup\n",
+                static_cast<double>(misses) / static_cast<double>(lookups));
+  else
+    std::printf("   (dTLB counters unavailable)\n");
+}
+
+int main(int argc, char **argv) {
+  const auto count = bench::arg_or(argc, argv, std::size_t(1) << 26);
+  const std::size_t lookups = 20000000;
+
+  run<utl::allocator<std::uint64_t>>("utl::allocator", count, lookups);
+  run<utl::hugepage_allocator<std::uint64_t>>("utl::hugepage_allocator", count,
+                                              lookups);
+}
@@ -0,0 +1,58 @@
+#include "bench.hpp"
+
+#include <utl/vector.hpp>
+
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// The input_iterator cases from src/example1.cxx at scale: k values read
+// through istream_iterator are inserted into the middle of a vector of k
+// elements. A per-element insert shifts the tail every time, O(k * n); the
+// range insert appends and rotates once.
+
+static std::string numbers(std::size_t count) {
+  std::string text;
+  for (std::size_t i = 0; i != count; ++i)
+    text += std::to_string(i) + ' ';
+  return text;
+}
+
+template <typename Vector>
+static double insert_middle(const std::string &text, std::size_t count) {
+  return bench::measure(5, [&] {
+    Vector v(count, 0);
+    std::istringstream iss(text);
+    v.insert(v.begin() + static_cast<std::ptrdiff_t>(count / 2),
+             std::istream_iterator<int>{iss}, std::istream_iterator<int>());
+    bench::do_not_optimize(v.data());
+  });
+}
+
+template <typename Vector>
+static double insert_one_by_one(const std::string &text, std::size_t count) {
+  return bench::measure(5, [&] {
+    Vector v(count, 0);
+    std::istringstream iss(text);
+    auto idx = count / 2;
+    for (std::istream_iterator<int> it{iss}, end; it != end; ++it)
+      v.insert(v.begin() + static_cast<std::ptrdiff_t>(idx++), *it);
+    bench::do_not_optimize(v.data());
+  });
+}
+
+int main(int argc, char **argv) {
+  const auto max_count = bench::arg_or(argc, argv, 100000);
+
+  for (std::size_t count = 1000; count <= max_count; count *= 10) {
+    const auto text = numbers(count);
+    std::printf("k = n = %zu\n", count);
+    bench::report("  std::vector range insert",
+                  insert_middle<std::vector<int>>(text, count));
+    bench::report("  utl::vector range insert",
+                  insert_middle<utl::vector<int>>(text, count));
+    bench::report("  utl::vector insert per element",
+                  insert_one_by_one<utl::vector<int>>(text, count));
+  }
+}
@@ -0,0 +1,55 @@
+#include "bench.hpp"
+
+#include <utl/mmap_vector.hpp>
+#include <utl/vector.hpp>
+
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+
+// Writes `count` integers to a file, then compares the time to get them
+// back: reading the file into a utl::vector against opening it as a
+// read-only mmap_vector. The mapped open costs the same at any size; the
+// sum afterwards shows what touching the pages costs.
+int main(int argc, char **argv) {
+  const auto count = bench::arg_or(argc, argv, std::size_t(1) << 24);
+  const auto dir = std::filesystem::temp_directory_path();
+  const std::string raw = (dir / "utl_bench_mmap_vector.raw").string();
+  const std::string mapped = (dir / "utl_bench_mmap_vector.vec").string();
+
+  {
+    utl::mmap_vector<std::uint64_t> out(mapped, utl::mmap_mode::truncate);
+    out.reserve(count);
+    for (std::uint64_t i = 0; i != count; ++i)
+      out.push_back(i);
+    std::FILE *f = std::fopen(raw.c_str(), "wb");
+    std::fwrite(out.data(), sizeof(std::uint64_t), count, f);
+    std::fclose(f);
+  }
+
+  bench::report("read into vector", bench::measure(10, [&] {
+                  utl::vector<std::uint64_t> v(count);
+                  std::FILE *f = std::fopen(raw.c_str(), "rb");
+                  bench::do_not_optimize(std::fread(
+                      v.data(), sizeof(std::uint64_t), count, f));
+                  std::fclose(f);
+                  bench::do_not_optimize(v.data());
+                }));
+  bench::report("open mmap_vector", bench::measure(10, [&] {
+                  utl::mmap_vector<std::uint64_t> v(
+                      mapped, utl::mmap_mode::read_only);
+                  bench::do_not_optimize(v.data());
+                }));
+  bench::report("open mmap_vector and sum", bench::measure(10, [&] {
+                  utl::mmap_vector<std::uint64_t> v(
+                      mapped, utl::mmap_mode::read_only);
+                  std::uint64_t sum = 0;
+                  for (auto x : v)
+                    sum += x;
+                  bench::do_not_optimize(sum);
+                }));
+
+  std::filesystem::remove(raw);
+  std::filesystem::remove(mapped);
+}
@@ -0,0 +1,33 @@
+#include "bench.hpp"
+
+#include <utl/execution.hpp>
+#include <utl/vector.hpp>
+
+#include <algorithm>
+#include <cstdint>
+
+// Constructs and fills a large vector serially and with utl::par. The
+// serial runs also pay for faulting in every page on one thread; the
+// parallel runs first-touch each page on the thread that fills it.
+int main(int argc, char **argv) {
+  const auto count = bench::arg_or(argc, argv, std::size_t(1) << 27);
+  std::printf("%zu threads\n", utl::parallel_concurrency());
+  bench::report("construct", bench::measure(5, [&] {
+                  utl::vector<std::uint32_t> v(count, 1u);
+                  bench::do_not_optimize(v.data());
+                }));
+  bench::report("construct par", bench::measure(5, [&] {
+                  utl::vector<std::uint32_t> v(count, 1u, utl::par);
+                  bench::do_not_optimize(v.data());
+                }));
+
+  utl::vector<std::uint32_t> v(count, 0u, utl::par);
+  bench::report("fill", bench::measure(5, [&] {
+                  std::fill(v.begin(), v.end(), 2u);
+                  bench::do_not_optimize(v.data());
+                }));
+  bench::report("fill par", bench::measure(5, [&] {
+                  utl::fill(utl::par, v.begin(), v.end(), 3u);
+                  bench::do_not_optimize(v.data());
+                }));
+}
@@ -0,0 +1,56 @@
+#include "bench.hpp"
+
+#include <utl/persistent_vector.hpp>
+#include <utl/vector.hpp>
+
+#include <cstdint>
+#include <cstdio>
+
+// Publishes a new version after each single-element update: copying a
+// utl::vector against set() on a persistent_vector, which copies only the
+// path to the element. Also times reading every element through
+// operator[] and through iterators, against the flat vector.
+int main(int argc, char **argv) {
+  const auto count = bench::arg_or(argc, argv, std::size_t(1) << 20);
+
+  utl::vector<std::uint64_t> flat(count);
+  utl::transient_vector<std::uint64_t> builder;
+  for (std::size_t i = 0; i != count; ++i)
+    builder.push_back(i);
+  auto tree = std::move(builder).persistent();
+
+  std::size_t pos = 0;
+  bench::report("vector copy + update", bench::measure(100, [&] {
+                  utl::vector<std::uint64_t> next(flat);
+                  next[pos++ % count] += 1;
+                  bench::do_not_optimize(next.data());
+                }));
+  bench::report("persistent_vector set", bench::measure(100000, [&] {
+                  auto next = tree.set(pos % count, pos);
+                  ++pos;
+                  bench::do_not_optimize(next.size());
+                }));
+  bench::report("persistent_vector push_back", bench::measure(100000, [&] {
+                  auto next = tree.push_back(pos);
+                  bench::do_not_optimize(next.size());
+                }));
+
+  bench::report("vector scan", bench::measure(20, [&] {
+                  std::uint64_t sum = 0;
+                  for (auto x : flat)
+                    sum += x;
+                  bench::do_not_optimize(sum);
+                }));
+  bench::report("persistent_vector scan", bench::measure(20, [&] {
+                  std::uint64_t sum = 0;
+                  for (auto x : tree)
+                    sum += x;
+                  bench::do_not_optimize(sum);
+                }));
+  bench::report("persistent_vector indexed scan", bench::measure(20, [&] {
+                  std::uint64_t sum = 0;
+                  for (std::size_t i = 0; i != count; ++i)
+                    sum += tree[i];
+                  bench::do_not_optimize(sum);
+                }));
+}
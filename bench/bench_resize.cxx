@@ -0,0 +1,66 @@
+#include "bench.hpp"
+
+#include <utl/string.hpp>
+#include <utl/vector.hpp>
+
+#include <cstring>
+#include <vector>
+
+// Sizes a byte buffer and fills it, as a read() or a decoder would. resize
+// zeroes the buffer first; the uninitialized variants write it only once.
+
+static std::size_t fill(char *p, std::size_t n) {
+  std::memset(p, 0x5a, n);
+  return n;
+}
+
+int main(int argc, char **argv) {
+  const auto bytes = bench::arg_or(argc, argv, std::size_t(100) << 20);
+  const std::size_t iterations = 10;
+
+  bench::report("std::vector resize + fill",
+                bench::measure(iterations, [&] {
+                  std::vector<char> v;
+                  v.resize(bytes);
+                  fill(v.data(), bytes);
+                  bench::do_not_optimize(v.data());
+                }));
+
+  bench::report("utl::vector resize + fill",
+                bench::measure(iterations, [&] {
+                  utl::vector<char> v;
+                  v.resize(bytes);
+                  fill(v.data(), bytes);
+                  bench::do_not_optimize(v.data());
+                }));
+
+  bench::report("utl::vector resize_uninitialized + fill",
+                bench::measure(iterations, [&] {
+                  utl::vector<char> v;
+                  v.resize_uninitialized(bytes);
+                  fill(v.data(), bytes);
+                  bench::do_not_optimize(v.data());
+                }));
+
+  bench::report("utl::vector resize_and_overwrite",
+                bench::measure(iterations, [&] {
+                  utl::vector<char> v;
+                  v.resize_and_overwrite(bytes, fill);
+                  bench::do_not_optimize(v.data());
+                }));
+
+  bench::report("utl::basic_string resize + fill",
+                bench::measure(iterations, [&] {
+                  utl::basic_string<char> s;
+                  s.resize(bytes);
+                  fill(s.data(), bytes);
+                  bench::do_not_optimize(s.data());
+                }));
+
+  bench::report("utl::basic_string resize_and_overwrite",
+                bench::measure(iterations, [&] {
+                  utl::basic_string<char> s;
+                  s.resize_and_overwrite(bytes, fill);
+                  bench::do_not_optimize(s.data());
+                }));
+}
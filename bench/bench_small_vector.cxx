@@ -0,0 +1,47 @@
+#include "bench.hpp"
+
+#include <utl/counting_allocator.hpp>
+#include <utl/small_vector.hpp>
+#include <utl/vector.hpp>
+
+#include <cstdint>
+
+// Builds short-lived vectors of 1..N elements, as a request handler would,
+// and reports latency and heap allocations per vector.
+
+template <typename Vector, typename Alloc>
+static void run(const char *name, std::size_t max_size,
+                std::size_t iterations) {
+  auto &site = UTL_ALLOCATION_SITE("bench_small_vector");
+  const auto before = site.stats().allocations;
+
+  std::uint32_t seed = 1;
+  const double ns = bench::measure(iterations, [&] {
+    seed = seed * 1664525 + 1013904223;
+    const std::size_t count = 1 + (seed >> 16) % max_size;
+    Vector v{Alloc(site)};
+    for (std::size_t i = 0; i != count; ++i)
+      v.push_back(static_cast<int>(i));
+    bench::do_not_optimize(v.data());
+  });
+
+  const auto allocations = site.stats().allocations - before;
+  std::printf("%-40s %14.1f ns %10.3f allocations\n", name, ns,
+              static_cast<double>(allocations) /
+                  static_cast<double>(iterations));
+}
+
+template <std::size_t N> static void compare(std::size_t iterations) {
+  using alloc = utl::counting_allocator<int>;
+  std::printf("N = %zu\n", N);
+  run<utl::vector<int, alloc>, alloc>("  utl::vector", N, iterations);
+  run<utl::small_vector<int, N, alloc>, alloc>("  utl::small_vector", N,
+                                               iterations);
+}
+
+int main(int argc, char **argv) {
+  const auto iterations = bench::arg_or(argc, argv, 1000000);
+  compare<4>(iterations);
+  compare<8>(iterations);
+  compare<16>(iterations);
+}
@@ -0,0 +1,44 @@
+#include "bench.hpp"
+
+#include <utl/soa_vector.hpp>
+#include <utl/vector.hpp>
+
+#include <array>
+#include <cstdint>
+
+// Sums one field of a million 64-byte records, stored as an array of
+// structs and as a soa_vector.
+struct record {
+  std::uint64_t id;
+  double price;
+  char payload[48];
+};
+
+int main(int argc, char **argv) {
+  const auto count = bench::arg_or(argc, argv, 1000000);
+
+  utl::vector<record> aos;
+  utl::soa_vector<std::uint64_t, double, std::array<char, 48>> soa;
+  aos.reserve(count);
+  soa.reserve(count);
+  for (std::size_t i = 0; i != count; ++i) {
+    aos.push_back(record{i, i * 0.25, {}});
+    soa.emplace_back(i, i * 0.25, std::array<char, 48>{});
+  }
+
+  const double aos_ns = bench::measure(20, [&] {
+    double sum = 0;
+    for (const auto &r : aos)
+      sum += r.price;
+    bench::do_not_optimize(sum);
+  });
+  const double soa_ns = bench::measure(20, [&] {
+    double sum = 0;
+    for (const double price : soa.column<1>())
+      sum += price;
+    bench::do_not_optimize(sum);
+  });
+
+  bench::report("vector<record>: sum price", aos_ns);
+  bench::report("soa_vector: sum price column", soa_ns);
+}
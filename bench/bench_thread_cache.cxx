@@ -0,0 +1,48 @@
+#include "bench.hpp"
+
+#include <utl/thread_cache.hpp>
+#include <utl/vector.hpp>
+
+#include <chrono>
+#include <thread>
+
+// Every thread repeatedly grows a fresh vector through several
+// reallocations and then drops it.
+template <typename Alloc> static void churn(std::size_t rounds) {
+  for (std::size_t i = 0; i != rounds; ++i) {
+    utl::vector<int, Alloc> v;
+    for (int j = 0; j != 256; ++j)
+      v.push_back(j);
+    bench::do_not_optimize(v.data());
+    v.clear();
+  }
+}
+
+template <typename Alloc>
+static double run(unsigned threads, std::size_t rounds) {
+  using clock = std::chrono::steady_clock;
+  const auto start = clock::now();
+
+  utl::vector<std::thread> workers;
+  for (unsigned i = 0; i != threads; ++i)
+    workers.emplace_back([rounds] { churn<Alloc>(rounds); });
+  for (auto &worker : workers)
+    worker.join();
+
+  const std::chrono::duration<double> elapsed = clock::now() - start;
+  return static_cast<double>(threads * rounds) / elapsed.count();
+}
+
+int main(int argc, char **argv) {
+  const auto rounds = bench::arg_or(argc, argv, 20000);
+  const auto max_threads =
+      utl::max(std::thread::hardware_concurrency(), 2u);
+
+  std::printf("%8s %24s %24s\n", "threads", "utl::allocator (rounds/s)",
+              "thread_cache (rounds/s)");
+  for (unsigned threads = 1; threads <= max_threads; threads *= 2) {
+    const auto heap = run<utl::allocator<int>>(threads, rounds);
+    const auto cached = run<utl::thread_cache_allocator<int>>(threads, rounds);
+    std::printf("%8u %24.0f %24.0f\n", threads, heap, cached);
+  }
+}
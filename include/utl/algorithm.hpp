@@ -1,8 +1,19 @@
 #pragma once
 #include <utl/iterator.hpp>
 
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <type_traits>
 
+#if defined(__SSE2__) && defined(__GNUC__)
+#include <emmintrin.h>
+#endif
+#if defined(__AVX2__) && defined(__GNUC__)
+#include <immintrin.h>
+#endif
+
 namespace utl {
 
 template <typename T1, typename T2>
@@ -84,4 +95,202 @@ inline void for_each(InputIterator first, InputIterator last,
       typename std::iterator_traits<InputIterator>::iterator_category());
 }
 
+namespace detail {
+
+/// Types whose values are equal exactly when their object representations
+/// are: integers, enumerations (std::byte among them) and pointers, but not
+/// floating point (NaN, signed zero) or classes (padding).
+template <typename T>
+constexpr bool is_bitwise_comparable_v =
+    std::is_integral_v<T> || std::is_enum_v<T> || std::is_pointer_v<T>;
+
+/// Types that memcmp also orders correctly: unsigned single bytes.
+template <typename T>
+constexpr bool is_bytewise_ordered_v =
+    sizeof(T) == 1 && (std::is_same_v<T, bool> || std::is_same_v<T, std::byte> ||
+                       (std::is_integral_v<T> && std::is_unsigned_v<T>));
+
+/// Offset of the first byte where `a` and `b` differ, or `num` if they are
+/// equal. Compares 32 or 16 bytes per step where AVX2 or SSE2 are enabled.
+inline size_t mismatch_bytes(const unsigned char *a, const unsigned char *b,
+                             size_t num) noexcept {
+  size_t i = 0;
+#if defined(__AVX2__) && defined(__GNUC__)
+  for (; i + 32 <= num; i += 32) {
+    const auto x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i));
+    const auto y = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + i));
+    const auto eq = static_cast<std::uint32_t>(
+        _mm256_movemask_epi8(_mm256_cmpeq_epi8(x, y)));
+    if (eq != 0xffffffffu)
+      return i + static_cast<size_t>(__builtin_ctz(~eq));
+  }
+#endif
+#if defined(__SSE2__) && defined(__GNUC__)
+  for (; i + 16 <= num; i += 16) {
+    const auto x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i));
+    const auto y = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i));
+    const auto eq =
+        static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(x, y)));
+    if (eq != 0xffffu)
+      return i + static_cast<size_t>(__builtin_ctz(~eq));
+  }
+#endif
+  for (; i + 8 <= num; i += 8) {
+    std::uint64_t x, y;
+    std::memcpy(&x, a + i, 8);
+    std::memcpy(&y, b + i, 8);
+    if (x != y)
+      break;
+  }
+  for (; i != num; ++i)
+    if (a[i] != b[i])
+      return i;
+  return num;
+}
+
+/// Copies the elements of `src` whose `keep` byte is non-zero to `dst`,
+/// preserving their order, and returns how many were copied. Elements are
+/// `elem_size` bytes, 4 or 8; `dst` may alias `src` if it does not come
+/// after it. Uses AVX-512 or AVX2 when the CPU has them.
+size_t compress_store(void *dst, const void *src, const unsigned char *keep,
+                      size_t num, size_t elem_size) noexcept;
+
+/// Moves the elements of [first, first + num) that do not satisfy `pred`
+/// to the front and returns how many there are. Arithmetic elements of 4
+/// or 8 bytes are tested a block at a time and compacted with
+/// compress_store; other trivially copyable ones are copied without
+/// branching. The rest go through std::remove_if.
+template <typename Tp, typename Predicate>
+size_t remove_if_compact(Tp *first, size_t num, Predicate &pred) {
+  if constexpr (std::is_arithmetic_v<Tp> &&
+                (sizeof(Tp) == 4 || sizeof(Tp) == 8)) {
+    constexpr size_t block = 1024;
+    unsigned char keep[block];
+    size_t kept = 0;
+    for (size_t i = 0; i < num; i += block) {
+      const size_t count = num - i < block ? num - i : block;
+      for (size_t j = 0; j != count; ++j)
+        keep[j] = !pred(first[i + j]);
+      kept += compress_store(first + kept, first + i, keep, count, sizeof(Tp));
+    }
+    return kept;
+  } else if constexpr (std::is_trivially_copyable_v<Tp> && sizeof(Tp) <= 16) {
+    size_t kept = 0;
+    for (size_t i = 0; i != num; ++i) {
+      const Tp value = first[i];
+      first[kept] = value;
+      kept += !pred(value);
+    }
+    return kept;
+  } else {
+    return static_cast<size_t>(std::remove_if(first, first + num, pred) -
+                               first);
+  }
+}
+
+} // namespace detail
+
+template <typename InputIterator1, typename InputIterator2>
+inline bool equal(InputIterator1 first1, InputIterator1 last1,
+                  InputIterator2 first2) {
+  for (; first1 != last1; ++first1, ++first2)
+    if (!(*first1 == *first2))
+      return false;
+  return true;
+}
+
+/// Contiguous ranges of bitwise comparable elements are compared with
+/// memcmp.
+template <typename Tp>
+inline bool equal(const Tp *first1, const Tp *last1, const Tp *first2) {
+  if constexpr (detail::is_bitwise_comparable_v<Tp>) {
+    const auto num = static_cast<size_t>(last1 - first1);
+    return num == 0 || std::memcmp(first1, first2, num * sizeof(Tp)) == 0;
+  } else {
+    for (; first1 != last1; ++first1, ++first2)
+      if (!(*first1 == *first2))
+        return false;
+    return true;
+  }
+}
+
+template <typename InputIterator1, typename InputIterator2>
+inline bool lexicographical_compare(InputIterator1 first1,
+                                    InputIterator1 last1,
+                                    InputIterator2 first2,
+                                    InputIterator2 last2) {
+  for (; first1 != last1 && first2 != last2; ++first1, ++first2) {
+    if (*first1 < *first2)
+      return true;
+    if (*first2 < *first1)
+      return false;
+  }
+  return first1 == last1 && first2 != last2;
+}
+
+/// Contiguous ranges of unsigned bytes are ordered by memcmp. For other
+/// integers the first differing element is located bytewise and compared
+/// on its own.
+template <typename Tp>
+inline bool lexicographical_compare(const Tp *first1, const Tp *last1,
+                                    const Tp *first2, const Tp *last2) {
+  const auto num1 = static_cast<size_t>(last1 - first1);
+  const auto num2 = static_cast<size_t>(last2 - first2);
+  const size_t num = num1 < num2 ? num1 : num2;
+  if constexpr (detail::is_bytewise_ordered_v<Tp>) {
+    const int cmp = num ? std::memcmp(first1, first2, num) : 0;
+    return cmp ? cmp < 0 : num1 < num2;
+  } else if constexpr (detail::is_bitwise_comparable_v<Tp> &&
+                       !std::is_pointer_v<Tp>) {
+    const size_t idx =
+        detail::mismatch_bytes(reinterpret_cast<const unsigned char *>(first1),
+                               reinterpret_cast<const unsigned char *>(first2),
+                               num * sizeof(Tp)) /
+        sizeof(Tp);
+    return idx != num ? first1[idx] < first2[idx] : num1 < num2;
+  } else {
+    for (size_t i = 0; i != num; ++i) {
+      if (first1[i] < first2[i])
+        return true;
+      if (first2[i] < first1[i])
+        return false;
+    }
+    return num1 < num2;
+  }
+}
+
+/// Like std::lower_bound, without a data-dependent branch: each step
+/// halves the range with a conditional move, so lookups in large sorted
+/// tables do not pay for mispredicted comparisons.
+template <typename RandomAccessIterator, typename Tp, typename Compare>
+inline RandomAccessIterator lower_bound(RandomAccessIterator first,
+                                        RandomAccessIterator last,
+                                        const Tp &value, Compare comp) {
+  auto len = last - first;
+  if (len == 0)
+    return first;
+  while (len > 1) {
+    const auto half = len / 2;
+    first += comp(first[half], value) ? half : 0;
+    len -= half;
+  }
+  return first + static_cast<decltype(len)>(comp(*first, value));
+}
+
+/// Like std::upper_bound, without a data-dependent branch.
+template <typename RandomAccessIterator, typename Tp, typename Compare>
+inline RandomAccessIterator upper_bound(RandomAccessIterator first,
+                                        RandomAccessIterator last,
+                                        const Tp &value, Compare comp) {
+  auto len = last - first;
+  if (len == 0)
+    return first;
+  while (len > 1) {
+    const auto half = len / 2;
+    first += comp(value, first[half]) ? 0 : half;
+    len -= half;
+  }
+  return first + static_cast<decltype(len)>(!comp(value, *first));
+}
+
 } // namespace utl
@@ -1,11 +1,83 @@
 #pragma once
 #include <utl/config.hpp>
 
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <new>
 #include <type_traits>
 
 namespace utl {
+
+template <typename Pointer, typename SizeType = size_t>
+struct allocation_result {
+  Pointer ptr;
+  SizeType count;
+};
+
+namespace detail {
+
+constexpr size_t page_size = 4096;
+
+/// Blocks of at least this many bytes are mapped directly from the OS, so
+/// they can later be grown with remap_pages.
+constexpr size_t mmap_threshold = size_t(1) << 20;
+
+/// Bytes the heap really sets aside for a request of `bytes`: whole
+/// allocation granules for small blocks, whole pages for large ones.
+constexpr size_t allocation_size(size_t bytes) noexcept {
+  constexpr size_t granule = alignof(std::max_align_t);
+  constexpr size_t page_threshold = 128 * 1024;
+
+  if (bytes > size_t(-1) - page_size)
+    return bytes;
+  if (bytes >= page_threshold)
+    return (bytes + page_size - 1) & ~(page_size - 1);
+  return (bytes + granule - 1) & ~(granule - 1);
+}
+
+/// Anonymous page mappings; sizes are multiples of page_size.
+void *map_pages(size_t bytes) noexcept;
+void unmap_pages(void *p, size_t bytes) noexcept;
+
+/// Grows a mapping without moving it.
+bool expand_pages(void *p, size_t bytes, size_t new_bytes) noexcept;
+
+/// Grows a mapping, moving its pages elsewhere if needed. The contents are
+/// carried over by the page tables, not copied. Returns nullptr on failure,
+/// leaving the old mapping intact.
+void *remap_pages(void *p, size_t bytes, size_t new_bytes) noexcept;
+
+template <typename Alloc, typename = void>
+struct has_allocate_at_least : std::false_type {};
+
+template <typename Alloc, typename = void>
+struct has_try_expand : std::false_type {};
+
+template <typename Alloc>
+struct has_try_expand<Alloc, std::void_t<decltype(std::declval<Alloc &>().try_expand(
+                                 std::declval<typename Alloc::value_type *>(),
+                                 std::declval<size_t>(),
+                                 std::declval<size_t>()))>> : std::true_type {};
+
+template <typename Alloc, typename = void>
+struct has_try_reallocate : std::false_type {};
+
+template <typename Alloc>
+struct has_try_reallocate<
+    Alloc, std::void_t<decltype(std::declval<Alloc &>().try_reallocate(
+               std::declval<typename Alloc::value_type *>(),
+               std::declval<size_t>(), std::declval<size_t>()))>>
+    : std::true_type {};
+
+template <typename Alloc>
+struct has_allocate_at_least<
+    Alloc, std::void_t<decltype(std::declval<Alloc &>().allocate_at_least(
+               std::declval<size_t>()))>> : std::true_type {};
+
+} // namespace detail
+
 template <typename T> class allocator {
 public:
   using value_type = T;
@@ -18,14 +90,64 @@ public:
   allocator &operator=(const allocator &) noexcept = default;
 
   T *allocate(size_t n) {
-    auto ret = operator new[](
-        n * sizeof(T), static_cast<std::align_val_t>(alignof(T)), std::nothrow);
+    if (n > size_t(-1) / sizeof(T))
+      UTL_THROW(std::bad_alloc());
+
+    const size_t bytes = detail::allocation_size(n * sizeof(T));
+    void *ret;
+    if (mapped(bytes))
+      ret = detail::map_pages(bytes);
+    else
+      ret = operator new[](n * sizeof(T),
+                           static_cast<std::align_val_t>(alignof(T)),
+                           std::nothrow);
     if (!ret)
       UTL_THROW(std::bad_alloc());
     return reinterpret_cast<T *>(ret);
   }
-  void deallocate(T *p, [[maybe_unused]] size_t sz) {
-    operator delete[](p, static_cast<std::align_val_t>(alignof(T)));
+  allocation_result<T *> allocate_at_least(size_t n) {
+    if (n > (size_t(-1) >> 1) / sizeof(T))
+      return {allocate(n), n};
+    const size_t count = detail::allocation_size(n * sizeof(T)) / sizeof(T);
+    return {allocate(count), count};
+  }
+  void deallocate(T *p, size_t sz) {
+    const size_t bytes = detail::allocation_size(sz * sizeof(T));
+    if (mapped(bytes))
+      detail::unmap_pages(p, bytes);
+    else
+      operator delete[](p, static_cast<std::align_val_t>(alignof(T)));
+  }
+
+  /// Grows the block `p`, obtained for `n` objects, to hold at least `new_n`
+  /// objects without moving it. Returns the new capacity, or 0 if the block
+  /// cannot grow in place.
+  size_t try_expand(T *p, size_t n, size_t new_n) noexcept {
+    const size_t bytes = detail::allocation_size(n * sizeof(T));
+    if (!UTL_HAS_MREMAP || !mapped(bytes) || new_n <= n ||
+        new_n > size_t(-1) / sizeof(T))
+      return 0;
+
+    const size_t new_bytes = detail::allocation_size(new_n * sizeof(T));
+    if (!detail::expand_pages(p, bytes, new_bytes))
+      return 0;
+    return new_bytes / sizeof(T);
+  }
+
+  /// Like try_expand, but the block may move. Only for types that can be
+  /// relocated with memcpy. On failure returns {nullptr, 0} and `p` is
+  /// still valid.
+  allocation_result<T *> try_reallocate(T *p, size_t n, size_t new_n) noexcept {
+    const size_t bytes = detail::allocation_size(n * sizeof(T));
+    if (!UTL_HAS_MREMAP || !mapped(bytes) || new_n <= n ||
+        new_n > size_t(-1) / sizeof(T))
+      return {nullptr, 0};
+
+    const size_t new_bytes = detail::allocation_size(new_n * sizeof(T));
+    const auto ret = detail::remap_pages(p, bytes, new_bytes);
+    if (!ret)
+      return {nullptr, 0};
+    return {reinterpret_cast<T *>(ret), new_bytes / sizeof(T)};
   }
 
   friend constexpr bool operator==(const allocator &,
@@ -36,7 +158,285 @@ public:
                                    const allocator &) noexcept {
     return false;
   }
+
+private:
+  static constexpr bool mapped(size_t bytes) noexcept {
+    return UTL_HAS_MMAP && alignof(T) <= detail::page_size &&
+           bytes >= detail::mmap_threshold;
+  }
+};
+
+namespace detail {
+
+/// Where a fixed_pool gets its slabs. The default, with null functions, is
+/// the global aligned operator new.
+struct slab_source {
+  void *(*allocate)(void *context, size_t bytes, size_t align) = nullptr;
+  void (*deallocate)(void *context, void *p, size_t bytes,
+                     size_t align) noexcept = nullptr;
+  void *context = nullptr;
+};
+
+/// Free-list allocator for blocks of one size, carved from page-sized slabs.
+///
+/// Allocation and deallocate() are not thread-safe; pool_allocator keeps one
+/// pool per thread. Other threads hand blocks back with deallocate_remote(),
+/// which pushes them onto a lock-free inbox that the owner drains once its
+/// own free list runs dry. Slabs from the default source are aligned to their
+/// size and record their pool, so owner_of() finds the pool of any block.
+class fixed_pool {
+public:
+  static constexpr size_t slab_size = 4096;
+
+  fixed_pool(size_t block_size, size_t block_align,
+             slab_source source = slab_source()) noexcept;
+
+  fixed_pool(const fixed_pool &) = delete;
+  fixed_pool &operator=(const fixed_pool &) = delete;
+
+  ~fixed_pool();
+
+  void *allocate() {
+    ++m_live;
+    if (!m_free && m_inbox.load(std::memory_order_relaxed))
+      m_free = m_inbox.exchange(nullptr, std::memory_order_acquire);
+    if (m_free) {
+      auto block = m_free;
+      m_free = block->next;
+      return block;
+    }
+    if (m_bump != m_bump_end) {
+      auto block = m_bump;
+      m_bump += m_block_size;
+      return block;
+    }
+    return allocate_slab();
+  }
+
+  void deallocate(void *p) noexcept {
+    --m_live;
+    auto block = static_cast<free_block *>(p);
+    block->next = m_free;
+    m_free = block;
+  }
+
+  /// Returns a block from a thread other than the owner's. Returns true if
+  /// the pool was abandoned and this was its last block, in which case the
+  /// caller deletes it.
+  bool deallocate_remote(void *p) noexcept {
+    auto block = static_cast<free_block *>(p);
+    block->next = m_inbox.load(std::memory_order_relaxed);
+    while (!m_inbox.compare_exchange_weak(block->next, block,
+                                          std::memory_order_release,
+                                          std::memory_order_relaxed))
+      ;
+    return m_remote_live.fetch_sub(1, std::memory_order_acq_rel) == 1;
+  }
+
+  /// Called by the owner before it stops using the pool. Returns true if no
+  /// blocks are in use, in which case the caller deletes it; otherwise the
+  /// last deallocate_remote() does.
+  bool abandon() noexcept {
+    const auto left =
+        m_remote_live.fetch_add(m_live, std::memory_order_acq_rel) + m_live;
+    m_live = 0;
+    return left == 0;
+  }
+
+  size_t block_size() const noexcept { return m_block_size; }
+
+  /// Frees every slab, including blocks that are still allocated.
+  void release() noexcept;
+
+  /// Size of the slabs a pool for these blocks uses: a power of two holding
+  /// the header and at least eight blocks.
+  static constexpr size_t slab_bytes(size_t block_size,
+                                     size_t block_align) noexcept {
+    const auto align = block_align < alignof(free_block) ? alignof(free_block)
+                                                         : block_align;
+    const auto size = round_up(
+        block_size < sizeof(free_block) ? sizeof(free_block) : block_size,
+        align);
+    const auto min = round_up(sizeof(slab_header), align) + 8 * size;
+    auto bytes = slab_size;
+    while (bytes < min)
+      bytes *= 2;
+    return bytes;
+  }
+
+  /// The pool that allocated `p`, which must come from a pool using the
+  /// default slab source with slabs of `slab_bytes`.
+  static fixed_pool *owner_of(const void *p, size_t slab_bytes) noexcept {
+    const auto addr = reinterpret_cast<std::uintptr_t>(p);
+    return reinterpret_cast<const slab_header *>(addr & ~(slab_bytes - 1))
+        ->owner;
+  }
+
+private:
+  struct free_block {
+    free_block *next;
+  };
+
+  struct slab_header {
+    slab_header *next;
+    fixed_pool *owner;
+  };
+
+  static constexpr size_t round_up(size_t n, size_t align) noexcept {
+    return (n + align - 1) / align * align;
+  }
+
+  void *allocate_slab();
+
+  free_block *m_free = nullptr;
+  std::byte *m_bump = nullptr;
+  std::byte *m_bump_end = nullptr;
+  slab_header *m_slabs = nullptr;
+  std::ptrdiff_t m_live = 0;
+  size_t m_block_size;
+  size_t m_block_align;
+  size_t m_slab_size;
+  slab_source m_source;
+  std::atomic<free_block *> m_inbox{nullptr};
+  /// Blocks still out once the pool is abandoned; before that, minus the
+  /// number of remote deallocations.
+  std::atomic<std::ptrdiff_t> m_remote_live{0};
+};
+
+/// Owns a thread's fixed_pool for one block type and abandons it when the
+/// thread exits. `slot` is the thread's pointer to the pool, which is reset
+/// first so that later deallocations on this thread take the remote path.
+class thread_pool_handle {
+public:
+  thread_pool_handle(fixed_pool *&slot, size_t block_size, size_t block_align)
+      : m_slot(slot) {
+    m_slot = new fixed_pool(block_size, block_align);
+  }
+
+  thread_pool_handle(const thread_pool_handle &) = delete;
+  thread_pool_handle &operator=(const thread_pool_handle &) = delete;
+
+  ~thread_pool_handle() {
+    const auto pool = m_slot;
+    m_slot = nullptr;
+    if (pool->abandon())
+      delete pool;
+  }
+
+private:
+  fixed_pool *&m_slot;
+};
+
+} // namespace detail
+
+/// Allocator for node-based containers.
+///
+/// Single objects come from a per-thread, per-type fixed_pool, so allocation
+/// is a free-list pop with no locking and consecutive nodes share pages.
+/// Rebinding creates a separate pool for the new type. Arrays are forwarded
+/// to utl::allocator.
+///
+/// Memory may be deallocated on any thread: blocks from another thread's
+/// pool go back to that pool's inbox. A thread's pool is freed when it exits,
+/// or once its last outstanding block comes back if some are still in use.
+template <typename T> class pool_allocator {
+  static constexpr size_t slab_bytes =
+      detail::fixed_pool::slab_bytes(sizeof(T), alignof(T));
+
+public:
+  using value_type = T;
+  using propagate_on_container_move_assignment = std::true_type;
+  using is_always_equal = std::true_type;
+  pool_allocator() noexcept = default;
+  pool_allocator(const pool_allocator &) noexcept = default;
+  template <class U> pool_allocator(const pool_allocator<U> &) noexcept {}
+  ~pool_allocator() = default;
+  pool_allocator &operator=(const pool_allocator &) noexcept = default;
+
+  T *allocate(size_t n) {
+    if (n == 1)
+      return static_cast<T *>(pool().allocate());
+    return allocator<T>().allocate(n);
+  }
+
+  void deallocate(T *p, size_t n) noexcept {
+    if (n != 1) {
+      allocator<T>().deallocate(p, n);
+      return;
+    }
+    const auto owner = detail::fixed_pool::owner_of(p, slab_bytes);
+    if (owner == local_pool())
+      owner->deallocate(p);
+    else if (owner->deallocate_remote(p))
+      delete owner;
+  }
+
+  /// This thread's pool, created on first use.
+  static detail::fixed_pool &pool() {
+    thread_local detail::thread_pool_handle handle(local_pool(), sizeof(T),
+                                                   alignof(T));
+    return *local_pool();
+  }
+
+  friend constexpr bool operator==(const pool_allocator &,
+                                   const pool_allocator &) noexcept {
+    return true;
+  }
+  friend constexpr bool operator!=(const pool_allocator &,
+                                   const pool_allocator &) noexcept {
+    return false;
+  }
+
+private:
+  static detail::fixed_pool *&local_pool() noexcept {
+    thread_local detail::fixed_pool *p = nullptr;
+    return p;
+  }
 };
 
 using std::allocator_traits;
+
+/// Allocates room for at least `n` objects and reports how many fit, using
+/// Alloc::allocate_at_least when the allocator provides it.
+template <typename Alloc>
+allocation_result<typename allocator_traits<Alloc>::pointer,
+                  typename allocator_traits<Alloc>::size_type>
+allocate_at_least(Alloc &alloc, typename allocator_traits<Alloc>::size_type n) {
+  if constexpr (detail::has_allocate_at_least<Alloc>::value) {
+    const auto result = alloc.allocate_at_least(n);
+    return {result.ptr, result.count};
+  } else {
+    return {allocator_traits<Alloc>::allocate(alloc, n), n};
+  }
+}
+
+/// Grows a block in place through Alloc::try_expand. Returns the new
+/// capacity, or 0 if the allocator cannot do it.
+template <typename Alloc>
+typename allocator_traits<Alloc>::size_type
+try_expand(Alloc &alloc, typename allocator_traits<Alloc>::pointer p,
+           typename allocator_traits<Alloc>::size_type n,
+           typename allocator_traits<Alloc>::size_type new_n) noexcept {
+  if constexpr (detail::has_try_expand<Alloc>::value)
+    return alloc.try_expand(p, n, new_n);
+  else
+    return 0;
+}
+
+/// Grows a block through Alloc::try_reallocate, which may move it without
+/// running constructors. Returns {nullptr, 0} if the allocator cannot do it.
+template <typename Alloc>
+allocation_result<typename allocator_traits<Alloc>::pointer,
+                  typename allocator_traits<Alloc>::size_type>
+try_reallocate(Alloc &alloc, typename allocator_traits<Alloc>::pointer p,
+               typename allocator_traits<Alloc>::size_type n,
+               typename allocator_traits<Alloc>::size_type new_n) noexcept {
+  if constexpr (detail::has_try_reallocate<Alloc>::value) {
+    const auto result = alloc.try_reallocate(p, n, new_n);
+    return {result.ptr, result.count};
+  } else {
+    return {nullptr, 0};
+  }
+}
+
 } // namespace utl
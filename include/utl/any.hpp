@@ -1,6 +1,8 @@
 #pragma once
 #include <typeinfo>
+#include <utl/allocator.hpp>
 #include <utl/config.hpp>
+#include <utl/type_traits.hpp>
 #include <utl/unique_ptr.hpp>
 
 namespace utl {
@@ -19,20 +21,74 @@ class any {
 
     virtual const std::type_info &type() const noexcept = 0;
 
-    virtual ~Value() = default;
+    /// Destroys the value and frees its storage.
+    virtual void destroy() noexcept = 0;
+
+  protected:
+    ~Value() = default;
+  };
+
+  struct value_delete {
+    void operator()(Value *x) const noexcept { x->destroy(); }
   };
 
-  template <typename T> struct ValueImpl : Value {
+  template <typename T> struct ValueHolder : Value {
     T m_data;
 
     template <typename... Args>
-    ValueImpl(Args &&... args) : m_data(std::forward<Args>(args)...) {}
-
-    Value *clone() const final { return new ValueImpl(m_data); }
+    ValueHolder(Args &&... args) : m_data(std::forward<Args>(args)...) {}
 
     const std::type_info &type() const noexcept final { return typeid(T); }
   };
 
+  template <typename T> struct ValueImpl final : ValueHolder<T> {
+    using ValueHolder<T>::ValueHolder;
+
+    Value *clone() const override { return new ValueImpl(this->m_data); }
+
+    void destroy() noexcept override { delete this; }
+  };
+
+  /// A value whose storage comes from `Alloc`, rebound to this type.
+  template <typename T, typename Alloc>
+  struct AllocValueImpl final : ValueHolder<T> {
+    using alloc_type = typename allocator_traits<
+        Alloc>::template rebind_alloc<AllocValueImpl>;
+    using alloc_traits = allocator_traits<alloc_type>;
+
+    alloc_type m_alloc;
+
+    template <typename... Args>
+    AllocValueImpl(const alloc_type &alloc, Args &&... args)
+        : ValueHolder<T>(std::forward<Args>(args)...), m_alloc(alloc) {}
+
+    template <typename... Args>
+    static AllocValueImpl *create(alloc_type a, Args &&... args) {
+      const auto p = alloc_traits::allocate(a, 1);
+      UTL_TRY {
+        ::new (static_cast<void *>(p))
+            AllocValueImpl(a, std::forward<Args>(args)...);
+      }
+      UTL_CATCH(...) {
+        alloc_traits::deallocate(a, p, 1);
+        UTL_RETHROW;
+      }
+      return p;
+    }
+
+    Value *clone() const override {
+      return create(
+          alloc_traits::select_on_container_copy_construction(m_alloc),
+          this->m_data);
+    }
+
+    void destroy() noexcept override {
+      alloc_type a(std::move(m_alloc));
+      this->~AllocValueImpl();
+      alloc_traits::deallocate(a, this, 1);
+    }
+  };
+
 public:
   constexpr any() noexcept = default;
 
@@ -40,10 +96,17 @@ public:
             typename = std::enable_if_t<!std::is_same_v<std::decay_t<T>, any>>>
   any(T &&x) : m_value(new ValueImpl<std::decay_t<T>>(std::forward<T>(x))) {}
 
+  /// Stores `x` in memory obtained from `alloc`. Copies of the any reuse a
+  /// copy of the allocator.
+  template <typename Alloc, typename T>
+  any(std::allocator_arg_t, const Alloc &alloc, T &&x)
+      : m_value(AllocValueImpl<std::decay_t<T>, Alloc>::create(
+            alloc, std::forward<T>(x))) {}
+
   template <typename T,
             typename = std::enable_if_t<!std::is_same_v<std::decay_t<T>, any>>>
   any &operator=(T &&x) {
-    m_value = make_unique<ValueImpl<std::decay_t<T>>>(std::forward<T>(x));
+    m_value.reset(new ValueImpl<std::decay_t<T>>(std::forward<T>(x)));
     return *this;
   }
 
@@ -61,13 +124,13 @@ public:
 
   template <typename T> T *get() noexcept {
     if (typeid(T) == type())
-      return &static_cast<ValueImpl<T> *>(m_value.get())->m_data;
+      return &static_cast<ValueHolder<T> *>(m_value.get())->m_data;
     return nullptr;
   }
 
   template <typename T> const T *get() const noexcept {
     if (typeid(T) == type())
-      return &static_cast<ValueImpl<std::decay_t<T>> *>(m_value.get())->m_data;
+      return &static_cast<const ValueHolder<std::decay_t<T>> *>(m_value.get())->m_data;
     return nullptr;
   }
 
@@ -76,9 +139,11 @@ public:
   bool empty() const noexcept { return m_value == nullptr; }
 
 private:
-  utl::unique_ptr<Value> m_value;
+  utl::unique_ptr<Value, value_delete> m_value;
 };
 
+template <> struct is_trivially_relocatable<any> : std::true_type {};
+
 template <typename Tp, bool IsPtr = std::is_pointer_v<Tp>>
 Tp any_cast(const any &a) noexcept(IsPtr) {
   using T = std::remove_pointer_t<Tp>;
@@ -0,0 +1,138 @@
+#pragma once
+#include <utl/allocator.hpp>
+#include <utl/config.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+
+namespace utl {
+
+/// A monotonic (bump pointer) arena.
+///
+/// Memory is carved from large blocks obtained from the global operator new
+/// and is only given back in bulk, by reset() or release(). deallocate() is a
+/// no-op except for the most recent allocation, which is rolled back so that a
+/// container growing at the top of the arena can reuse its own space.
+class arena {
+public:
+  static constexpr size_t default_block_size = 64 * 1024;
+  static constexpr size_t max_block_size = 16 * 1024 * 1024;
+
+  explicit arena(size_t block_size = default_block_size) noexcept
+      : m_next_block_size(block_size < min_block_size ? min_block_size
+                                                      : block_size) {}
+
+  arena(const arena &) = delete;
+  arena &operator=(const arena &) = delete;
+
+  ~arena() { release(); }
+
+  void *allocate(size_t bytes, size_t align = alignof(std::max_align_t)) {
+    const auto cur = reinterpret_cast<std::uintptr_t>(m_cur);
+    const auto end = reinterpret_cast<std::uintptr_t>(m_end);
+    const auto aligned = (cur + (align - 1)) & ~std::uintptr_t(align - 1);
+
+    if (m_cur && aligned >= cur && aligned <= end && bytes <= end - aligned) {
+      m_cur = reinterpret_cast<std::byte *>(aligned + bytes);
+      return reinterpret_cast<void *>(aligned);
+    }
+    return allocate_slow(bytes, align);
+  }
+
+  void deallocate(void *p, size_t bytes) noexcept {
+    if (static_cast<std::byte *>(p) + bytes == m_cur)
+      m_cur = static_cast<std::byte *>(p);
+  }
+
+  /// Frees every allocation at once. The most recent block is kept so that
+  /// an arena reused per request does not go back to the heap every time.
+  void reset() noexcept;
+
+  /// Frees every allocation and gives all blocks back to the heap.
+  void release() noexcept;
+
+  /// Bytes obtained from the heap and currently owned by the arena.
+  size_t bytes_reserved() const noexcept { return m_reserved; }
+
+  /// Bytes left in the current block.
+  size_t bytes_available() const noexcept {
+    return static_cast<size_t>(m_end - m_cur);
+  }
+
+private:
+  struct block_header {
+    block_header *next;
+    size_t size;
+  };
+
+  static constexpr size_t min_block_size = 4 * sizeof(block_header);
+
+  void *allocate_slow(size_t bytes, size_t align);
+
+  static std::byte *block_begin(block_header *block) noexcept {
+    return reinterpret_cast<std::byte *>(block + 1);
+  }
+
+  static std::byte *block_end(block_header *block) noexcept {
+    return reinterpret_cast<std::byte *>(block) + block->size;
+  }
+
+  block_header *m_head = nullptr;
+  std::byte *m_cur = nullptr;
+  std::byte *m_end = nullptr;
+  size_t m_next_block_size;
+  size_t m_reserved = 0;
+};
+
+/// Non-owning allocator handle to an arena.
+///
+/// The handle propagates on copy, move and swap so containers that exchange
+/// storage also exchange the arena it came from; this keeps vector's move
+/// assignment and swap pointer-only operations.
+template <typename T> class arena_allocator {
+public:
+  using value_type = T;
+  using propagate_on_container_copy_assignment = std::true_type;
+  using propagate_on_container_move_assignment = std::true_type;
+  using propagate_on_container_swap = std::true_type;
+  using is_always_equal = std::false_type;
+
+  arena_allocator(arena &a) noexcept : m_arena(&a) {}
+  arena_allocator(const arena_allocator &) noexcept = default;
+  template <class U>
+  arena_allocator(const arena_allocator<U> &other) noexcept
+      : m_arena(other.m_arena) {}
+  ~arena_allocator() = default;
+  arena_allocator &operator=(const arena_allocator &) noexcept = default;
+
+  T *allocate(size_t n) {
+    if (n > size_t(-1) / sizeof(T))
+      UTL_THROW(std::bad_alloc());
+    return static_cast<T *>(m_arena->allocate(n * sizeof(T), alignof(T)));
+  }
+
+  void deallocate(T *p, size_t n) noexcept {
+    m_arena->deallocate(p, n * sizeof(T));
+  }
+
+  arena &resource() const noexcept { return *m_arena; }
+
+  friend bool operator==(const arena_allocator &lhs,
+                         const arena_allocator &rhs) noexcept {
+    return lhs.m_arena == rhs.m_arena;
+  }
+
+  friend bool operator!=(const arena_allocator &lhs,
+                         const arena_allocator &rhs) noexcept {
+    return lhs.m_arena != rhs.m_arena;
+  }
+
+private:
+  template <typename U> friend class arena_allocator;
+
+  arena *m_arena;
+};
+
+} // namespace utl
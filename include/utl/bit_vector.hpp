@@ -0,0 +1,419 @@
+#pragma once
+#include <utl/allocator.hpp>
+#include <utl/config.hpp>
+#include <utl/growth_policy.hpp>
+#include <utl/vector.hpp>
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+
+namespace utl {
+namespace detail {
+
+inline size_t popcount64(std::uint64_t word) noexcept {
+#if defined(__GNUC__)
+  return static_cast<size_t>(__builtin_popcountll(word));
+#else
+  word = word - ((word >> 1) & 0x5555555555555555u);
+  word = (word & 0x3333333333333333u) + ((word >> 2) & 0x3333333333333333u);
+  word = (word + (word >> 4)) & 0x0f0f0f0f0f0f0f0fu;
+  return static_cast<size_t>((word * 0x0101010101010101u) >> 56);
+#endif
+}
+
+/// Index of the lowest set bit; `word` must not be zero.
+inline size_t countr_zero64(std::uint64_t word) noexcept {
+  assert(word);
+#if defined(__GNUC__)
+  return static_cast<size_t>(__builtin_ctzll(word));
+#else
+  size_t n = 0;
+  while (!(word & 1)) {
+    word >>= 1;
+    ++n;
+  }
+  return n;
+#endif
+}
+
+/// Set bits in `count` words, using AVX2 or POPCNT when the CPU has them.
+size_t popcount(const std::uint64_t *words, size_t count) noexcept;
+
+} // namespace detail
+
+/// Packed sequence of bits stored in 64-bit words.
+///
+/// Words grow like utl::vector under `GrowthPolicy`. Bits past size() in
+/// the last word are kept clear. count() and rank() without an index use
+/// a vectorized popcount. build_index() samples cumulative counts every
+/// 512 bits and the position of every 4096th set bit, so rank() is O(1)
+/// and select() nearly so. Any modification, including non-const
+/// operator[], drops the index.
+template <typename Allocator = allocator<std::uint64_t>,
+          typename GrowthPolicy = doubling_growth>
+class basic_bit_vector {
+public:
+  using word_type = std::uint64_t;
+  using allocator_type = Allocator;
+  using size_type = size_t;
+
+  static constexpr size_type npos = size_type(-1);
+  static constexpr size_type word_bits = 64;
+
+  /// Proxy for one bit.
+  class reference {
+  public:
+    operator bool() const noexcept { return *m_word & m_mask; }
+
+    reference &operator=(bool value) noexcept {
+      if (value)
+        *m_word |= m_mask;
+      else
+        *m_word &= ~m_mask;
+      return *this;
+    }
+
+    reference &operator=(const reference &other) noexcept {
+      return *this = bool(other);
+    }
+
+    void flip() noexcept { *m_word ^= m_mask; }
+
+  private:
+    friend class basic_bit_vector;
+
+    reference(word_type *word, word_type mask) noexcept
+        : m_word(word), m_mask(mask) {}
+
+    word_type *m_word;
+    word_type m_mask;
+  };
+
+private:
+  using words_type = vector<word_type, Allocator, GrowthPolicy>;
+
+  /// Words per rank sample.
+  static constexpr size_type block_words = 8;
+  /// Set bits per select sample.
+  static constexpr size_type select_sample = 4096;
+
+  static size_type word_index(size_type pos) noexcept { return pos / 64; }
+  static word_type bit_mask(size_type pos) noexcept {
+    return word_type(1) << (pos % 64);
+  }
+  /// Bits [0, n % 64) of a word; all bits when n is a multiple of 64.
+  static word_type low_mask(size_type n) noexcept {
+    return n % 64 ? (word_type(1) << (n % 64)) - 1 : ~word_type(0);
+  }
+
+public:
+  // construct/copy/destroy
+  basic_bit_vector() noexcept(noexcept(Allocator()))
+      : basic_bit_vector(Allocator()) {}
+
+  explicit basic_bit_vector(const allocator_type &allocator) noexcept
+      : m_words(allocator), m_rank(allocator), m_select(allocator) {}
+
+  explicit basic_bit_vector(size_type num, bool value = false,
+                            const allocator_type &allocator = allocator_type())
+      : basic_bit_vector(allocator) {
+    resize(num, value);
+  }
+
+  basic_bit_vector(initializer_list<bool> il,
+                   const allocator_type &allocator = allocator_type())
+      : basic_bit_vector(allocator) {
+    reserve(il.size());
+    for (const bool bit : il)
+      push_back(bit);
+  }
+
+  allocator_type get_allocator() const noexcept {
+    return m_words.get_allocator();
+  }
+
+  // capacity
+  bool empty() const noexcept { return m_size == 0; }
+  size_type size() const noexcept { return m_size; }
+  size_type capacity() const noexcept { return m_words.capacity() * 64; }
+
+  void reserve(size_type bits) { m_words.reserve((bits + 63) / 64); }
+
+  void resize(size_type bits, bool value = false) {
+    drop_index();
+    if (bits > m_size) {
+      const size_type old = m_size;
+      m_words.resize((bits + 63) / 64, 0);
+      m_size = bits;
+      if (value)
+        set_range(old, bits);
+    } else {
+      m_words.resize((bits + 63) / 64);
+      m_size = bits;
+      clear_tail();
+    }
+  }
+
+  void shrink_to_fit() {
+    m_words.shrink_to_fit();
+    m_rank.shrink_to_fit();
+    m_select.shrink_to_fit();
+  }
+
+  // element access:
+  bool operator[](size_type pos) const noexcept { return test(pos); }
+
+  reference operator[](size_type pos) noexcept {
+    drop_index();
+    return reference(&m_words[word_index(pos)], bit_mask(pos));
+  }
+
+  bool test(size_type pos) const noexcept {
+    return m_words[word_index(pos)] & bit_mask(pos);
+  }
+
+  bool at(size_type pos) const {
+    if (pos < m_size)
+      return test(pos);
+    UTL_THROW(std::out_of_range("bit_vector::at"));
+  }
+
+  /// The underlying words; bit i is bit i % 64 of word i / 64.
+  const word_type *data() const noexcept { return m_words.data(); }
+  size_type word_count() const noexcept { return m_words.size(); }
+
+  // modifiers
+  void push_back(bool value) {
+    if (m_size % 64 == 0)
+      m_words.push_back(0);
+    drop_index();
+    if (value)
+      m_words.back() |= bit_mask(m_size);
+    ++m_size;
+  }
+
+  void pop_back() noexcept {
+    drop_index();
+    --m_size;
+    if (m_size % 64 == 0)
+      m_words.pop_back();
+    else
+      m_words.back() &= low_mask(m_size);
+  }
+
+  void set(size_type pos, bool value = true) noexcept {
+    drop_index();
+    if (value)
+      m_words[word_index(pos)] |= bit_mask(pos);
+    else
+      m_words[word_index(pos)] &= ~bit_mask(pos);
+  }
+
+  void reset(size_type pos) noexcept { set(pos, false); }
+
+  void flip(size_type pos) noexcept {
+    drop_index();
+    m_words[word_index(pos)] ^= bit_mask(pos);
+  }
+
+  /// Sets the bits in [first, last).
+  void set_range(size_type first, size_type last) noexcept {
+    apply_range(first, last, [](word_type &w, word_type m) { w |= m; });
+  }
+
+  /// Clears the bits in [first, last).
+  void reset_range(size_type first, size_type last) noexcept {
+    apply_range(first, last, [](word_type &w, word_type m) { w &= ~m; });
+  }
+
+  /// Inverts the bits in [first, last).
+  void flip_range(size_type first, size_type last) noexcept {
+    apply_range(first, last, [](word_type &w, word_type m) { w ^= m; });
+  }
+
+  void set() noexcept { set_range(0, m_size); }
+  void reset() noexcept { reset_range(0, m_size); }
+  void flip() noexcept { flip_range(0, m_size); }
+
+  void clear() noexcept {
+    drop_index();
+    m_words.clear();
+    m_size = 0;
+  }
+
+  void swap(basic_bit_vector &other) {
+    using std::swap;
+    m_words.swap(other.m_words);
+    m_rank.swap(other.m_rank);
+    m_select.swap(other.m_select);
+    swap(m_size, other.m_size);
+    swap(m_ones, other.m_ones);
+    swap(m_indexed, other.m_indexed);
+  }
+
+  // queries
+  /// Number of set bits.
+  size_type count() const noexcept {
+    if (m_indexed)
+      return m_ones;
+    return detail::popcount(m_words.data(), m_words.size());
+  }
+
+  /// Number of set bits in [first, last).
+  size_type count(size_type first, size_type last) const noexcept {
+    return rank(last) - rank(first);
+  }
+
+  bool all() const noexcept { return count() == m_size; }
+  bool any() const noexcept { return find_first() != npos; }
+  bool none() const noexcept { return !any(); }
+
+  /// Position of the first set bit, or npos.
+  size_type find_first() const noexcept { return find_from(0); }
+
+  /// Position of the first set bit after `pos`, or npos.
+  size_type find_next(size_type pos) const noexcept {
+    return pos + 1 >= m_size ? npos : find_from(pos + 1);
+  }
+
+  /// Number of set bits in [0, pos), pos <= size().
+  size_type rank(size_type pos) const noexcept {
+    assert(pos <= m_size);
+    const size_type word = word_index(pos);
+    size_type result;
+    if (m_indexed) {
+      const size_type block = word / block_words;
+      result = static_cast<size_type>(m_rank[block]) + detail::popcount(m_words.data() +
+                                                    block * block_words,
+                                                word - block * block_words);
+    } else {
+      result = detail::popcount(m_words.data(), word);
+    }
+    if (pos % 64)
+      result += detail::popcount64(m_words[word] & low_mask(pos));
+    return result;
+  }
+
+  /// Position of the set bit with rank `k`, counting from 0, or npos if
+  /// there are not that many.
+  size_type select(size_type k) const noexcept {
+    size_type word = 0;
+    if (m_indexed) {
+      if (k >= m_ones)
+        return npos;
+      // Start from the sampled block and walk the rank samples.
+      auto block = static_cast<size_type>(m_select[k / select_sample]);
+      while (m_rank[block + 1] <= k)
+        ++block;
+      k -= static_cast<size_type>(m_rank[block]);
+      word = block * block_words;
+    }
+    for (; word != m_words.size(); ++word) {
+      const size_type ones = detail::popcount64(m_words[word]);
+      if (k < ones)
+        return word * 64 + select_in_word(m_words[word], k);
+      k -= ones;
+    }
+    return npos;
+  }
+
+  /// Samples cumulative counts so that rank() and select() need not scan
+  /// from the start. Costs about 1/64 of the bit storage.
+  void build_index() {
+    const size_type blocks = (m_words.size() + block_words - 1) / block_words;
+    m_rank.resize(blocks + 1);
+    m_select.clear();
+    size_type ones = 0;
+    for (size_type block = 0; block != blocks; ++block) {
+      m_rank[block] = ones;
+      const size_type first = block * block_words;
+      const size_type n = utl::min(block_words, m_words.size() - first);
+      const size_type block_ones = detail::popcount(m_words.data() + first, n);
+      // Record the block holding each multiple of select_sample.
+      while (m_select.size() * select_sample < ones + block_ones)
+        m_select.push_back(block);
+      ones += block_ones;
+    }
+    m_rank[blocks] = ones;
+    m_ones = ones;
+    m_indexed = true;
+  }
+
+  bool has_index() const noexcept { return m_indexed; }
+
+  friend bool operator==(const basic_bit_vector &x,
+                         const basic_bit_vector &y) noexcept {
+    return x.m_size == y.m_size && x.m_words == y.m_words;
+  }
+
+  friend bool operator!=(const basic_bit_vector &x,
+                         const basic_bit_vector &y) noexcept {
+    return !(x == y);
+  }
+
+private:
+  void drop_index() noexcept { m_indexed = false; }
+
+  void clear_tail() noexcept {
+    if (m_size % 64)
+      m_words.back() &= low_mask(m_size);
+  }
+
+  template <typename Op>
+  void apply_range(size_type first, size_type last, Op op) noexcept {
+    assert(first <= last && last <= m_size);
+    if (first == last)
+      return;
+    drop_index();
+    const size_type fw = word_index(first);
+    const size_type lw = word_index(last - 1);
+    const word_type head = ~word_type(0) << (first % 64);
+    const word_type tail = low_mask(last);
+    if (fw == lw) {
+      op(m_words[fw], head & tail);
+      return;
+    }
+    op(m_words[fw], head);
+    for (size_type w = fw + 1; w != lw; ++w)
+      op(m_words[w], ~word_type(0));
+    op(m_words[lw], tail);
+  }
+
+  size_type find_from(size_type pos) const noexcept {
+    if (pos >= m_size)
+      return npos;
+    size_type word = word_index(pos);
+    word_type bits = m_words[word] & (~word_type(0) << (pos % 64));
+    while (!bits) {
+      if (++word == m_words.size())
+        return npos;
+      bits = m_words[word];
+    }
+    return word * 64 + detail::countr_zero64(bits);
+  }
+
+  static size_type select_in_word(word_type word, size_type k) noexcept {
+    for (; k; --k)
+      word &= word - 1;
+    return detail::countr_zero64(word);
+  }
+
+  words_type m_words;
+  vector<word_type, Allocator> m_rank;
+  vector<word_type, Allocator> m_select;
+  size_type m_size = 0;
+  size_type m_ones = 0;
+  bool m_indexed = false;
+};
+
+template <typename Allocator, typename GrowthPolicy>
+void swap(basic_bit_vector<Allocator, GrowthPolicy> &x,
+          basic_bit_vector<Allocator, GrowthPolicy> &y) {
+  x.swap(y);
+}
+
+using bit_vector = basic_bit_vector<>;
+
+} // namespace utl
@@ -0,0 +1,519 @@
+#pragma once
+#include <utl/allocator.hpp>
+#include <utl/config.hpp>
+#include <utl/iterator.hpp>
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <iterator>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace utl {
+namespace detail {
+
+/// Index of an element in a concurrent_vector. concurrent_vector_iterator
+/// keeps one as its m_data, so iterator_wrapper's arithmetic and
+/// comparisons work on the index.
+template <typename Vector> class concurrent_vector_cursor {
+public:
+  using value_type = typename Vector::value_type;
+
+  constexpr concurrent_vector_cursor() noexcept = default;
+
+  constexpr concurrent_vector_cursor(const Vector *vec, size_t idx) noexcept
+      : m_vec(vec), m_idx(idx) {}
+
+  value_type &operator*() const noexcept { return m_vec->element(m_idx); }
+
+  value_type &operator[](std::ptrdiff_t diff) const noexcept {
+    return m_vec->element(m_idx + diff);
+  }
+
+  explicit operator value_type *() const noexcept { return &**this; }
+
+  explicit constexpr operator bool() const noexcept {
+    return m_vec != nullptr;
+  }
+
+  constexpr concurrent_vector_cursor &operator+=(std::ptrdiff_t diff) noexcept {
+    m_idx += diff;
+    return *this;
+  }
+
+  friend constexpr concurrent_vector_cursor
+  operator+(const concurrent_vector_cursor &c, std::ptrdiff_t diff) noexcept {
+    return concurrent_vector_cursor(c.m_vec, c.m_idx + diff);
+  }
+
+  friend constexpr concurrent_vector_cursor
+  operator-(const concurrent_vector_cursor &c, std::ptrdiff_t diff) noexcept {
+    return concurrent_vector_cursor(c.m_vec, c.m_idx - diff);
+  }
+
+  friend constexpr std::ptrdiff_t
+  operator-(const concurrent_vector_cursor &lhs,
+            const concurrent_vector_cursor &rhs) noexcept {
+    return static_cast<std::ptrdiff_t>(lhs.m_idx - rhs.m_idx);
+  }
+
+  friend constexpr bool operator==(const concurrent_vector_cursor &lhs,
+                                   const concurrent_vector_cursor &rhs) noexcept {
+    return lhs.m_idx == rhs.m_idx;
+  }
+
+  friend constexpr bool operator!=(const concurrent_vector_cursor &lhs,
+                                   const concurrent_vector_cursor &rhs) noexcept {
+    return lhs.m_idx != rhs.m_idx;
+  }
+
+  friend constexpr bool operator!=(const concurrent_vector_cursor &c,
+                                   std::nullptr_t) noexcept {
+    return c.m_vec != nullptr;
+  }
+
+  friend constexpr bool operator<(const concurrent_vector_cursor &lhs,
+                                  const concurrent_vector_cursor &rhs) noexcept {
+    return lhs.m_idx < rhs.m_idx;
+  }
+
+  friend constexpr bool operator>(const concurrent_vector_cursor &lhs,
+                                  const concurrent_vector_cursor &rhs) noexcept {
+    return lhs.m_idx > rhs.m_idx;
+  }
+
+  friend constexpr bool operator<=(const concurrent_vector_cursor &lhs,
+                                   const concurrent_vector_cursor &rhs) noexcept {
+    return lhs.m_idx <= rhs.m_idx;
+  }
+
+  friend constexpr bool operator>=(const concurrent_vector_cursor &lhs,
+                                   const concurrent_vector_cursor &rhs) noexcept {
+    return lhs.m_idx >= rhs.m_idx;
+  }
+
+private:
+  const Vector *m_vec = nullptr;
+  size_t m_idx = 0;
+};
+
+} // namespace detail
+
+template <typename Vector>
+class concurrent_vector_iterator
+    : public iterator_wrapper<concurrent_vector_iterator<Vector>,
+                              typename Vector::value_type,
+                              typename Vector::value_type &,
+                              typename Vector::value_type *,
+                              std::random_access_iterator_tag> {
+public:
+  constexpr concurrent_vector_iterator() noexcept = default;
+
+  constexpr explicit concurrent_vector_iterator(
+      detail::concurrent_vector_cursor<Vector> data) noexcept
+      : m_data(data) {}
+
+  detail::concurrent_vector_cursor<Vector> m_data;
+};
+
+template <typename Vector>
+class concurrent_vector_const_iterator
+    : public iterator_wrapper<concurrent_vector_const_iterator<Vector>,
+                              typename Vector::value_type,
+                              const typename Vector::value_type &,
+                              const typename Vector::value_type *,
+                              std::random_access_iterator_tag> {
+public:
+  constexpr concurrent_vector_const_iterator() noexcept = default;
+
+  constexpr explicit concurrent_vector_const_iterator(
+      detail::concurrent_vector_cursor<Vector> data) noexcept
+      : m_data(data) {}
+
+  constexpr concurrent_vector_const_iterator(
+      concurrent_vector_iterator<Vector> it) noexcept
+      : m_data(it.m_data) {}
+
+  detail::concurrent_vector_cursor<Vector> m_data;
+};
+
+/// Vector that any number of threads can append to without locking.
+///
+/// Elements live in segments of 16, 32, 64, ... slots that are never moved,
+/// so references stay valid until the vector is cleared or destroyed.
+/// push_back and grow_by reserve slots with one fetch_add, install missing
+/// segments with a compare-and-swap and publish each element through a
+/// per-slot ready flag.
+///
+/// Concurrent readers may access element i once ready(i) is true, or once
+/// they otherwise synchronize with the thread that appended it. size()
+/// counts reserved slots, including ones still under construction.
+///
+/// If an append throws, the slots it reserved but did not construct still
+/// count in size(). When Tp is nothrow default constructible they receive
+/// a value-initialized element; otherwise they stay unready for good, and
+/// even single-threaded code must check ready() before touching them, as
+/// iterators do not skip them. The copy constructor copies ready elements
+/// only. Construction, assignment, clear, swap and destruction are not
+/// thread-safe.
+template <typename Tp, typename Allocator = allocator<Tp>>
+class concurrent_vector {
+public:
+  // types:
+  using value_type = Tp;
+  using allocator_type = Allocator;
+  using alloc_traits = allocator_traits<allocator_type>;
+  using pointer = typename alloc_traits::pointer;
+  using const_pointer = typename alloc_traits::const_pointer;
+  using reference = value_type &;
+  using const_reference = const value_type &;
+  using size_type = size_t;
+  using difference_type = std::ptrdiff_t;
+  using iterator = concurrent_vector_iterator<concurrent_vector>;
+  using const_iterator = concurrent_vector_const_iterator<concurrent_vector>;
+  using reverse_iterator = std::reverse_iterator<iterator>;
+  using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+private:
+  using flag = std::atomic<unsigned char>;
+  using cursor = detail::concurrent_vector_cursor<concurrent_vector>;
+  friend cursor;
+
+  static constexpr size_type first_shift = 4;
+  static constexpr size_type segment_count = 64 - first_shift;
+
+  static size_type log2(size_type x) noexcept {
+#if defined(__GNUC__)
+    return sizeof(unsigned long long) * 8 - 1 -
+           static_cast<size_type>(__builtin_clzll(x));
+#else
+    size_type r = 0;
+    while (x >>= 1)
+      ++r;
+    return r;
+#endif
+  }
+
+  static size_type segment_of(size_type idx) noexcept {
+    return log2(idx + (size_type(1) << first_shift)) - first_shift;
+  }
+
+  static size_type segment_base(size_type seg) noexcept {
+    return (size_type(1) << (seg + first_shift)) - (size_type(1) << first_shift);
+  }
+
+  static size_type segment_size(size_type seg) noexcept {
+    return size_type(1) << (seg + first_shift);
+  }
+
+  /// Slots of type Tp to allocate for a segment: the elements followed by
+  /// one ready flag per element.
+  static size_type allocation_size(size_type seg) noexcept {
+    const size_type n = segment_size(seg);
+    return n + (n * sizeof(flag) + sizeof(value_type) - 1) / sizeof(value_type);
+  }
+
+  static flag *flags(pointer segment, size_type seg) noexcept {
+    return reinterpret_cast<flag *>(segment + segment_size(seg));
+  }
+
+public:
+  // construct/copy/destroy
+  concurrent_vector() noexcept(noexcept(Allocator()))
+      : concurrent_vector(Allocator()) {}
+
+  explicit concurrent_vector(const allocator_type &allocator) noexcept
+      : m_alloc(allocator) {}
+
+  explicit concurrent_vector(size_type num,
+                             const allocator_type &allocator = allocator_type())
+      : m_alloc(allocator) {
+    UTL_TRY { grow_by(num); }
+    UTL_CATCH(...) {
+      clear();
+      UTL_RETHROW;
+    }
+  }
+
+  concurrent_vector(initializer_list<value_type> il,
+                    const allocator_type &allocator = allocator_type())
+      : m_alloc(allocator) {
+    UTL_TRY { grow_by(il.begin(), il.end()); }
+    UTL_CATCH(...) {
+      clear();
+      UTL_RETHROW;
+    }
+  }
+
+  concurrent_vector(const concurrent_vector &other)
+      : m_alloc(alloc_traits::select_on_container_copy_construction(
+            other.m_alloc)) {
+    UTL_TRY {
+      const size_type num = other.size();
+      reserve(num);
+      for (size_type i = 0; i != num; ++i)
+        if (other.ready(i))
+          push_back(other.element(i));
+    }
+    UTL_CATCH(...) {
+      clear();
+      UTL_RETHROW;
+    }
+  }
+
+  concurrent_vector(concurrent_vector &&other) noexcept
+      : m_alloc(std::move(other.m_alloc)) {
+    for (size_type seg = 0; seg != segment_count; ++seg)
+      m_segments[seg].store(
+          other.m_segments[seg].exchange(nullptr, std::memory_order_relaxed),
+          std::memory_order_relaxed);
+    m_size.store(other.m_size.exchange(0, std::memory_order_relaxed),
+                 std::memory_order_relaxed);
+  }
+
+  concurrent_vector &operator=(const concurrent_vector &) = delete;
+  concurrent_vector &operator=(concurrent_vector &&) = delete;
+
+  ~concurrent_vector() { clear(); }
+
+  allocator_type get_allocator() const noexcept { return m_alloc; }
+
+  // iterators:
+  iterator begin() noexcept { return iterator{cursor(this, 0)}; }
+  const_iterator begin() const noexcept {
+    return const_iterator{cursor(this, 0)};
+  }
+  iterator end() noexcept { return iterator{cursor(this, size())}; }
+  const_iterator end() const noexcept {
+    return const_iterator{cursor(this, size())};
+  }
+  reverse_iterator rbegin() noexcept { return reverse_iterator(end()); }
+  const_reverse_iterator rbegin() const noexcept {
+    return const_reverse_iterator(end());
+  }
+  reverse_iterator rend() noexcept { return reverse_iterator(begin()); }
+  const_reverse_iterator rend() const noexcept {
+    return const_reverse_iterator(begin());
+  }
+  const_iterator cbegin() const noexcept { return begin(); }
+  const_iterator cend() const noexcept { return end(); }
+  const_reverse_iterator crbegin() const noexcept { return rbegin(); }
+  const_reverse_iterator crend() const noexcept { return rend(); }
+
+  // capacity
+  bool empty() const noexcept { return size() == 0; }
+  size_type size() const noexcept {
+    return m_size.load(std::memory_order_acquire);
+  }
+  size_type max_size() const noexcept {
+    return alloc_traits::max_size(m_alloc);
+  }
+
+  /// Number of slots in the allocated segments.
+  size_type capacity() const noexcept {
+    size_type seg = 0;
+    while (seg != segment_count &&
+           m_segments[seg].load(std::memory_order_acquire))
+      ++seg;
+    return segment_base(seg);
+  }
+
+  /// Allocates the segments covering the first `num` slots. Thread-safe.
+  void reserve(size_type num) {
+    if (num)
+      for (size_type seg = 0, last = segment_of(num - 1); seg <= last; ++seg)
+        segment(seg);
+  }
+
+  /// Whether element `num` has been constructed and published. Once true,
+  /// the element may be read from any thread.
+  bool ready(size_type num) const noexcept {
+    const size_type seg = segment_of(num);
+    const pointer data = m_segments[seg].load(std::memory_order_acquire);
+    return data && flags(data, seg)[num - segment_base(seg)].load(
+                       std::memory_order_acquire);
+  }
+
+  // element access:
+  reference operator[](size_type num) { return element(num); }
+  const_reference operator[](size_type num) const { return element(num); }
+  reference at(size_type num) {
+    if (num < size())
+      return element(num);
+    UTL_THROW(std::out_of_range("concurrent_vector::at"));
+  }
+  const_reference at(size_type num) const {
+    if (num < size())
+      return element(num);
+    UTL_THROW(std::out_of_range("concurrent_vector::at"));
+  }
+  reference front() { return element(0); }
+  const_reference front() const { return element(0); }
+  reference back() { return element(size() - 1); }
+  const_reference back() const { return element(size() - 1); }
+
+  // modifiers
+  template <typename... Args> iterator emplace_back(Args &&... args) {
+    const size_type idx = m_size.fetch_add(1, std::memory_order_relaxed);
+    UTL_TRY { construct(idx, std::forward<Args>(args)...); }
+    UTL_CATCH(...) {
+      abandon(idx, 1);
+      UTL_RETHROW;
+    }
+    return begin() + idx;
+  }
+
+  iterator push_back(const_reference elem) { return emplace_back(elem); }
+
+  iterator push_back(value_type &&elem) {
+    return emplace_back(std::move(elem));
+  }
+
+  /// Appends `num` value-initialized elements and returns an iterator to
+  /// the first.
+  iterator grow_by(size_type num) {
+    const size_type first = m_size.fetch_add(num, std::memory_order_relaxed);
+    size_type i = 0;
+    UTL_TRY {
+      for (; i != num; ++i)
+        construct(first + i);
+    }
+    UTL_CATCH(...) {
+      abandon(first + i, num - i);
+      UTL_RETHROW;
+    }
+    return begin() + first;
+  }
+
+  iterator grow_by(size_type num, const_reference val) {
+    const size_type first = m_size.fetch_add(num, std::memory_order_relaxed);
+    size_type i = 0;
+    UTL_TRY {
+      for (; i != num; ++i)
+        construct(first + i, val);
+    }
+    UTL_CATCH(...) {
+      abandon(first + i, num - i);
+      UTL_RETHROW;
+    }
+    return begin() + first;
+  }
+
+  template <typename ForwardIterator,
+            typename = typename iterator_traits<
+                ForwardIterator>::iterator_category>
+  iterator grow_by(ForwardIterator first, ForwardIterator last) {
+    const size_type num = std::distance(first, last);
+    const size_type idx = m_size.fetch_add(num, std::memory_order_relaxed);
+    size_type i = 0;
+    UTL_TRY {
+      for (; i != num; ++i, ++first)
+        construct(idx + i, *first);
+    }
+    UTL_CATCH(...) {
+      abandon(idx + i, num - i);
+      UTL_RETHROW;
+    }
+    return begin() + idx;
+  }
+
+  iterator grow_by(initializer_list<value_type> il) {
+    return grow_by(il.begin(), il.end());
+  }
+
+  /// Destroys every published element and frees all segments.
+  void clear() noexcept {
+    for (size_type seg = 0; seg != segment_count; ++seg) {
+      const pointer data =
+          m_segments[seg].exchange(nullptr, std::memory_order_relaxed);
+      if (!data)
+        continue;
+      flag *const ready = flags(data, seg);
+      for (size_type i = 0, n = segment_size(seg); i != n; ++i)
+        if (ready[i].load(std::memory_order_relaxed))
+          alloc_traits::destroy(m_alloc, data + i);
+      alloc_traits::deallocate(m_alloc, data, allocation_size(seg));
+    }
+    m_size.store(0, std::memory_order_relaxed);
+  }
+
+  void swap(concurrent_vector &other) noexcept {
+    using std::swap;
+    if constexpr (alloc_traits::propagate_on_container_swap::value)
+      swap(m_alloc, other.m_alloc);
+    else
+      assert(m_alloc == other.m_alloc);
+    for (size_type seg = 0; seg != segment_count; ++seg)
+      m_segments[seg].store(
+          other.m_segments[seg].exchange(
+              m_segments[seg].load(std::memory_order_relaxed),
+              std::memory_order_relaxed),
+          std::memory_order_relaxed);
+    m_size.store(other.m_size.exchange(m_size.load(std::memory_order_relaxed),
+                                       std::memory_order_relaxed),
+                 std::memory_order_relaxed);
+  }
+
+private:
+  reference element(size_type idx) const noexcept {
+    const size_type seg = segment_of(idx);
+    return m_segments[seg].load(std::memory_order_acquire)[idx -
+                                                          segment_base(seg)];
+  }
+
+  /// The segment `seg`, allocating it if no thread has yet.
+  pointer segment(size_type seg) {
+    pointer data = m_segments[seg].load(std::memory_order_acquire);
+    if (data)
+      return data;
+
+    const pointer fresh = alloc_traits::allocate(m_alloc, allocation_size(seg));
+    flag *const ready = flags(fresh, seg);
+    for (size_type i = 0, n = segment_size(seg); i != n; ++i)
+      ::new (static_cast<void *>(ready + i)) flag(0);
+
+    if (m_segments[seg].compare_exchange_strong(data, fresh,
+                                                std::memory_order_acq_rel,
+                                                std::memory_order_acquire))
+      return fresh;
+    // Another thread installed it first.
+    alloc_traits::deallocate(m_alloc, fresh, allocation_size(seg));
+    return data;
+  }
+
+  template <typename... Args> void construct(size_type idx, Args &&... args) {
+    const size_type seg = segment_of(idx);
+    const size_type offset = idx - segment_base(seg);
+    const pointer data = segment(seg);
+    alloc_traits::construct(m_alloc, data + offset, std::forward<Args>(args)...);
+    flags(data, seg)[offset].store(1, std::memory_order_release);
+  }
+
+  /// Fills slots [idx, idx + num), reserved by an append that threw, with
+  /// value-initialized elements if that cannot throw. A slot whose segment
+  /// cannot be allocated stays unready.
+  void abandon(size_type idx, size_type num) noexcept {
+    if constexpr (std::is_nothrow_default_constructible_v<value_type>) {
+      for (; num; --num, ++idx) {
+        UTL_TRY { construct(idx); }
+        UTL_CATCH(...) {}
+      }
+    }
+  }
+
+  allocator_type m_alloc;
+  std::atomic<pointer> m_segments[segment_count] = {};
+  // Written by every append; kept off the line readers use for segments.
+  alignas(64) std::atomic<size_type> m_size{0};
+};
+
+template <typename Tp, typename Allocator>
+void swap(concurrent_vector<Tp, Allocator> &x,
+          concurrent_vector<Tp, Allocator> &y) noexcept {
+  x.swap(y);
+}
+
+} // namespace utl
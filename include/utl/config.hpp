@@ -8,6 +8,22 @@
 #define UTL_NO_EXCEPTIONS 0
 #endif
 
+#ifndef UTL_HAS_MMAP
+#if defined(__unix__) || defined(__APPLE__)
+#define UTL_HAS_MMAP 1
+#else
+#define UTL_HAS_MMAP 0
+#endif
+#endif
+
+#ifndef UTL_HAS_MREMAP
+#if defined(__linux__)
+#define UTL_HAS_MREMAP 1
+#else
+#define UTL_HAS_MREMAP 0
+#endif
+#endif
+
 #if UTL_NO_EXCEPTIONS
 
 #define UTL_THROW(...) std::abort()
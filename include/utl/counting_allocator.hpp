@@ -0,0 +1,255 @@
+#pragma once
+#include <utl/allocator.hpp>
+#include <utl/config.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <iosfwd>
+#include <type_traits>
+
+namespace utl {
+
+/// Allocation statistics for one call site.
+///
+/// All counters live in per-thread shards updated with relaxed atomics. Each
+/// shard folds its change in live bytes into a per-site total once the
+/// change reaches peak_granularity bytes, and the peak is taken from that
+/// total. The peak can thus be off by up to shard_count * peak_granularity
+/// bytes; a site constructed with `exact_peak` folds on every call instead.
+/// Live bytes are always exact. Sites register themselves with
+/// allocation_registry on construction and must outlive it, so give them
+/// static storage duration (see UTL_ALLOCATION_SITE).
+class allocation_site {
+public:
+  /// Histogram bucket i counts requests of [2^(i-1), 2^i) bytes; bucket 0
+  /// counts empty requests.
+  static constexpr size_t histogram_buckets = 48;
+
+  static constexpr size_t shard_count = 16;
+  static constexpr size_t peak_granularity = 64 * 1024;
+
+  struct statistics {
+    size_t allocations;
+    size_t deallocations;
+    size_t bytes_allocated;
+    size_t bytes_deallocated;
+    size_t live_bytes;
+    size_t peak_live_bytes;
+    size_t histogram[histogram_buckets];
+  };
+
+  explicit allocation_site(const char *name, bool exact_peak = false) noexcept;
+  allocation_site(const allocation_site &) = delete;
+  allocation_site &operator=(const allocation_site &) = delete;
+
+  const char *name() const noexcept { return m_name; }
+
+  void record_allocate(size_t bytes) noexcept {
+    auto &shard = m_shards[shard_index()];
+    shard.allocations.fetch_add(1, std::memory_order_relaxed);
+    shard.bytes.fetch_add(bytes, std::memory_order_relaxed);
+    shard.histogram[bucket(bytes)].fetch_add(1, std::memory_order_relaxed);
+    record_live(shard, static_cast<std::ptrdiff_t>(bytes));
+  }
+
+  void record_deallocate(size_t bytes) noexcept {
+    auto &shard = m_shards[shard_index()];
+    shard.deallocations.fetch_add(1, std::memory_order_relaxed);
+    shard.freed_bytes.fetch_add(bytes, std::memory_order_relaxed);
+    record_live(shard, -static_cast<std::ptrdiff_t>(bytes));
+  }
+
+  statistics stats() const noexcept;
+
+  /// The site used by allocators that were not given one.
+  static allocation_site &unattributed() noexcept;
+
+private:
+  friend class allocation_registry;
+
+  struct alignas(64) shard {
+    std::atomic<size_t> allocations{0};
+    std::atomic<size_t> deallocations{0};
+    std::atomic<size_t> bytes{0};
+    std::atomic<size_t> freed_bytes{0};
+    // Change in live bytes not yet folded into m_live.
+    std::atomic<std::ptrdiff_t> live{0};
+    std::atomic<size_t> histogram[histogram_buckets] = {};
+  };
+
+  void record_live(shard &shard, std::ptrdiff_t bytes) noexcept {
+    const std::ptrdiff_t pending =
+        shard.live.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+    if (pending >= m_fold_bytes || pending <= -m_fold_bytes)
+      fold(shard);
+  }
+
+  /// Moves a shard's pending change into m_live and updates the peak.
+  void fold(shard &shard) noexcept {
+    const std::ptrdiff_t delta =
+        shard.live.exchange(0, std::memory_order_relaxed);
+    const std::ptrdiff_t live =
+        m_live.fetch_add(delta, std::memory_order_relaxed) + delta;
+    if (live <= 0)
+      return;
+    size_t peak = m_peak.load(std::memory_order_relaxed);
+    while (size_t(live) > peak &&
+           !m_peak.compare_exchange_weak(peak, size_t(live),
+                                         std::memory_order_relaxed))
+      ;
+  }
+
+  static size_t bucket(size_t bytes) noexcept {
+    size_t i = 0;
+    while (bytes && i != histogram_buckets - 1) {
+      bytes >>= 1;
+      ++i;
+    }
+    return i;
+  }
+
+  static size_t shard_index() noexcept {
+    thread_local const size_t index = next_shard_index();
+    return index;
+  }
+
+  static size_t next_shard_index() noexcept;
+
+  const char *m_name;
+  allocation_site *m_next;
+  std::ptrdiff_t m_fold_bytes;
+  shard m_shards[shard_count];
+  alignas(64) std::atomic<std::ptrdiff_t> m_live{0};
+  std::atomic<size_t> m_peak{0};
+};
+
+/// Global list of allocation sites.
+class allocation_registry {
+public:
+  template <typename Callable> static void for_each(Callable &&callable) {
+    for (auto site = head().load(std::memory_order_acquire); site;
+         site = site->m_next)
+      callable(*site);
+  }
+
+  /// One line per site, followed by its non-empty histogram buckets.
+  static void dump_text(std::ostream &os);
+
+  /// {"sites": [{"name": ..., "allocations": ..., "histogram": [...]}]}
+  static void dump_json(std::ostream &os);
+
+private:
+  friend class allocation_site;
+
+  static std::atomic<allocation_site *> &head() noexcept;
+};
+
+/// A named allocation site with static storage duration, created on first
+/// use: counting_allocator<T>(UTL_ALLOCATION_SITE("parser/tokens")).
+#define UTL_ALLOCATION_SITE(name)                                              \
+  ([]() -> ::utl::allocation_site & {                                          \
+    static ::utl::allocation_site site(name);                                  \
+    return site;                                                               \
+  }())
+
+/// Allocator adaptor that records every allocation made through `Inner` in
+/// an allocation_site.
+///
+/// Two counting allocators compare equal only if they share a site and
+/// their inner allocators compare equal. The allocator propagates on move
+/// assignment and swap, so a buffer is always freed through the site that
+/// allocated it.
+template <typename T, typename Inner = allocator<T>> class counting_allocator {
+  using inner_traits = allocator_traits<Inner>;
+
+public:
+  using value_type = T;
+  using inner_allocator_type = Inner;
+  using propagate_on_container_copy_assignment =
+      typename inner_traits::propagate_on_container_copy_assignment;
+  using propagate_on_container_move_assignment = std::true_type;
+  using propagate_on_container_swap = std::true_type;
+  using is_always_equal = std::false_type;
+
+  template <typename U> struct rebind {
+    using other =
+        counting_allocator<U, typename inner_traits::template rebind_alloc<U>>;
+  };
+
+  counting_allocator() noexcept(std::is_nothrow_default_constructible_v<Inner>)
+      : m_inner(), m_site(&allocation_site::unattributed()) {}
+
+  explicit counting_allocator(allocation_site &site,
+                              const Inner &inner = Inner()) noexcept
+      : m_inner(inner), m_site(&site) {}
+
+  counting_allocator(const counting_allocator &) noexcept = default;
+
+  template <typename U, typename I>
+  counting_allocator(const counting_allocator<U, I> &other) noexcept
+      : m_inner(other.inner_allocator()), m_site(&other.site()) {}
+
+  ~counting_allocator() = default;
+  counting_allocator &operator=(const counting_allocator &) noexcept = default;
+
+  T *allocate(size_t n) {
+    T *const p = inner_traits::allocate(m_inner, n);
+    m_site->record_allocate(n * sizeof(T));
+    return p;
+  }
+
+  allocation_result<T *> allocate_at_least(size_t n) {
+    const auto result = utl::allocate_at_least(m_inner, n);
+    m_site->record_allocate(result.count * sizeof(T));
+    return {result.ptr, result.count};
+  }
+
+  void deallocate(T *p, size_t n) noexcept {
+    m_site->record_deallocate(n * sizeof(T));
+    inner_traits::deallocate(m_inner, p, n);
+  }
+
+  size_t try_expand(T *p, size_t n, size_t new_n) noexcept {
+    const size_t count = utl::try_expand(m_inner, p, n, new_n);
+    if (count)
+      record_resize(n, count);
+    return count;
+  }
+
+  allocation_result<T *> try_reallocate(T *p, size_t n, size_t new_n) noexcept {
+    const auto result = utl::try_reallocate(m_inner, p, n, new_n);
+    if (result.ptr)
+      record_resize(n, result.count);
+    return {result.ptr, result.count};
+  }
+
+  counting_allocator select_on_container_copy_construction() const {
+    return counting_allocator(
+        *m_site, inner_traits::select_on_container_copy_construction(m_inner));
+  }
+
+  const Inner &inner_allocator() const noexcept { return m_inner; }
+
+  allocation_site &site() const noexcept { return *m_site; }
+
+  friend bool operator==(const counting_allocator &lhs,
+                         const counting_allocator &rhs) noexcept {
+    return lhs.m_site == rhs.m_site && lhs.m_inner == rhs.m_inner;
+  }
+
+  friend bool operator!=(const counting_allocator &lhs,
+                         const counting_allocator &rhs) noexcept {
+    return !(lhs == rhs);
+  }
+
+private:
+  void record_resize(size_t n, size_t new_n) noexcept {
+    m_site->record_deallocate(n * sizeof(T));
+    m_site->record_allocate(new_n * sizeof(T));
+  }
+
+  Inner m_inner;
+  allocation_site *m_site;
+};
+
+} // namespace utl
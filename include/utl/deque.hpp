@@ -0,0 +1,680 @@
+#pragma once
+#include <utl/algorithm.hpp>
+#include <utl/allocator.hpp>
+#include <utl/config.hpp>
+#include <utl/iterator.hpp>
+#include <utl/type_traits.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace utl {
+namespace detail {
+
+/// log2 of the number of elements per deque block: as many as fit in 4 KiB,
+/// rounded down to a power of two, and at least 16.
+template <typename T> constexpr size_t deque_block_shift() noexcept {
+  size_t shift = 4;
+  while ((size_t(2) << shift) * sizeof(T) <= 4096)
+    ++shift;
+  return shift;
+}
+
+/// Position of an element in a deque's block map. deque_iterator keeps one
+/// as its m_data, so iterator_wrapper's arithmetic and comparisons apply
+/// to the position unchanged.
+template <typename T> class deque_cursor {
+public:
+  static constexpr size_t shift = deque_block_shift<T>();
+  static constexpr size_t mask = (size_t(1) << shift) - 1;
+
+  constexpr deque_cursor() noexcept = default;
+
+  constexpr deque_cursor(T *const *map, std::ptrdiff_t pos) noexcept
+      : m_map(map), m_pos(pos) {}
+
+  T &operator*() const noexcept {
+    const auto pos = static_cast<size_t>(m_pos);
+    return m_map[pos >> shift][pos & mask];
+  }
+
+  T &operator[](std::ptrdiff_t idx) const noexcept {
+    return *deque_cursor(m_map, m_pos + idx);
+  }
+
+  explicit operator T *() const noexcept { return &**this; }
+
+  explicit constexpr operator bool() const noexcept {
+    return m_map != nullptr;
+  }
+
+  constexpr deque_cursor &operator+=(std::ptrdiff_t diff) noexcept {
+    m_pos += diff;
+    return *this;
+  }
+
+  friend constexpr deque_cursor operator+(const deque_cursor &c,
+                                          std::ptrdiff_t diff) noexcept {
+    return deque_cursor(c.m_map, c.m_pos + diff);
+  }
+
+  friend constexpr deque_cursor operator-(const deque_cursor &c,
+                                          std::ptrdiff_t diff) noexcept {
+    return deque_cursor(c.m_map, c.m_pos - diff);
+  }
+
+  friend constexpr std::ptrdiff_t operator-(const deque_cursor &lhs,
+                                            const deque_cursor &rhs) noexcept {
+    return lhs.m_pos - rhs.m_pos;
+  }
+
+  friend constexpr bool operator==(const deque_cursor &lhs,
+                                   const deque_cursor &rhs) noexcept {
+    return lhs.m_pos == rhs.m_pos;
+  }
+
+  friend constexpr bool operator!=(const deque_cursor &lhs,
+                                   const deque_cursor &rhs) noexcept {
+    return lhs.m_pos != rhs.m_pos;
+  }
+
+  friend constexpr bool operator!=(const deque_cursor &c,
+                                   std::nullptr_t) noexcept {
+    return c.m_map != nullptr;
+  }
+
+  friend constexpr bool operator<(const deque_cursor &lhs,
+                                  const deque_cursor &rhs) noexcept {
+    return lhs.m_pos < rhs.m_pos;
+  }
+
+  friend constexpr bool operator>(const deque_cursor &lhs,
+                                  const deque_cursor &rhs) noexcept {
+    return lhs.m_pos > rhs.m_pos;
+  }
+
+  friend constexpr bool operator<=(const deque_cursor &lhs,
+                                   const deque_cursor &rhs) noexcept {
+    return lhs.m_pos <= rhs.m_pos;
+  }
+
+  friend constexpr bool operator>=(const deque_cursor &lhs,
+                                   const deque_cursor &rhs) noexcept {
+    return lhs.m_pos >= rhs.m_pos;
+  }
+
+private:
+  T *const *m_map = nullptr;
+  std::ptrdiff_t m_pos = 0;
+};
+
+} // namespace detail
+
+template <typename Tp> class deque_const_iterator;
+
+template <typename Tp>
+class deque_iterator
+    : public iterator_wrapper<deque_iterator<Tp>, Tp, Tp &, Tp *,
+                              std::random_access_iterator_tag> {
+public:
+  constexpr deque_iterator() noexcept = default;
+
+  constexpr explicit deque_iterator(detail::deque_cursor<Tp> data) noexcept
+      : m_data(data) {}
+
+  constexpr operator deque_const_iterator<Tp>() const noexcept {
+    return deque_const_iterator<Tp>{m_data};
+  }
+
+  detail::deque_cursor<Tp> m_data;
+};
+
+template <typename Tp>
+class deque_const_iterator
+    : public iterator_wrapper<deque_const_iterator<Tp>, Tp, const Tp &,
+                              const Tp *, std::random_access_iterator_tag> {
+public:
+  constexpr deque_const_iterator() noexcept = default;
+
+  constexpr explicit deque_const_iterator(
+      detail::deque_cursor<Tp> data) noexcept
+      : m_data(data) {}
+
+  detail::deque_cursor<Tp> m_data;
+};
+
+/// Double-ended queue built from fixed-size blocks and a map of block
+/// pointers.
+///
+/// Pushing or popping at either end is O(1) and never moves existing
+/// elements, so references stay valid until their element is erased;
+/// iterators are invalidated by any insertion. Growing past the map
+/// copies only the block pointers. One emptied block is kept for reuse,
+/// so a queue that hovers around a block boundary does not keep
+/// allocating.
+template <typename Tp, typename Allocator = allocator<Tp>> class deque {
+public:
+  // types:
+  using value_type = Tp;
+  using allocator_type = Allocator;
+  using alloc_traits = allocator_traits<allocator_type>;
+  using pointer = typename alloc_traits::pointer;
+  using const_pointer = typename alloc_traits::const_pointer;
+  using reference = value_type &;
+  using const_reference = const value_type &;
+  using size_type = size_t;
+  using difference_type = std::ptrdiff_t;
+  using iterator = deque_iterator<value_type>;
+  using const_iterator = deque_const_iterator<value_type>;
+  using reverse_iterator = std::reverse_iterator<iterator>;
+  using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+  /// Number of elements per block.
+  static constexpr size_type block_size = size_type(1)
+                                          << detail::deque_block_shift<Tp>();
+
+private:
+  using cursor = detail::deque_cursor<value_type>;
+  using map_allocator_type =
+      typename alloc_traits::template rebind_alloc<pointer>;
+  using map_traits = allocator_traits<map_allocator_type>;
+
+  static constexpr size_type shift = cursor::shift;
+  static constexpr size_type mask = cursor::mask;
+
+public:
+  // construct/copy/destroy
+  deque() noexcept(noexcept(Allocator())) : deque(Allocator()) {}
+
+  explicit deque(const allocator_type &allocator) noexcept
+      : m_alloc(allocator) {}
+
+  explicit deque(size_type num,
+                 const allocator_type &allocator = allocator_type())
+      : m_alloc(allocator) {
+    UTL_TRY { resize(num); }
+    UTL_CATCH(...) {
+      release();
+      UTL_RETHROW;
+    }
+  }
+
+  deque(size_type num, const_reference val,
+        const allocator_type &allocator = allocator_type())
+      : m_alloc(allocator) {
+    UTL_TRY { resize(num, val); }
+    UTL_CATCH(...) {
+      release();
+      UTL_RETHROW;
+    }
+  }
+
+  template <typename InputIterator,
+            typename = typename iterator_traits<InputIterator>::iterator_category>
+  deque(InputIterator first, InputIterator last,
+        const allocator_type &allocator = allocator_type())
+      : m_alloc(allocator) {
+    UTL_TRY { append(first, last); }
+    UTL_CATCH(...) {
+      release();
+      UTL_RETHROW;
+    }
+  }
+
+  deque(initializer_list<value_type> il,
+        const allocator_type &allocator = allocator_type())
+      : deque(il.begin(), il.end(), allocator) {}
+
+  deque(const deque &other)
+      : deque(other, alloc_traits::select_on_container_copy_construction(
+                         other.m_alloc)) {}
+
+  deque(const deque &other, const allocator_type &allocator)
+      : deque(other.begin(), other.end(), allocator) {}
+
+  deque(deque &&other) noexcept : m_alloc(std::move(other.m_alloc)) {
+    steal(other);
+  }
+
+  deque(deque &&other, const allocator_type &allocator) : m_alloc(allocator) {
+    if (alloc_traits::is_always_equal::value || m_alloc == other.m_alloc) {
+      steal(other);
+    } else {
+      UTL_TRY {
+        append(std::make_move_iterator(other.begin()),
+               std::make_move_iterator(other.end()));
+      }
+      UTL_CATCH(...) {
+        release();
+        UTL_RETHROW;
+      }
+    }
+  }
+
+  ~deque() { release(); }
+
+  deque &operator=(const deque &other) {
+    if (this == &other)
+      return *this;
+    if constexpr (alloc_traits::propagate_on_container_copy_assignment::value) {
+      if (m_alloc != other.m_alloc)
+        release();
+      m_alloc = other.m_alloc;
+    }
+    assign(other.begin(), other.end());
+    return *this;
+  }
+
+  deque &operator=(deque &&other) noexcept(
+      alloc_traits::propagate_on_container_move_assignment::value ||
+      alloc_traits::is_always_equal::value) {
+    if (this == &other)
+      return *this;
+    if (alloc_traits::propagate_on_container_move_assignment::value ||
+        m_alloc == other.m_alloc) {
+      release();
+      if constexpr (alloc_traits::propagate_on_container_move_assignment::
+                        value)
+        m_alloc = std::move(other.m_alloc);
+      steal(other);
+    } else {
+      assign(std::make_move_iterator(other.begin()),
+             std::make_move_iterator(other.end()));
+    }
+    return *this;
+  }
+
+  deque &operator=(initializer_list<value_type> il) {
+    assign(il.begin(), il.end());
+    return *this;
+  }
+
+  template <typename InputIterator,
+            typename = typename iterator_traits<InputIterator>::iterator_category>
+  void assign(InputIterator first, InputIterator last) {
+    clear();
+    append(first, last);
+  }
+
+  void assign(size_type num, const_reference val) {
+    clear();
+    resize(num, val);
+  }
+
+  void assign(initializer_list<value_type> il) { assign(il.begin(), il.end()); }
+
+  allocator_type get_allocator() const noexcept { return m_alloc; }
+
+  // iterators:
+  iterator begin() noexcept { return iterator{cursor(m_map, m_start)}; }
+  const_iterator begin() const noexcept {
+    return const_iterator{cursor(m_map, m_start)};
+  }
+  iterator end() noexcept { return iterator{cursor(m_map, m_start + m_size)}; }
+  const_iterator end() const noexcept {
+    return const_iterator{cursor(m_map, m_start + m_size)};
+  }
+  reverse_iterator rbegin() noexcept { return reverse_iterator(end()); }
+  const_reverse_iterator rbegin() const noexcept {
+    return const_reverse_iterator(end());
+  }
+  reverse_iterator rend() noexcept { return reverse_iterator(begin()); }
+  const_reverse_iterator rend() const noexcept {
+    return const_reverse_iterator(begin());
+  }
+  const_iterator cbegin() const noexcept { return begin(); }
+  const_iterator cend() const noexcept { return end(); }
+  const_reverse_iterator crbegin() const noexcept { return rbegin(); }
+  const_reverse_iterator crend() const noexcept { return rend(); }
+
+  // capacity
+  bool empty() const noexcept { return m_size == 0; }
+  size_type size() const noexcept { return m_size; }
+  size_type max_size() const noexcept {
+    return alloc_traits::max_size(m_alloc);
+  }
+
+  void resize(size_type size) {
+    while (m_size < size)
+      emplace_back();
+    while (m_size > size)
+      pop_back();
+  }
+
+  void resize(size_type size, const_reference val) {
+    while (m_size < size)
+      emplace_back(val);
+    while (m_size > size)
+      pop_back();
+  }
+
+  /// Frees the cached spare block.
+  void shrink_to_fit() noexcept {
+    if (m_spare) {
+      alloc_traits::deallocate(m_alloc, m_spare, block_size);
+      m_spare = nullptr;
+    }
+  }
+
+  // element access:
+  reference operator[](size_type num) { return element(m_start + num); }
+  const_reference operator[](size_type num) const {
+    return element(m_start + num);
+  }
+  reference at(size_type num) {
+    if (num < m_size)
+      return element(m_start + num);
+    UTL_THROW(std::out_of_range("deque::at"));
+  }
+  const_reference at(size_type num) const {
+    if (num < m_size)
+      return element(m_start + num);
+    UTL_THROW(std::out_of_range("deque::at"));
+  }
+  reference front() { return element(m_start); }
+  const_reference front() const { return element(m_start); }
+  reference back() { return element(m_start + m_size - 1); }
+  const_reference back() const { return element(m_start + m_size - 1); }
+
+  // modifiers
+  template <typename... Args> reference emplace_back(Args &&... args) {
+    const size_type pos = m_start + m_size;
+    if (m_size && (pos & mask)) {
+      alloc_traits::construct(m_alloc, &element(pos),
+                              std::forward<Args>(args)...);
+    } else {
+      // The new element starts a block.
+      if (!m_size)
+        m_start &= ~mask;
+      reserve_map(0, 1);
+      construct_in_new_block(m_start + m_size, std::forward<Args>(args)...);
+    }
+    ++m_size;
+    return back();
+  }
+
+  template <typename... Args> reference emplace_front(Args &&... args) {
+    if (m_size && (m_start & mask)) {
+      alloc_traits::construct(m_alloc, &element(m_start - 1),
+                              std::forward<Args>(args)...);
+    } else {
+      // The new element ends a block.
+      if (!m_size)
+        m_start &= ~mask;
+      reserve_map(1, 0);
+      construct_in_new_block(m_start - 1, std::forward<Args>(args)...);
+    }
+    --m_start;
+    ++m_size;
+    return front();
+  }
+
+  void push_back(const_reference elem) { emplace_back(elem); }
+  void push_back(value_type &&elem) { emplace_back(std::move(elem)); }
+  void push_front(const_reference elem) { emplace_front(elem); }
+  void push_front(value_type &&elem) { emplace_front(std::move(elem)); }
+
+  void pop_back() noexcept {
+    const size_type pos = m_start + --m_size;
+    alloc_traits::destroy(m_alloc, &element(pos));
+    if (!m_size || !(pos & mask))
+      release_block(m_map[pos >> shift]);
+  }
+
+  void pop_front() noexcept {
+    const size_type pos = m_start++;
+    --m_size;
+    alloc_traits::destroy(m_alloc, &element(pos));
+    if (!m_size || !(m_start & mask))
+      release_block(m_map[pos >> shift]);
+  }
+
+  /// Builds the element at whichever end is nearer `position` and rotates
+  /// it into place.
+  template <typename... Args>
+  iterator emplace(const_iterator position, Args &&... args) {
+    const size_type idx = position - cbegin();
+    if (idx < m_size / 2) {
+      emplace_front(std::forward<Args>(args)...);
+      std::rotate(begin(), begin() + 1, begin() + idx + 1);
+    } else {
+      emplace_back(std::forward<Args>(args)...);
+      std::rotate(begin() + idx, end() - 1, end());
+    }
+    return begin() + idx;
+  }
+
+  iterator insert(const_iterator position, const_reference elem) {
+    return emplace(position, elem);
+  }
+
+  iterator insert(const_iterator position, value_type &&elem) {
+    return emplace(position, std::move(elem));
+  }
+
+  iterator insert(const_iterator position, size_type num,
+                  const_reference elem) {
+    const size_type idx = position - cbegin();
+    const size_type size = m_size;
+    UTL_TRY { resize(size + num, elem); }
+    UTL_CATCH(...) {
+      resize(size);
+      UTL_RETHROW;
+    }
+    std::rotate(begin() + idx, begin() + size, end());
+    return begin() + idx;
+  }
+
+  template <typename InputIterator,
+            typename = typename iterator_traits<InputIterator>::iterator_category>
+  iterator insert(const_iterator position, InputIterator first,
+                  InputIterator last) {
+    const size_type idx = position - cbegin();
+    const size_type size = m_size;
+    UTL_TRY { append(first, last); }
+    UTL_CATCH(...) {
+      resize(size);
+      UTL_RETHROW;
+    }
+    std::rotate(begin() + idx, begin() + size, end());
+    return begin() + idx;
+  }
+
+  iterator insert(const_iterator position, initializer_list<value_type> il) {
+    return insert(position, il.begin(), il.end());
+  }
+
+  iterator erase(const_iterator position) {
+    return erase(position, position + 1);
+  }
+
+  /// Shifts whichever side of the gap is shorter.
+  iterator erase(const_iterator first, const_iterator last) {
+    const size_type idx = first - cbegin();
+    const size_type num = last - first;
+    if (idx < (m_size - num) / 2) {
+      std::move_backward(begin(), begin() + idx, begin() + idx + num);
+      for (size_type i = 0; i != num; ++i)
+        pop_front();
+    } else {
+      std::move(begin() + idx + num, end(), begin() + idx);
+      for (size_type i = 0; i != num; ++i)
+        pop_back();
+    }
+    return begin() + idx;
+  }
+
+  void swap(deque &other) noexcept {
+    using std::swap;
+    if constexpr (alloc_traits::propagate_on_container_swap::value)
+      swap(m_alloc, other.m_alloc);
+    else
+      assert(m_alloc == other.m_alloc);
+    swap(m_map, other.m_map);
+    swap(m_map_size, other.m_map_size);
+    swap(m_start, other.m_start);
+    swap(m_size, other.m_size);
+    swap(m_spare, other.m_spare);
+  }
+
+  void clear() noexcept {
+    if (!m_size)
+      return;
+    if constexpr (!std::is_trivially_destructible_v<value_type>)
+      for (size_type i = 0; i != m_size; ++i)
+        alloc_traits::destroy(m_alloc, &element(m_start + i));
+    const size_type last = (m_start + m_size - 1) >> shift;
+    for (size_type block = m_start >> shift; block <= last; ++block)
+      release_block(m_map[block]);
+    m_size = 0;
+  }
+
+private:
+  reference element(size_type pos) const noexcept {
+    return m_map[pos >> shift][pos & mask];
+  }
+
+  template <typename InputIterator>
+  void append(InputIterator first, InputIterator last) {
+    if constexpr (!std::is_same_v<typename iterator_traits<
+                                      InputIterator>::iterator_category,
+                                  std::input_iterator_tag>) {
+      const size_type num = std::distance(first, last);
+      reserve_map(0, (num + block_size - 1) / block_size + 1);
+    }
+    for (; first != last; ++first)
+      emplace_back(*first);
+  }
+
+  template <typename... Args>
+  void construct_in_new_block(size_type pos, Args &&... args) {
+    pointer &block = m_map[pos >> shift];
+    if (m_spare) {
+      block = m_spare;
+      m_spare = nullptr;
+    } else {
+      block = alloc_traits::allocate(m_alloc, block_size);
+    }
+    UTL_TRY {
+      alloc_traits::construct(m_alloc, &block[pos & mask],
+                              std::forward<Args>(args)...);
+    }
+    UTL_CATCH(...) {
+      release_block(block);
+      UTL_RETHROW;
+    }
+  }
+
+  void release_block(pointer block) noexcept {
+    if (!m_spare)
+      m_spare = block;
+    else
+      alloc_traits::deallocate(m_alloc, block, block_size);
+  }
+
+  /// Makes room in the map for `front` more blocks before the first used
+  /// one and `back` more after the last, recentring the used blocks or
+  /// moving them to a larger map.
+  void reserve_map(size_type front, size_type back) {
+    const size_type first = m_start >> shift;
+    const size_type last =
+        m_size ? ((m_start + m_size - 1) >> shift) + 1 : first;
+    if (first >= front && m_map_size - last >= back)
+      return;
+
+    const size_type used = last - first;
+    const size_type needed = used + front + back;
+    if (m_map_size >= 2 * needed) {
+      const size_type new_first = front + (m_map_size - needed) / 2;
+      if (used)
+        std::memmove(m_map + new_first, m_map + first, used * sizeof(pointer));
+      m_start = (new_first << shift) + (m_start & mask);
+      return;
+    }
+
+    map_allocator_type map_alloc(m_alloc);
+    const size_type new_size =
+        utl::max(utl::max(2 * m_map_size, 2 * needed), size_type(8));
+    pointer *const new_map = map_traits::allocate(map_alloc, new_size);
+    const size_type new_first = front + (new_size - needed) / 2;
+    if (used)
+      std::memcpy(new_map + new_first, m_map + first, used * sizeof(pointer));
+    if (m_map)
+      map_traits::deallocate(map_alloc, m_map, m_map_size);
+    m_map = new_map;
+    m_map_size = new_size;
+    m_start = (new_first << shift) + (m_start & mask);
+  }
+
+  /// Takes over the blocks of `other`, which must share our allocator.
+  void steal(deque &other) noexcept {
+    m_map = std::exchange(other.m_map, nullptr);
+    m_map_size = std::exchange(other.m_map_size, 0);
+    m_start = std::exchange(other.m_start, 0);
+    m_size = std::exchange(other.m_size, 0);
+    m_spare = std::exchange(other.m_spare, nullptr);
+  }
+
+  /// Destroys the elements and frees all memory.
+  void release() noexcept {
+    clear();
+    shrink_to_fit();
+    if (m_map) {
+      map_allocator_type map_alloc(m_alloc);
+      map_traits::deallocate(map_alloc, m_map, m_map_size);
+      m_map = nullptr;
+      m_map_size = 0;
+    }
+    m_start = 0;
+  }
+
+  allocator_type m_alloc;
+  pointer *m_map = nullptr;
+  size_type m_map_size = 0;
+  size_type m_start = 0;
+  size_type m_size = 0;
+  pointer m_spare = nullptr;
+};
+
+template <typename InputIterator,
+          typename Allocator =
+              allocator<typename iterator_traits<InputIterator>::value_type>>
+deque(InputIterator, InputIterator, Allocator = Allocator())
+    ->deque<typename iterator_traits<InputIterator>::value_type, Allocator>;
+
+template <typename Tp, typename Allocator>
+inline bool operator==(const deque<Tp, Allocator> &x,
+                       const deque<Tp, Allocator> &y) {
+  return x.size() == y.size() && std::equal(x.begin(), x.end(), y.begin());
+}
+
+template <typename Tp, typename Allocator>
+inline bool operator!=(const deque<Tp, Allocator> &x,
+                       const deque<Tp, Allocator> &y) {
+  return !(x == y);
+}
+
+template <typename Tp, typename Allocator>
+void swap(deque<Tp, Allocator> &x,
+          deque<Tp, Allocator> &y) noexcept(noexcept(x.swap(y))) {
+  x.swap(y);
+}
+
+template <typename Tp, typename Allocator>
+struct is_trivially_relocatable<deque<Tp, Allocator>>
+    : is_trivially_relocatable<Allocator> {};
+
+namespace pmr {
+template <typename T> class polymorphic_allocator;
+
+template <typename Tp>
+using deque = utl::deque<Tp, polymorphic_allocator<Tp>>;
+} // namespace pmr
+
+} // namespace utl
@@ -0,0 +1,109 @@
+#pragma once
+#include <utl/config.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+
+namespace utl {
+
+/// Execution policy asking for an operation to be split across threads,
+/// like std::execution::par.
+struct parallel_policy {
+  explicit constexpr parallel_policy() noexcept = default;
+};
+
+inline constexpr parallel_policy par{};
+
+/// Threads parallel operations run on, the calling thread included.
+size_t parallel_concurrency() noexcept;
+
+namespace detail {
+
+void parallel_invoke(size_t tasks, void (*fn)(void *, size_t),
+                     void *context);
+
+/// Elements per chunk when `count` elements of `elem_size` bytes are split
+/// across the pool: whole pages, at least 1 MiB, and no more chunks than
+/// threads. Returns `count` when splitting is not worth it.
+size_t parallel_chunk_size(size_t count, size_t elem_size) noexcept;
+
+} // namespace detail
+
+/// Calls `fn(i)` for each i in [0, tasks) on a shared pool of worker
+/// threads and the calling thread, and returns once all calls finished.
+/// `fn` must not throw. The pool starts on first use with one thread per
+/// core. Calls made while it is busy, including from inside a task, run
+/// on the calling thread.
+template <typename Fn> void parallel_for(size_t tasks, Fn &&fn) {
+  using F = std::remove_reference_t<Fn>;
+  detail::parallel_invoke(
+      tasks, [](void *context, size_t i) { (*static_cast<F *>(context))(i); },
+      const_cast<void *>(static_cast<const void *>(std::addressof(fn))));
+}
+
+namespace detail {
+
+/// Calls `fn(first, last)` for chunks of parallel_chunk_size elements that
+/// cover [0, count), in parallel. If any call throws, `undo(first, last)`
+/// is called for each chunk that completed and the first exception is
+/// rethrown once all calls have returned.
+template <typename Fn, typename Undo>
+void parallel_chunks(size_t count, size_t elem_size, Fn &&fn, Undo &&undo) {
+  const size_t step = parallel_chunk_size(count, elem_size);
+  const size_t chunks = step ? (count + step - 1) / step : 0;
+  if (chunks <= 1) {
+    if (count)
+      fn(size_t(0), count);
+    return;
+  }
+  const auto last = [&](size_t chunk) {
+    return count - chunk * step > step ? chunk * step + step : count;
+  };
+#if UTL_NO_EXCEPTIONS
+  parallel_for(chunks, [&](size_t chunk) { fn(chunk * step, last(chunk)); });
+#else
+  std::unique_ptr<bool[]> done(new bool[chunks]());
+  std::atomic<bool> failed{false};
+  std::exception_ptr error;
+  parallel_for(chunks, [&](size_t chunk) {
+    try {
+      fn(chunk * step, last(chunk));
+      done[chunk] = true;
+    } catch (...) {
+      if (!failed.exchange(true))
+        error = std::current_exception();
+    }
+  });
+  if (error) {
+    for (size_t chunk = 0; chunk != chunks; ++chunk)
+      if (done[chunk])
+        undo(chunk * step, last(chunk));
+    std::rethrow_exception(error);
+  }
+#endif
+}
+
+} // namespace detail
+
+/// Assigns `value` to every element of [first, last), one chunk of pages
+/// per thread.
+template <typename RandomAccessIterator, typename Tp>
+void fill(parallel_policy, RandomAccessIterator first,
+          RandomAccessIterator last, const Tp &value) {
+  using value_type =
+      typename std::iterator_traits<RandomAccessIterator>::value_type;
+  detail::parallel_chunks(
+      static_cast<size_t>(last - first), sizeof(value_type),
+      [&](size_t begin, size_t end) {
+        std::fill(first + static_cast<std::ptrdiff_t>(begin),
+                  first + static_cast<std::ptrdiff_t>(end), value);
+      },
+      [](size_t, size_t) {});
+}
+
+} // namespace utl
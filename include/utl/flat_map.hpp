@@ -0,0 +1,735 @@
+#pragma once
+#include <utl/algorithm.hpp>
+#include <utl/config.hpp>
+#include <utl/flat_set.hpp>
+#include <utl/vector.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace utl {
+
+/// Iterator over a flat_map: a key iterator and a mapped iterator moved in
+/// step. Dereferencing yields a pair of references.
+template <typename KeyIterator, typename MappedIterator>
+class flat_map_iterator {
+  using key_reference = typename std::iterator_traits<KeyIterator>::reference;
+  using mapped_reference =
+      typename std::iterator_traits<MappedIterator>::reference;
+
+public:
+  using value_type =
+      std::pair<typename std::iterator_traits<KeyIterator>::value_type,
+                typename std::iterator_traits<MappedIterator>::value_type>;
+  using reference = std::pair<key_reference, mapped_reference>;
+  using difference_type = std::ptrdiff_t;
+  // Like soa_iterator, a random access iterator over proxies.
+  using iterator_category = std::random_access_iterator_tag;
+
+  /// Holds the proxy so that `it->second` works.
+  struct pointer {
+    reference ref;
+    const reference *operator->() const noexcept { return &ref; }
+  };
+
+  constexpr flat_map_iterator() = default;
+
+  constexpr flat_map_iterator(KeyIterator key, MappedIterator mapped)
+      : m_key(key), m_mapped(mapped) {}
+
+  template <typename K, typename M,
+            typename = std::enable_if_t<
+                std::is_convertible_v<K, KeyIterator> &&
+                std::is_convertible_v<M, MappedIterator>>>
+  constexpr flat_map_iterator(const flat_map_iterator<K, M> &other)
+      : m_key(other.m_key), m_mapped(other.m_mapped) {}
+
+  reference operator*() const { return reference(*m_key, *m_mapped); }
+  pointer operator->() const { return pointer{**this}; }
+  reference operator[](difference_type diff) const {
+    return reference(m_key[diff], m_mapped[diff]);
+  }
+
+  constexpr KeyIterator key_iterator() const { return m_key; }
+  constexpr MappedIterator mapped_iterator() const { return m_mapped; }
+
+  constexpr flat_map_iterator &operator++() {
+    ++m_key;
+    ++m_mapped;
+    return *this;
+  }
+  constexpr flat_map_iterator operator++(int) {
+    const flat_map_iterator retval = *this;
+    ++*this;
+    return retval;
+  }
+  constexpr flat_map_iterator &operator--() {
+    --m_key;
+    --m_mapped;
+    return *this;
+  }
+  constexpr flat_map_iterator operator--(int) {
+    const flat_map_iterator retval = *this;
+    --*this;
+    return retval;
+  }
+  constexpr flat_map_iterator &operator+=(difference_type diff) {
+    m_key += diff;
+    m_mapped += diff;
+    return *this;
+  }
+  constexpr flat_map_iterator &operator-=(difference_type diff) {
+    m_key -= diff;
+    m_mapped -= diff;
+    return *this;
+  }
+
+  friend constexpr flat_map_iterator operator+(flat_map_iterator it,
+                                               difference_type diff) {
+    return it += diff;
+  }
+  friend constexpr flat_map_iterator operator+(difference_type diff,
+                                               flat_map_iterator it) {
+    return it += diff;
+  }
+  friend constexpr flat_map_iterator operator-(flat_map_iterator it,
+                                               difference_type diff) {
+    return it -= diff;
+  }
+  friend constexpr difference_type operator-(const flat_map_iterator &lhs,
+                                             const flat_map_iterator &rhs) {
+    return static_cast<difference_type>(lhs.m_key - rhs.m_key);
+  }
+
+  friend constexpr bool operator==(const flat_map_iterator &lhs,
+                                   const flat_map_iterator &rhs) {
+    return lhs.m_key == rhs.m_key;
+  }
+  friend constexpr bool operator!=(const flat_map_iterator &lhs,
+                                   const flat_map_iterator &rhs) {
+    return lhs.m_key != rhs.m_key;
+  }
+  friend constexpr bool operator<(const flat_map_iterator &lhs,
+                                  const flat_map_iterator &rhs) {
+    return lhs.m_key < rhs.m_key;
+  }
+  friend constexpr bool operator>(const flat_map_iterator &lhs,
+                                  const flat_map_iterator &rhs) {
+    return lhs.m_key > rhs.m_key;
+  }
+  friend constexpr bool operator<=(const flat_map_iterator &lhs,
+                                   const flat_map_iterator &rhs) {
+    return lhs.m_key <= rhs.m_key;
+  }
+  friend constexpr bool operator>=(const flat_map_iterator &lhs,
+                                   const flat_map_iterator &rhs) {
+    return lhs.m_key >= rhs.m_key;
+  }
+
+private:
+  template <typename, typename> friend class flat_map_iterator;
+
+  KeyIterator m_key{};
+  MappedIterator m_mapped{};
+};
+
+/// A map kept as two vectors in step: the sorted unique keys and, at the
+/// same positions, their mapped values.
+///
+/// Lookups are branchless binary searches that touch only the keys, so a
+/// search reads a fraction of the memory a node-based map or a vector of
+/// pairs would, and the map costs nothing per element beyond the keys and
+/// values themselves. Inserting or erasing a single element shifts the
+/// elements after it, so build large maps with the range constructors or
+/// insert(first, last), which sort the new elements and merge them in one
+/// pass. Iterators dereference to std::pair<const Key &, T &> proxies and
+/// are invalidated by every insertion and erasure. A bulk insertion that
+/// fails to allocate, or that throws while appending after the last key,
+/// leaves the map unchanged. If a comparison or move throws once elements
+/// are being merged between existing ones, the map is left empty.
+template <typename Key, typename T, typename Compare = std::less<Key>,
+          typename KeyContainer = vector<Key>,
+          typename MappedContainer = vector<T>>
+class flat_map {
+public:
+  // types:
+  using key_type = Key;
+  using mapped_type = T;
+  using value_type = std::pair<key_type, mapped_type>;
+  using key_compare = Compare;
+  using reference = std::pair<const key_type &, mapped_type &>;
+  using const_reference = std::pair<const key_type &, const mapped_type &>;
+  using size_type = typename KeyContainer::size_type;
+  using difference_type = std::ptrdiff_t;
+  using iterator =
+      flat_map_iterator<typename KeyContainer::const_iterator,
+                        typename MappedContainer::iterator>;
+  using const_iterator =
+      flat_map_iterator<typename KeyContainer::const_iterator,
+                        typename MappedContainer::const_iterator>;
+  using reverse_iterator = std::reverse_iterator<iterator>;
+  using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+  using key_container_type = KeyContainer;
+  using mapped_container_type = MappedContainer;
+
+  struct containers {
+    key_container_type keys;
+    mapped_container_type values;
+  };
+
+  // construct/copy/destroy
+  flat_map() = default;
+
+  explicit flat_map(const key_compare &comp) : m_comp(comp) {}
+
+  /// Sorts the elements by key and drops duplicate keys, keeping the
+  /// first of each. `keys` and `values` must have the same size.
+  flat_map(key_container_type keys, mapped_container_type values,
+           const key_compare &comp = key_compare())
+      : m_comp(comp) {
+    vector<value_type> elems;
+    elems.reserve(keys.size());
+    for (size_type i = 0; i != keys.size(); ++i)
+      elems.emplace_back(std::move(keys[i]), std::move(values[i]));
+    merge_unique(elems, false);
+  }
+
+  flat_map(sorted_unique_t, key_container_type keys,
+           mapped_container_type values,
+           const key_compare &comp = key_compare())
+      : m_keys(std::move(keys)), m_values(std::move(values)), m_comp(comp) {}
+
+  template <typename InputIterator,
+            typename = typename iterator_traits<InputIterator>::iterator_category>
+  flat_map(InputIterator first, InputIterator last,
+           const key_compare &comp = key_compare())
+      : m_comp(comp) {
+    insert(first, last);
+  }
+
+  template <typename InputIterator,
+            typename = typename iterator_traits<InputIterator>::iterator_category>
+  flat_map(sorted_unique_t, InputIterator first, InputIterator last,
+           const key_compare &comp = key_compare())
+      : m_comp(comp) {
+    insert(sorted_unique, first, last);
+  }
+
+  flat_map(std::initializer_list<value_type> il,
+           const key_compare &comp = key_compare())
+      : flat_map(il.begin(), il.end(), comp) {}
+
+  flat_map(sorted_unique_t, std::initializer_list<value_type> il,
+           const key_compare &comp = key_compare())
+      : flat_map(sorted_unique, il.begin(), il.end(), comp) {}
+
+  flat_map &operator=(std::initializer_list<value_type> il) {
+    clear();
+    insert(il);
+    return *this;
+  }
+
+  // iterators:
+  iterator begin() noexcept {
+    return iterator(m_keys.cbegin(), m_values.begin());
+  }
+  const_iterator begin() const noexcept {
+    return const_iterator(m_keys.cbegin(), m_values.cbegin());
+  }
+  iterator end() noexcept { return iterator(m_keys.cend(), m_values.end()); }
+  const_iterator end() const noexcept {
+    return const_iterator(m_keys.cend(), m_values.cend());
+  }
+  reverse_iterator rbegin() noexcept { return reverse_iterator(end()); }
+  const_reverse_iterator rbegin() const noexcept {
+    return const_reverse_iterator(end());
+  }
+  reverse_iterator rend() noexcept { return reverse_iterator(begin()); }
+  const_reverse_iterator rend() const noexcept {
+    return const_reverse_iterator(begin());
+  }
+  const_iterator cbegin() const noexcept { return begin(); }
+  const_iterator cend() const noexcept { return end(); }
+  const_reverse_iterator crbegin() const noexcept { return rbegin(); }
+  const_reverse_iterator crend() const noexcept { return rend(); }
+
+  // capacity
+  bool empty() const noexcept { return m_keys.empty(); }
+  size_type size() const noexcept { return m_keys.size(); }
+  size_type max_size() const noexcept {
+    return utl::min(m_keys.max_size(), m_values.max_size());
+  }
+  void reserve(size_type num) {
+    m_keys.reserve(num);
+    m_values.reserve(num);
+  }
+  void shrink_to_fit() {
+    m_keys.shrink_to_fit();
+    m_values.shrink_to_fit();
+  }
+
+  // element access:
+  mapped_type &operator[](const key_type &key) {
+    return try_emplace(key).first->second;
+  }
+  mapped_type &operator[](key_type &&key) {
+    return try_emplace(std::move(key)).first->second;
+  }
+  mapped_type &at(const key_type &key) {
+    const size_type idx = find_index(key);
+    if (idx == size())
+      UTL_THROW(std::out_of_range("flat_map::at"));
+    return m_values[idx];
+  }
+  const mapped_type &at(const key_type &key) const {
+    const size_type idx = find_index(key);
+    if (idx == size())
+      UTL_THROW(std::out_of_range("flat_map::at"));
+    return m_values[idx];
+  }
+
+  // modifiers
+  template <typename... Args>
+  std::pair<iterator, bool> emplace(Args &&... args) {
+    value_type elem(std::forward<Args>(args)...);
+    return try_emplace(std::move(elem.first), std::move(elem.second));
+  }
+
+  std::pair<iterator, bool> insert(const value_type &elem) {
+    return try_emplace(elem.first, elem.second);
+  }
+  std::pair<iterator, bool> insert(value_type &&elem) {
+    return try_emplace(std::move(elem.first), std::move(elem.second));
+  }
+
+  iterator insert(const_iterator, const value_type &elem) {
+    return insert(elem).first;
+  }
+  iterator insert(const_iterator, value_type &&elem) {
+    return insert(std::move(elem)).first;
+  }
+
+  /// Sorts the new elements by key and merges them into the map. Keys
+  /// already in the map, and repeats within the range, are dropped.
+  template <typename InputIterator,
+            typename = typename iterator_traits<InputIterator>::iterator_category>
+  void insert(InputIterator first, InputIterator last) {
+    vector<value_type> elems;
+    for (; first != last; ++first)
+      elems.emplace_back(*first);
+    merge_unique(elems, false);
+  }
+
+  /// Like insert(first, last) for a range sorted by key without repeats,
+  /// which skips sorting the new elements.
+  template <typename InputIterator,
+            typename = typename iterator_traits<InputIterator>::iterator_category>
+  void insert(sorted_unique_t, InputIterator first, InputIterator last) {
+    vector<value_type> elems;
+    for (; first != last; ++first)
+      elems.emplace_back(*first);
+    merge_unique(elems, true);
+  }
+
+  void insert(std::initializer_list<value_type> il) {
+    insert(il.begin(), il.end());
+  }
+  void insert(sorted_unique_t, std::initializer_list<value_type> il) {
+    insert(sorted_unique, il.begin(), il.end());
+  }
+
+  template <typename Range> void insert_range(Range &&range) {
+    using std::begin;
+    using std::end;
+    insert(begin(range), end(range));
+  }
+
+  template <typename... Args>
+  std::pair<iterator, bool> try_emplace(const key_type &key, Args &&... args) {
+    return try_emplace_impl(key, std::forward<Args>(args)...);
+  }
+  template <typename... Args>
+  std::pair<iterator, bool> try_emplace(key_type &&key, Args &&... args) {
+    return try_emplace_impl(std::move(key), std::forward<Args>(args)...);
+  }
+
+  template <typename M>
+  std::pair<iterator, bool> insert_or_assign(const key_type &key, M &&obj) {
+    return insert_or_assign_impl(key, std::forward<M>(obj));
+  }
+  template <typename M>
+  std::pair<iterator, bool> insert_or_assign(key_type &&key, M &&obj) {
+    return insert_or_assign_impl(std::move(key), std::forward<M>(obj));
+  }
+
+  /// Moves the keys and values out, leaving the map empty.
+  containers extract() && {
+    containers retval{std::move(m_keys), std::move(m_values)};
+    clear();
+    return retval;
+  }
+
+  /// Replaces the keys and values. The keys must be sorted and unique,
+  /// and both containers the same size.
+  void replace(key_container_type &&keys, mapped_container_type &&values) {
+    m_keys = std::move(keys);
+    m_values = std::move(values);
+  }
+
+  iterator erase(iterator position) { return erase(const_iterator(position)); }
+  iterator erase(const_iterator position) {
+    return erase(position, std::next(position));
+  }
+  iterator erase(const_iterator first, const_iterator last) {
+    const auto idx = first - cbegin();
+    const auto num = last - first;
+    m_keys.erase(m_keys.cbegin() + idx, m_keys.cbegin() + idx + num);
+    m_values.erase(m_values.cbegin() + idx, m_values.cbegin() + idx + num);
+    return begin() + idx;
+  }
+  size_type erase(const key_type &key) {
+    const size_type idx = find_index(key);
+    if (idx == size())
+      return 0;
+    erase(cbegin() + static_cast<difference_type>(idx));
+    return 1;
+  }
+
+  void swap(flat_map &other) noexcept(
+      std::is_nothrow_swappable_v<key_container_type> &&
+      std::is_nothrow_swappable_v<mapped_container_type> &&
+      std::is_nothrow_swappable_v<key_compare>) {
+    using std::swap;
+    swap(m_keys, other.m_keys);
+    swap(m_values, other.m_values);
+    swap(m_comp, other.m_comp);
+  }
+
+  void clear() noexcept {
+    m_keys.clear();
+    m_values.clear();
+  }
+
+  // observers
+  key_compare key_comp() const { return m_comp; }
+  const key_container_type &keys() const noexcept { return m_keys; }
+  const mapped_container_type &values() const noexcept { return m_values; }
+
+  // lookup
+  iterator find(const key_type &key) { return begin() + find_offset(key); }
+  const_iterator find(const key_type &key) const {
+    return begin() + find_offset(key);
+  }
+  template <typename K, typename C = Compare,
+            typename = typename C::is_transparent>
+  iterator find(const K &key) {
+    return begin() + find_offset(key);
+  }
+  template <typename K, typename C = Compare,
+            typename = typename C::is_transparent>
+  const_iterator find(const K &key) const {
+    return begin() + find_offset(key);
+  }
+
+  size_type count(const key_type &key) const { return contains(key); }
+  template <typename K, typename C = Compare,
+            typename = typename C::is_transparent>
+  size_type count(const K &key) const {
+    const auto range = equal_range(key);
+    return static_cast<size_type>(range.second - range.first);
+  }
+
+  bool contains(const key_type &key) const {
+    return find_index(key) != size();
+  }
+  template <typename K, typename C = Compare,
+            typename = typename C::is_transparent>
+  bool contains(const K &key) const {
+    return find_index(key) != size();
+  }
+
+  iterator lower_bound(const key_type &key) {
+    return begin() + lower_offset(key);
+  }
+  const_iterator lower_bound(const key_type &key) const {
+    return begin() + lower_offset(key);
+  }
+  template <typename K, typename C = Compare,
+            typename = typename C::is_transparent>
+  iterator lower_bound(const K &key) {
+    return begin() + lower_offset(key);
+  }
+  template <typename K, typename C = Compare,
+            typename = typename C::is_transparent>
+  const_iterator lower_bound(const K &key) const {
+    return begin() + lower_offset(key);
+  }
+
+  iterator upper_bound(const key_type &key) {
+    return begin() + upper_offset(key);
+  }
+  const_iterator upper_bound(const key_type &key) const {
+    return begin() + upper_offset(key);
+  }
+  template <typename K, typename C = Compare,
+            typename = typename C::is_transparent>
+  iterator upper_bound(const K &key) {
+    return begin() + upper_offset(key);
+  }
+  template <typename K, typename C = Compare,
+            typename = typename C::is_transparent>
+  const_iterator upper_bound(const K &key) const {
+    return begin() + upper_offset(key);
+  }
+
+  std::pair<iterator, iterator> equal_range(const key_type &key) {
+    return {lower_bound(key), upper_bound(key)};
+  }
+  std::pair<const_iterator, const_iterator>
+  equal_range(const key_type &key) const {
+    return {lower_bound(key), upper_bound(key)};
+  }
+  template <typename K, typename C = Compare,
+            typename = typename C::is_transparent>
+  std::pair<iterator, iterator> equal_range(const K &key) {
+    return {lower_bound(key), upper_bound(key)};
+  }
+  template <typename K, typename C = Compare,
+            typename = typename C::is_transparent>
+  std::pair<const_iterator, const_iterator> equal_range(const K &key) const {
+    return {lower_bound(key), upper_bound(key)};
+  }
+
+private:
+  template <typename K, typename M, typename C, typename KC, typename MC,
+            typename Predicate>
+  friend typename flat_map<K, M, C, KC, MC>::size_type
+  erase_if(flat_map<K, M, C, KC, MC> &map, Predicate pred);
+
+  template <typename K> difference_type lower_offset(const K &key) const {
+    return utl::lower_bound(m_keys.cbegin(), m_keys.cend(), key, m_comp) -
+           m_keys.cbegin();
+  }
+
+  template <typename K> difference_type upper_offset(const K &key) const {
+    return utl::upper_bound(m_keys.cbegin(), m_keys.cend(), key, m_comp) -
+           m_keys.cbegin();
+  }
+
+  /// Index of the element with `key`, or size() if there is none.
+  template <typename K> size_type find_index(const K &key) const {
+    const auto idx = static_cast<size_type>(lower_offset(key));
+    return idx != size() && !m_comp(key, m_keys[idx]) ? idx : size();
+  }
+
+  template <typename K> difference_type find_offset(const K &key) const {
+    return static_cast<difference_type>(find_index(key));
+  }
+
+  template <typename K, typename... Args>
+  std::pair<iterator, bool> try_emplace_impl(K &&key, Args &&... args) {
+    const auto idx = static_cast<size_type>(lower_offset(key));
+    if (idx != size() && !m_comp(key, m_keys[idx]))
+      return {begin() + static_cast<difference_type>(idx), false};
+    return {emplace_at(idx, std::forward<K>(key), std::forward<Args>(args)...),
+            true};
+  }
+
+  template <typename K, typename M>
+  std::pair<iterator, bool> insert_or_assign_impl(K &&key, M &&obj) {
+    const auto idx = static_cast<size_type>(lower_offset(key));
+    if (idx != size() && !m_comp(key, m_keys[idx])) {
+      m_values[idx] = std::forward<M>(obj);
+      return {begin() + static_cast<difference_type>(idx), false};
+    }
+    return {emplace_at(idx, std::forward<K>(key), std::forward<M>(obj)), true};
+  }
+
+  /// Inserts a key and its value at `idx`; if the value cannot be
+  /// inserted, the key is taken out again.
+  template <typename K, typename... Args>
+  iterator emplace_at(size_type idx, K &&key, Args &&... args) {
+    const auto pos = static_cast<difference_type>(idx);
+    m_keys.emplace(m_keys.cbegin() + pos, std::forward<K>(key));
+    UTL_TRY {
+      m_values.emplace(m_values.cbegin() + pos, std::forward<Args>(args)...);
+    }
+    UTL_CATCH(...) {
+      m_keys.erase(m_keys.cbegin() + pos);
+      UTL_RETHROW;
+    }
+    return begin() + pos;
+  }
+
+  /// Sorts `elems` by key unless `sorted`, drops repeated keys and merges
+  /// the rest into the map in one pass. Of equal keys the one already in
+  /// the map, or else the first inserted, is kept. New elements that all
+  /// sort after the map's are appended in place; otherwise both
+  /// containers are rebuilt.
+  void merge_unique(vector<value_type> &elems, bool sorted) {
+    const auto key_less = [this](const value_type &x, const value_type &y) {
+      return m_comp(x.first, y.first);
+    };
+    if (!sorted)
+      std::stable_sort(elems.begin(), elems.end(), key_less);
+    const auto key_equal = [this](const value_type &x, const value_type &y) {
+      return !m_comp(x.first, y.first) && !m_comp(y.first, x.first);
+    };
+    elems.erase(std::unique(elems.begin(), elems.end(), key_equal),
+                elems.end());
+    if (elems.empty())
+      return;
+
+    if (empty() || m_comp(m_keys.back(), elems.front().first)) {
+      const size_type old_size = size();
+      reserve(old_size + elems.size());
+      UTL_TRY {
+        for (auto &elem : elems) {
+          m_keys.push_back(std::move(elem.first));
+          m_values.push_back(std::move(elem.second));
+        }
+      }
+      UTL_CATCH(...) {
+        truncate(old_size);
+        UTL_RETHROW;
+      }
+      return;
+    }
+
+    key_container_type keys;
+    mapped_container_type values;
+    keys.reserve(size() + elems.size());
+    values.reserve(size() + elems.size());
+    UTL_TRY {
+      size_type i = 0;
+      auto it = elems.begin();
+      while (i != size() && it != elems.end()) {
+        if (m_comp(it->first, m_keys[i])) {
+          keys.push_back(std::move(it->first));
+          values.push_back(std::move(it->second));
+          ++it;
+        } else {
+          if (!m_comp(m_keys[i], it->first))
+            ++it;
+          keys.push_back(std::move(m_keys[i]));
+          values.push_back(std::move(m_values[i]));
+          ++i;
+        }
+      }
+      for (; i != size(); ++i) {
+        keys.push_back(std::move(m_keys[i]));
+        values.push_back(std::move(m_values[i]));
+      }
+      for (; it != elems.end(); ++it) {
+        keys.push_back(std::move(it->first));
+        values.push_back(std::move(it->second));
+      }
+      m_keys = std::move(keys);
+      m_values = std::move(values);
+    }
+    UTL_CATCH(...) {
+      // Nothing has been moved out of the map until a key was pushed.
+      if (!keys.empty())
+        clear();
+      UTL_RETHROW;
+    }
+  }
+
+  /// Erases the elements from `num` on, in both containers.
+  void truncate(size_type num) noexcept {
+    m_keys.erase(m_keys.begin() + static_cast<difference_type>(num),
+                 m_keys.end());
+    m_values.erase(m_values.begin() + static_cast<difference_type>(num),
+                   m_values.end());
+  }
+
+  void move_element(size_type to, size_type from) {
+    if (to != from) {
+      m_keys[to] = std::move(m_keys[from]);
+      m_values[to] = std::move(m_values[from]);
+    }
+  }
+
+  /// Compacts the elements for which `pred` does not hold to the front of
+  /// both containers. If `pred` throws, the elements it has not seen are
+  /// kept; if a move throws, the map is left empty.
+  template <typename Predicate> size_type erase_where(Predicate &pred) {
+    const size_type num = size();
+    size_type kept = 0;
+    size_type i = 0;
+    bool moving = false;
+    UTL_TRY {
+      for (; i != num; ++i) {
+        if (pred(const_reference(m_keys[i], m_values[i])))
+          continue;
+        moving = true;
+        move_element(kept++, i);
+        moving = false;
+      }
+      truncate(kept);
+    }
+    UTL_CATCH(...) {
+      if (moving) {
+        clear();
+        UTL_RETHROW;
+      }
+      UTL_TRY {
+        for (; i != num; ++i)
+          move_element(kept++, i);
+        truncate(kept);
+      }
+      UTL_CATCH(...) { clear(); }
+      UTL_RETHROW;
+    }
+    return num - kept;
+  }
+
+  key_container_type m_keys;
+  mapped_container_type m_values;
+  key_compare m_comp;
+};
+
+template <typename Key, typename T, typename Compare, typename KeyContainer,
+          typename MappedContainer>
+inline bool
+operator==(const flat_map<Key, T, Compare, KeyContainer, MappedContainer> &x,
+           const flat_map<Key, T, Compare, KeyContainer, MappedContainer> &y) {
+  return x.keys() == y.keys() && x.values() == y.values();
+}
+
+template <typename Key, typename T, typename Compare, typename KeyContainer,
+          typename MappedContainer>
+inline bool
+operator!=(const flat_map<Key, T, Compare, KeyContainer, MappedContainer> &x,
+           const flat_map<Key, T, Compare, KeyContainer, MappedContainer> &y) {
+  return !(x == y);
+}
+
+/// Erases the elements for which `pred(const_reference)` holds and returns
+/// how many were erased. If `pred` throws, the elements it chose are
+/// erased and the rest are kept.
+template <typename Key, typename T, typename Compare, typename KeyContainer,
+          typename MappedContainer, typename Predicate>
+typename flat_map<Key, T, Compare, KeyContainer, MappedContainer>::size_type
+erase_if(flat_map<Key, T, Compare, KeyContainer, MappedContainer> &map,
+         Predicate pred) {
+  return map.erase_where(pred);
+}
+
+template <typename Key, typename T, typename Compare, typename KeyContainer,
+          typename MappedContainer>
+inline void
+swap(flat_map<Key, T, Compare, KeyContainer, MappedContainer> &x,
+     flat_map<Key, T, Compare, KeyContainer, MappedContainer> &y) noexcept(
+    noexcept(x.swap(y))) {
+  x.swap(y);
+}
+
+} // namespace utl
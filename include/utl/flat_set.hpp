@@ -0,0 +1,386 @@
+#pragma once
+#include <utl/algorithm.hpp>
+#include <utl/config.hpp>
+#include <utl/vector.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+
+namespace utl {
+
+/// Tag for flat_set and flat_map constructors and inserts whose input is
+/// already sorted and free of duplicates. The input is trusted, not
+/// checked.
+struct sorted_unique_t {
+  explicit sorted_unique_t() = default;
+};
+
+inline constexpr sorted_unique_t sorted_unique{};
+
+namespace detail {
+
+template <typename Container, typename Predicate>
+typename Container::size_type erase_if_container(Container &cont,
+                                                 Predicate &pred) {
+  const auto it = std::remove_if(cont.begin(), cont.end(), pred);
+  const auto num = static_cast<typename Container::size_type>(cont.end() - it);
+  cont.erase(it, cont.end());
+  return num;
+}
+
+template <typename Tp, typename Allocator, typename GrowthPolicy,
+          typename SizeType, typename Predicate>
+typename vector<Tp, Allocator, GrowthPolicy, SizeType>::size_type
+erase_if_container(vector<Tp, Allocator, GrowthPolicy, SizeType> &vec,
+                   Predicate &pred) {
+  return utl::erase_if(vec, pred);
+}
+
+} // namespace detail
+
+/// A set kept as a sorted vector of unique keys.
+///
+/// Lookups are branchless binary searches over contiguous keys, and the
+/// set costs one container of keys and nothing per element. Inserting or
+/// erasing a single key shifts the keys after it, so build large sets
+/// with the range constructors or insert(first, last), which sort the new
+/// keys and merge them in one pass. Iterators are invalidated by every
+/// insertion and erasure. If a comparison or move throws while keys are
+/// being merged, the set is left empty.
+template <typename Key, typename Compare = std::less<Key>,
+          typename KeyContainer = vector<Key>>
+class flat_set {
+public:
+  // types:
+  using key_type = Key;
+  using value_type = Key;
+  using key_compare = Compare;
+  using value_compare = Compare;
+  using reference = value_type &;
+  using const_reference = const value_type &;
+  using size_type = typename KeyContainer::size_type;
+  using difference_type = typename KeyContainer::difference_type;
+  using iterator = typename KeyContainer::const_iterator;
+  using const_iterator = typename KeyContainer::const_iterator;
+  using reverse_iterator = std::reverse_iterator<iterator>;
+  using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+  using container_type = KeyContainer;
+
+  // construct/copy/destroy
+  flat_set() = default;
+
+  explicit flat_set(const key_compare &comp) : m_comp(comp) {}
+
+  /// Sorts `keys` and drops duplicates, keeping the first of each.
+  explicit flat_set(container_type keys,
+                    const key_compare &comp = key_compare())
+      : m_keys(std::move(keys)), m_comp(comp) {
+    merge_unique(0, false);
+  }
+
+  flat_set(sorted_unique_t, container_type keys,
+           const key_compare &comp = key_compare())
+      : m_keys(std::move(keys)), m_comp(comp) {}
+
+  template <typename InputIterator,
+            typename = typename iterator_traits<InputIterator>::iterator_category>
+  flat_set(InputIterator first, InputIterator last,
+           const key_compare &comp = key_compare())
+      : m_comp(comp) {
+    insert(first, last);
+  }
+
+  template <typename InputIterator,
+            typename = typename iterator_traits<InputIterator>::iterator_category>
+  flat_set(sorted_unique_t, InputIterator first, InputIterator last,
+           const key_compare &comp = key_compare())
+      : m_comp(comp) {
+    m_keys.insert(m_keys.end(), first, last);
+  }
+
+  flat_set(std::initializer_list<value_type> il,
+           const key_compare &comp = key_compare())
+      : flat_set(il.begin(), il.end(), comp) {}
+
+  flat_set(sorted_unique_t, std::initializer_list<value_type> il,
+           const key_compare &comp = key_compare())
+      : flat_set(sorted_unique, il.begin(), il.end(), comp) {}
+
+  flat_set &operator=(std::initializer_list<value_type> il) {
+    clear();
+    insert(il);
+    return *this;
+  }
+
+  // iterators:
+  iterator begin() const noexcept { return m_keys.begin(); }
+  iterator end() const noexcept { return m_keys.end(); }
+  reverse_iterator rbegin() const noexcept { return reverse_iterator(end()); }
+  reverse_iterator rend() const noexcept { return reverse_iterator(begin()); }
+  const_iterator cbegin() const noexcept { return begin(); }
+  const_iterator cend() const noexcept { return end(); }
+  const_reverse_iterator crbegin() const noexcept { return rbegin(); }
+  const_reverse_iterator crend() const noexcept { return rend(); }
+
+  // capacity
+  bool empty() const noexcept { return m_keys.empty(); }
+  size_type size() const noexcept { return m_keys.size(); }
+  size_type max_size() const noexcept { return m_keys.max_size(); }
+  void reserve(size_type num) { m_keys.reserve(num); }
+  void shrink_to_fit() { m_keys.shrink_to_fit(); }
+
+  // modifiers
+  template <typename... Args>
+  std::pair<iterator, bool> emplace(Args &&... args) {
+    return insert_unique(value_type(std::forward<Args>(args)...));
+  }
+
+  template <typename... Args>
+  iterator emplace_hint(const_iterator hint, Args &&... args) {
+    return insert_hint(hint, value_type(std::forward<Args>(args)...));
+  }
+
+  std::pair<iterator, bool> insert(const value_type &key) {
+    return insert_unique(key);
+  }
+  std::pair<iterator, bool> insert(value_type &&key) {
+    return insert_unique(std::move(key));
+  }
+
+  iterator insert(const_iterator hint, const value_type &key) {
+    return insert_hint(hint, key);
+  }
+  iterator insert(const_iterator hint, value_type &&key) {
+    return insert_hint(hint, std::move(key));
+  }
+
+  /// Appends the keys, sorts them and merges them into the set. Keys
+  /// already in the set, and repeats within the range, are dropped.
+  template <typename InputIterator,
+            typename = typename iterator_traits<InputIterator>::iterator_category>
+  void insert(InputIterator first, InputIterator last) {
+    const size_type num = size();
+    m_keys.insert(m_keys.end(), first, last);
+    merge_unique(num, false);
+  }
+
+  /// Like insert(first, last) for a sorted range without repeats, which
+  /// skips sorting the new keys.
+  template <typename InputIterator,
+            typename = typename iterator_traits<InputIterator>::iterator_category>
+  void insert(sorted_unique_t, InputIterator first, InputIterator last) {
+    const size_type num = size();
+    m_keys.insert(m_keys.end(), first, last);
+    merge_unique(num, true);
+  }
+
+  void insert(std::initializer_list<value_type> il) {
+    insert(il.begin(), il.end());
+  }
+  void insert(sorted_unique_t, std::initializer_list<value_type> il) {
+    insert(sorted_unique, il.begin(), il.end());
+  }
+
+  template <typename Range> void insert_range(Range &&range) {
+    using std::begin;
+    using std::end;
+    insert(begin(range), end(range));
+  }
+
+  /// Moves the keys out, leaving the set empty.
+  container_type extract() && {
+    container_type keys = std::move(m_keys);
+    m_keys.clear();
+    return keys;
+  }
+
+  /// Replaces the keys, which must be sorted and unique.
+  void replace(container_type &&keys) { m_keys = std::move(keys); }
+
+  iterator erase(const_iterator position) { return m_keys.erase(position); }
+  iterator erase(const_iterator first, const_iterator last) {
+    return m_keys.erase(first, last);
+  }
+  size_type erase(const key_type &key) {
+    const auto range = equal_range(key);
+    const auto num = static_cast<size_type>(range.second - range.first);
+    erase(range.first, range.second);
+    return num;
+  }
+
+  void swap(flat_set &other) noexcept(
+      std::is_nothrow_swappable_v<container_type> &&
+      std::is_nothrow_swappable_v<key_compare>) {
+    using std::swap;
+    swap(m_keys, other.m_keys);
+    swap(m_comp, other.m_comp);
+  }
+
+  void clear() noexcept { m_keys.clear(); }
+
+  // observers
+  key_compare key_comp() const { return m_comp; }
+  value_compare value_comp() const { return m_comp; }
+  const container_type &keys() const noexcept { return m_keys; }
+
+  // lookup
+  iterator find(const key_type &key) const { return find_impl(key); }
+  template <typename K, typename C = Compare,
+            typename = typename C::is_transparent>
+  iterator find(const K &key) const {
+    return find_impl(key);
+  }
+
+  size_type count(const key_type &key) const { return contains(key); }
+  template <typename K, typename C = Compare,
+            typename = typename C::is_transparent>
+  size_type count(const K &key) const {
+    const auto range = equal_range(key);
+    return static_cast<size_type>(range.second - range.first);
+  }
+
+  bool contains(const key_type &key) const { return find(key) != end(); }
+  template <typename K, typename C = Compare,
+            typename = typename C::is_transparent>
+  bool contains(const K &key) const {
+    return find(key) != end();
+  }
+
+  iterator lower_bound(const key_type &key) const {
+    return utl::lower_bound(begin(), end(), key, m_comp);
+  }
+  template <typename K, typename C = Compare,
+            typename = typename C::is_transparent>
+  iterator lower_bound(const K &key) const {
+    return utl::lower_bound(begin(), end(), key, m_comp);
+  }
+
+  iterator upper_bound(const key_type &key) const {
+    return utl::upper_bound(begin(), end(), key, m_comp);
+  }
+  template <typename K, typename C = Compare,
+            typename = typename C::is_transparent>
+  iterator upper_bound(const K &key) const {
+    return utl::upper_bound(begin(), end(), key, m_comp);
+  }
+
+  std::pair<iterator, iterator> equal_range(const key_type &key) const {
+    return equal_range_impl(key);
+  }
+  template <typename K, typename C = Compare,
+            typename = typename C::is_transparent>
+  std::pair<iterator, iterator> equal_range(const K &key) const {
+    return equal_range_impl(key);
+  }
+
+private:
+  template <typename K> iterator find_impl(const K &key) const {
+    const iterator it = lower_bound(key);
+    return it != end() && !m_comp(key, *it) ? it : end();
+  }
+
+  template <typename K>
+  std::pair<iterator, iterator> equal_range_impl(const K &key) const {
+    const iterator it = lower_bound(key);
+    if (it == end() || m_comp(key, *it))
+      return {it, it};
+    // A transparent comparator may find several keys equivalent to `key`.
+    return {it, utl::upper_bound(it, end(), key, m_comp)};
+  }
+
+  template <typename V> std::pair<iterator, bool> insert_unique(V &&key) {
+    const iterator it = lower_bound(key);
+    if (it != end() && !m_comp(key, *it))
+      return {it, false};
+    return {m_keys.insert(it, std::forward<V>(key)), true};
+  }
+
+  /// Inserts at `hint` if the key belongs right before it, otherwise
+  /// searches like insert().
+  template <typename V> iterator insert_hint(const_iterator hint, V &&key) {
+    if ((hint == end() || m_comp(key, *hint)) &&
+        (hint == begin() || m_comp(*std::prev(hint), key)))
+      return m_keys.insert(hint, std::forward<V>(key));
+    return insert_unique(std::forward<V>(key)).first;
+  }
+
+  /// Merges the keys from index `num` on, sorted already if `sorted`, into
+  /// the sorted keys before them, then drops repeats. Both merging and
+  /// sorting are stable, so of equal keys the one already in the set, or
+  /// else the first inserted, is kept.
+  void merge_unique(size_type num, bool sorted) {
+    UTL_TRY {
+      const auto first = m_keys.begin();
+      const auto mid = first + static_cast<difference_type>(num);
+      const auto last = m_keys.end();
+      if (mid == last)
+        return;
+      if (!sorted)
+        std::stable_sort(mid, last, m_comp);
+      auto from = first;
+      if (mid != first) {
+        from = std::prev(mid);
+        // New keys that all sort after the old ones need no merge.
+        if (m_comp(*mid, *from)) {
+          std::inplace_merge(first, mid, last, m_comp);
+          from = first;
+        }
+      }
+      const auto equivalent = [this](const value_type &x,
+                                     const value_type &y) {
+        return !m_comp(x, y) && !m_comp(y, x);
+      };
+      m_keys.erase(std::unique(from, last, equivalent), m_keys.end());
+    }
+    UTL_CATCH(...) {
+      m_keys.clear();
+      UTL_RETHROW;
+    }
+  }
+
+  container_type m_keys;
+  key_compare m_comp;
+};
+
+template <typename Key, typename Compare, typename KeyContainer>
+inline bool operator==(const flat_set<Key, Compare, KeyContainer> &x,
+                       const flat_set<Key, Compare, KeyContainer> &y) {
+  return x.keys() == y.keys();
+}
+
+template <typename Key, typename Compare, typename KeyContainer>
+inline bool operator!=(const flat_set<Key, Compare, KeyContainer> &x,
+                       const flat_set<Key, Compare, KeyContainer> &y) {
+  return !(x == y);
+}
+
+template <typename Key, typename Compare, typename KeyContainer>
+inline bool operator<(const flat_set<Key, Compare, KeyContainer> &x,
+                      const flat_set<Key, Compare, KeyContainer> &y) {
+  return x.keys() < y.keys();
+}
+
+/// Erases the keys satisfying `pred` and returns how many were erased.
+template <typename Key, typename Compare, typename KeyContainer,
+          typename Predicate>
+typename flat_set<Key, Compare, KeyContainer>::size_type
+erase_if(flat_set<Key, Compare, KeyContainer> &set, Predicate pred) {
+  KeyContainer keys = std::move(set).extract();
+  const auto num = detail::erase_if_container(keys, pred);
+  set.replace(std::move(keys));
+  return num;
+}
+
+template <typename Key, typename Compare, typename KeyContainer>
+inline void swap(flat_set<Key, Compare, KeyContainer> &x,
+                 flat_set<Key, Compare, KeyContainer> &y) noexcept(
+    noexcept(x.swap(y))) {
+  x.swap(y);
+}
+
+} // namespace utl
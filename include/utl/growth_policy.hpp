@@ -0,0 +1,80 @@
+#pragma once
+#include <utl/algorithm.hpp>
+#include <utl/config.hpp>
+
+#include <cstddef>
+
+namespace utl {
+
+// A growth policy picks the capacity a container reallocates to once
+// `required` elements no longer fit in `capacity`:
+//
+//   static size_t grow(size_t capacity, size_t required, size_t elem_size);
+//
+// The result must be at least `required`.
+
+/// Multiplies the capacity by Num / Den.
+template <size_t Num, size_t Den> struct geometric_growth {
+  static_assert(Num > Den && Den > 0, "growth factor must exceed 1");
+
+  static constexpr size_t grow(size_t capacity, size_t required,
+                               size_t) noexcept {
+    const size_t grown = capacity + capacity / Den * (Num - Den) +
+                         capacity % Den * (Num - Den) / Den;
+    return utl::max(grown < capacity ? required : grown, required);
+  }
+};
+
+/// Doubles the capacity; the default for utl::vector.
+using doubling_growth = geometric_growth<2, 1>;
+
+/// Grows by half, which wastes at most a third of the buffer and lets a
+/// run of freed blocks be reused by a later request.
+using half_growth = geometric_growth<3, 2>;
+
+/// Applies `Base`, then rounds the buffer up to a power of two while it is
+/// smaller than `PageSize` bytes and to a whole number of pages after that,
+/// so the slack the allocator would add anyway holds elements.
+template <typename Base = doubling_growth, size_t PageSize = 4096>
+struct size_class_growth {
+  static_assert((PageSize & (PageSize - 1)) == 0,
+                "page size must be a power of two");
+
+  static constexpr size_t grow(size_t capacity, size_t required,
+                               size_t elem_size) noexcept {
+    const size_t count = Base::grow(capacity, required, elem_size);
+    if (count > size_t(-1) / elem_size - PageSize)
+      return count;
+    size_t bytes = count * elem_size;
+    if (bytes < PageSize) {
+      size_t size_class = 16;
+      while (size_class < bytes)
+        size_class *= 2;
+      bytes = size_class;
+    } else {
+      bytes = (bytes + PageSize - 1) & ~(PageSize - 1);
+    }
+    return bytes / elem_size;
+  }
+};
+
+/// Doubles the capacity until the buffer reaches `ThresholdBytes`, then
+/// adds `StepBytes` at a time. Large buffers then waste at most one step;
+/// the extra copies are cheap when the allocator can expand in place.
+template <size_t ThresholdBytes = size_t(1) << 24,
+          size_t StepBytes = size_t(1) << 22>
+struct linear_growth {
+  static_assert(StepBytes > 0, "step must not be empty");
+
+  static constexpr size_t grow(size_t capacity, size_t required,
+                               size_t elem_size) noexcept {
+    if (capacity < ThresholdBytes / elem_size)
+      return utl::min(doubling_growth::grow(capacity, required, elem_size),
+                      utl::max(ThresholdBytes / elem_size, required));
+    const size_t step = utl::max(StepBytes / elem_size, size_t(1));
+    const size_t grown = capacity + step;
+    return utl::max(grown < capacity ? required : grown, required);
+  }
+};
+
+} // namespace utl
@@ -0,0 +1,88 @@
+#pragma once
+#include <utl/algorithm.hpp>
+#include <utl/allocator.hpp>
+#include <utl/config.hpp>
+
+#include <type_traits>
+
+namespace utl {
+namespace detail {
+
+constexpr size_t huge_page_size = size_t(2) << 20;
+
+/// Maps `bytes` (a multiple of huge_page_size) aligned to huge_page_size,
+/// backed by explicit huge pages when the system has them reserved and by
+/// transparent huge pages otherwise. Returns nullptr on failure.
+void *map_huge_pages(size_t bytes) noexcept;
+
+} // namespace detail
+
+/// Allocator for very large buffers that are accessed randomly.
+///
+/// Requests of at least `threshold` bytes are mapped in 2 MiB aligned
+/// regions backed by huge pages, which cuts TLB misses. Smaller requests
+/// are forwarded to utl::allocator.
+template <typename T> class hugepage_allocator {
+public:
+  using value_type = T;
+  using propagate_on_container_move_assignment = std::true_type;
+  using is_always_equal = std::true_type;
+
+  static constexpr size_t threshold = detail::huge_page_size;
+
+  hugepage_allocator() noexcept = default;
+  hugepage_allocator(const hugepage_allocator &) noexcept = default;
+  template <class U>
+  hugepage_allocator(const hugepage_allocator<U> &) noexcept {}
+  ~hugepage_allocator() = default;
+  hugepage_allocator &operator=(const hugepage_allocator &) noexcept = default;
+
+  T *allocate(size_t n) {
+    if (!huge(n))
+      return allocator<T>().allocate(n);
+
+    const auto ret = detail::map_huge_pages(mapping_size(n));
+    if (!ret)
+      UTL_THROW(std::bad_alloc());
+    return static_cast<T *>(ret);
+  }
+
+  allocation_result<T *> allocate_at_least(size_t n) {
+    if (!huge(n)) {
+      // Stay below the threshold so deallocate picks the same path.
+      const auto result = allocator<T>().allocate_at_least(n);
+      return {result.ptr, utl::min(result.count, (threshold - 1) / sizeof(T))};
+    }
+    return {allocate(n), mapping_size(n) / sizeof(T)};
+  }
+
+  void deallocate(T *p, size_t n) noexcept {
+    if (huge(n))
+      detail::unmap_pages(p, mapping_size(n));
+    else
+      allocator<T>().deallocate(p, n);
+  }
+
+  friend constexpr bool operator==(const hugepage_allocator &,
+                                   const hugepage_allocator &) noexcept {
+    return true;
+  }
+  friend constexpr bool operator!=(const hugepage_allocator &,
+                                   const hugepage_allocator &) noexcept {
+    return false;
+  }
+
+private:
+  static constexpr bool huge(size_t n) noexcept {
+    return UTL_HAS_MMAP && alignof(T) <= detail::huge_page_size &&
+           n >= threshold / sizeof(T) + (threshold % sizeof(T) != 0) &&
+           n <= (size_t(-1) - detail::huge_page_size) / sizeof(T);
+  }
+
+  static constexpr size_t mapping_size(size_t n) noexcept {
+    return (n * sizeof(T) + detail::huge_page_size - 1) &
+           ~(detail::huge_page_size - 1);
+  }
+};
+
+} // namespace utl
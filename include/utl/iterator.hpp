@@ -41,23 +41,23 @@ public:
     return static_cast<Ptr>(this->data());
   }
 
-  It &operator++() noexcept {
+  constexpr It &operator++() noexcept {
     advance();
     return static_cast<It &>(*this);
   }
 
-  It operator++(int) noexcept {
+  constexpr It operator++(int) noexcept {
     const It retval = static_cast<const It &>(*this);
     advance();
     return retval;
   }
 
-  It &operator--() noexcept {
+  constexpr It &operator--() noexcept {
     advance(-1);
     return static_cast<It &>(*this);
   }
 
-  It operator--(int) noexcept {
+  constexpr It operator--(int) noexcept {
     const It retval = static_cast<const It &>(*this);
     advance(-1);
     return retval;
@@ -78,12 +78,12 @@ public:
     return It{it.data() - diff};
   }
 
-  It &operator+=(difference_type diff) noexcept {
+  constexpr It &operator+=(difference_type diff) noexcept {
     advance(diff);
     return static_cast<It &>(*this);
   }
 
-  It &operator-=(difference_type diff) noexcept {
+  constexpr It &operator-=(difference_type diff) noexcept {
     advance(-diff);
     return static_cast<It &>(*this);
   }
@@ -127,7 +127,7 @@ public:
     return lhs.data() - rhs.data();
   }
 
-  void advance(difference_type diff = 1) noexcept {
+  constexpr void advance(difference_type diff = 1) noexcept {
     assert(this->data() != nullptr);
     this->data() += diff;
   }
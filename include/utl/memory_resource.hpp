@@ -0,0 +1,324 @@
+#pragma once
+#include <utl/allocator.hpp>
+#include <utl/arena.hpp>
+#include <utl/config.hpp>
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace utl {
+namespace pmr {
+
+/// Abstract interface for a source of raw memory selected at run time.
+class memory_resource {
+public:
+  memory_resource() = default;
+  memory_resource(const memory_resource &) = default;
+  memory_resource &operator=(const memory_resource &) = default;
+
+  virtual ~memory_resource();
+
+  void *allocate(size_t bytes, size_t align = alignof(std::max_align_t)) {
+    return do_allocate(bytes, align);
+  }
+
+  void deallocate(void *p, size_t bytes,
+                  size_t align = alignof(std::max_align_t)) noexcept {
+    do_deallocate(p, bytes, align);
+  }
+
+  /// Whether memory allocated from `other` can be freed through this
+  /// resource and vice versa.
+  bool is_equal(const memory_resource &other) const noexcept {
+    return do_is_equal(other);
+  }
+
+private:
+  virtual void *do_allocate(size_t bytes, size_t align) = 0;
+  virtual void do_deallocate(void *p, size_t bytes, size_t align) noexcept = 0;
+  virtual bool do_is_equal(const memory_resource &other) const noexcept = 0;
+};
+
+inline bool operator==(const memory_resource &lhs,
+                       const memory_resource &rhs) noexcept {
+  return &lhs == &rhs || lhs.is_equal(rhs);
+}
+
+inline bool operator!=(const memory_resource &lhs,
+                       const memory_resource &rhs) noexcept {
+  return !(lhs == rhs);
+}
+
+/// Resource backed by the global aligned operator new and delete.
+memory_resource *new_delete_resource() noexcept;
+
+/// Resource whose allocate always throws std::bad_alloc.
+memory_resource *null_memory_resource() noexcept;
+
+/// The resource used by default-constructed polymorphic allocators;
+/// new_delete_resource() unless changed.
+memory_resource *get_default_resource() noexcept;
+
+/// Replaces the default resource, or restores new_delete_resource() when
+/// `r` is null, and returns the previous one.
+memory_resource *set_default_resource(memory_resource *r) noexcept;
+
+/// Allocator that forwards to a memory_resource chosen at construction.
+///
+/// The resource does not propagate on copy, move or swap, and copies of a
+/// container get the default resource, as with std::pmr. Elements that use
+/// a polymorphic_allocator themselves are constructed with this one, so a
+/// pmr::vector<pmr::string> keeps its strings in the same resource.
+template <typename T = std::byte> class polymorphic_allocator {
+public:
+  using value_type = T;
+
+  polymorphic_allocator() noexcept : m_resource(get_default_resource()) {}
+
+  polymorphic_allocator(memory_resource *r) noexcept : m_resource(r) {}
+
+  polymorphic_allocator(const polymorphic_allocator &) noexcept = default;
+
+  template <typename U>
+  polymorphic_allocator(const polymorphic_allocator<U> &other) noexcept
+      : m_resource(other.resource()) {}
+
+  polymorphic_allocator &operator=(const polymorphic_allocator &) = delete;
+
+  T *allocate(size_t n) {
+    if (n > size_t(-1) / sizeof(T))
+      UTL_THROW(std::bad_alloc());
+    return static_cast<T *>(m_resource->allocate(n * sizeof(T), alignof(T)));
+  }
+
+  void deallocate(T *p, size_t n) noexcept {
+    m_resource->deallocate(p, n * sizeof(T), alignof(T));
+  }
+
+  void *allocate_bytes(size_t bytes,
+                       size_t align = alignof(std::max_align_t)) {
+    return m_resource->allocate(bytes, align);
+  }
+
+  void deallocate_bytes(void *p, size_t bytes,
+                        size_t align = alignof(std::max_align_t)) noexcept {
+    m_resource->deallocate(p, bytes, align);
+  }
+
+  template <typename U, typename... Args> void construct(U *p, Args &&... args) {
+    using inner = polymorphic_allocator<U>;
+    if constexpr (!std::uses_allocator_v<U, inner>)
+      ::new (static_cast<void *>(p)) U(std::forward<Args>(args)...);
+    else if constexpr (std::is_constructible_v<U, std::allocator_arg_t,
+                                               const inner &, Args...>)
+      ::new (static_cast<void *>(p))
+          U(std::allocator_arg, inner(*this), std::forward<Args>(args)...);
+    else
+      ::new (static_cast<void *>(p))
+          U(std::forward<Args>(args)..., inner(*this));
+  }
+
+  polymorphic_allocator select_on_container_copy_construction() const noexcept {
+    return polymorphic_allocator();
+  }
+
+  memory_resource *resource() const noexcept { return m_resource; }
+
+  template <typename U>
+  friend bool operator==(const polymorphic_allocator &lhs,
+                         const polymorphic_allocator<U> &rhs) noexcept {
+    return *lhs.resource() == *rhs.resource();
+  }
+
+  template <typename U>
+  friend bool operator!=(const polymorphic_allocator &lhs,
+                         const polymorphic_allocator<U> &rhs) noexcept {
+    return !(lhs == rhs);
+  }
+
+private:
+  memory_resource *m_resource;
+};
+
+/// Resource that hands out memory from a utl::arena and frees it all at
+/// once in release() or on destruction.
+class monotonic_buffer_resource : public memory_resource {
+public:
+  monotonic_buffer_resource() noexcept = default;
+
+  explicit monotonic_buffer_resource(size_t initial_size) noexcept
+      : m_arena(initial_size) {}
+
+  monotonic_buffer_resource(const monotonic_buffer_resource &) = delete;
+  monotonic_buffer_resource &
+  operator=(const monotonic_buffer_resource &) = delete;
+
+  ~monotonic_buffer_resource() override;
+
+  void release() noexcept { m_arena.release(); }
+
+  const arena &buffer() const noexcept { return m_arena; }
+
+private:
+  void *do_allocate(size_t bytes, size_t align) override {
+    return m_arena.allocate(bytes, align);
+  }
+
+  void do_deallocate(void *p, size_t bytes, size_t) noexcept override {
+    m_arena.deallocate(p, bytes);
+  }
+
+  bool do_is_equal(const memory_resource &other) const noexcept override {
+    return this == &other;
+  }
+
+  arena m_arena;
+};
+
+struct pool_options {
+  /// Requests above this size, rounded up to a power of two, go to the
+  /// upstream resource. Clamped to [min_block, max_block] bytes.
+  size_t largest_required_pool_block = 0;
+};
+
+/// Resource that serves requests from one fixed-size pool per power of two
+/// and passes larger ones to an upstream resource. Not thread-safe.
+///
+/// Pooled blocks are carved from page-sized slabs drawn from the upstream
+/// resource. They are recycled within the resource, and the slabs are only
+/// given back in release() or on destruction.
+class unsynchronized_pool_resource : public memory_resource {
+public:
+  static constexpr size_t min_block = 8;
+  static constexpr size_t max_block = 4096;
+
+  unsynchronized_pool_resource()
+      : unsynchronized_pool_resource(pool_options(), get_default_resource()) {}
+
+  explicit unsynchronized_pool_resource(memory_resource *upstream)
+      : unsynchronized_pool_resource(pool_options(), upstream) {}
+
+  explicit unsynchronized_pool_resource(const pool_options &options)
+      : unsynchronized_pool_resource(options, get_default_resource()) {}
+
+  unsynchronized_pool_resource(const pool_options &options,
+                               memory_resource *upstream);
+
+  unsynchronized_pool_resource(const unsynchronized_pool_resource &) = delete;
+  unsynchronized_pool_resource &
+  operator=(const unsynchronized_pool_resource &) = delete;
+
+  ~unsynchronized_pool_resource() override;
+
+  /// Frees every allocation, pooled or not.
+  void release() noexcept;
+
+  memory_resource *upstream_resource() const noexcept { return m_upstream; }
+
+  pool_options options() const noexcept { return {m_largest_block}; }
+
+private:
+  struct large_header {
+    large_header *prev;
+    large_header *next;
+    size_t bytes;
+    size_t align;
+  };
+
+  void *do_allocate(size_t bytes, size_t align) override {
+    const size_t cls = pool_index(bytes, align);
+    if (cls < m_pool_count)
+      return m_pools[cls].allocate();
+    return allocate_large(bytes, align);
+  }
+
+  void do_deallocate(void *p, size_t bytes, size_t align) noexcept override {
+    const size_t cls = pool_index(bytes, align);
+    if (cls < m_pool_count)
+      m_pools[cls].deallocate(p);
+    else
+      deallocate_large(p, align);
+  }
+
+  bool do_is_equal(const memory_resource &other) const noexcept override {
+    return this == &other;
+  }
+
+  /// Index of the pool for a request, or a value >= m_pool_count if it is
+  /// too large or too strictly aligned for any pool.
+  size_t pool_index(size_t bytes, size_t align) const noexcept {
+    if (align > alignof(std::max_align_t) || bytes > m_largest_block)
+      return size_t(-1);
+    size_t index = 0;
+    for (size_t size = min_block; size < bytes || size < align; size *= 2)
+      ++index;
+    return index;
+  }
+
+  void *allocate_large(size_t bytes, size_t align);
+  void deallocate_large(void *p, size_t align) noexcept;
+
+  static size_t large_offset(size_t align) noexcept {
+    return (sizeof(large_header) + align - 1) / align * align;
+  }
+
+  memory_resource *m_upstream;
+  size_t m_largest_block;
+  size_t m_pool_count;
+  detail::fixed_pool *m_pools;
+  large_header *m_large = nullptr;
+};
+
+/// unsynchronized_pool_resource guarded by a mutex.
+class synchronized_pool_resource : public memory_resource {
+public:
+  synchronized_pool_resource() = default;
+
+  explicit synchronized_pool_resource(memory_resource *upstream)
+      : m_pool(upstream) {}
+
+  explicit synchronized_pool_resource(const pool_options &options)
+      : m_pool(options) {}
+
+  synchronized_pool_resource(const pool_options &options,
+                             memory_resource *upstream)
+      : m_pool(options, upstream) {}
+
+  ~synchronized_pool_resource() override;
+
+  void release() noexcept {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_pool.release();
+  }
+
+  memory_resource *upstream_resource() const noexcept {
+    return m_pool.upstream_resource();
+  }
+
+  pool_options options() const noexcept { return m_pool.options(); }
+
+private:
+  void *do_allocate(size_t bytes, size_t align) override {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_pool.allocate(bytes, align);
+  }
+
+  void do_deallocate(void *p, size_t bytes, size_t align) noexcept override {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_pool.deallocate(p, bytes, align);
+  }
+
+  bool do_is_equal(const memory_resource &other) const noexcept override {
+    return this == &other;
+  }
+
+  std::mutex m_mutex;
+  unsynchronized_pool_resource m_pool;
+};
+
+} // namespace pmr
+} // namespace utl
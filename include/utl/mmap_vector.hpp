@@ -0,0 +1,368 @@
+#pragma once
+#include <utl/allocator.hpp>
+#include <utl/config.hpp>
+#include <utl/growth_policy.hpp>
+#include <utl/vector.hpp>
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+namespace utl {
+
+/// How mmap_vector opens its file.
+enum class mmap_mode {
+  read_only,  ///< map an existing file read-only
+  read_write, ///< open or create the file, keeping existing contents
+  truncate    ///< create the file or discard its contents
+};
+
+namespace detail {
+
+/// A file mapped MAP_SHARED in its entirety; the mapping always covers
+/// exactly size() bytes of the file. Throws std::system_error on failure.
+class mapped_file {
+public:
+  mapped_file() noexcept = default;
+  mapped_file(const char *path, mmap_mode mode);
+  mapped_file(mapped_file &&other) noexcept
+      : m_data(std::exchange(other.m_data, nullptr)),
+        m_size(std::exchange(other.m_size, 0)),
+        m_fd(std::exchange(other.m_fd, -1)), m_writable(other.m_writable) {}
+  mapped_file &operator=(mapped_file &&other) noexcept {
+    swap(other);
+    return *this;
+  }
+  ~mapped_file();
+
+  std::byte *data() const noexcept { return m_data; }
+  size_t size() const noexcept { return m_size; }
+  bool is_open() const noexcept { return m_fd >= 0; }
+  bool writable() const noexcept { return m_writable; }
+
+  /// Sets the file length to `bytes` and maps all of it. The mapping may
+  /// move; on failure the file and mapping are unchanged.
+  void resize(size_t bytes);
+
+  /// Writes dirty pages back to the file (msync).
+  void sync(bool async);
+
+  void close() noexcept;
+
+  void swap(mapped_file &other) noexcept {
+    using std::swap;
+    swap(m_data, other.m_data);
+    swap(m_size, other.m_size);
+    swap(m_fd, other.m_fd);
+    swap(m_writable, other.m_writable);
+  }
+
+private:
+  std::byte *m_data = nullptr;
+  size_t m_size = 0;
+  int m_fd = -1;
+  bool m_writable = false;
+};
+
+/// First 64 bytes of an mmap_vector file; the elements follow.
+struct mmap_vector_header {
+  static constexpr char signature[8] = {'u', 't', 'l', 'v', 'e', 'c', '\0',
+                                        '1'};
+
+  char magic[8];
+  std::uint32_t elem_size;
+  std::uint32_t elem_align;
+  std::uint64_t size;
+  char reserved[40];
+};
+
+static_assert(sizeof(mmap_vector_header) == 64);
+
+} // namespace detail
+
+/// A vector of trivially copyable elements stored in a memory-mapped file.
+///
+/// The element count is kept in a small header in front of the elements,
+/// so it is written to the file with every change. Opening an existing
+/// file maps it; nothing is read or parsed, so startup does not depend on
+/// the file size. Growth extends the file with ftruncate and remaps it
+/// with mremap (or unmap and map again where mremap is missing), which may
+/// move the elements and invalidates iterators like vector reallocation
+/// does.
+///
+/// Changes reach the page cache straight away and other processes mapping
+/// the file see them. flush() makes them durable. A vector opened with
+/// mmap_mode::read_only must not be modified: writing through operator[]
+/// faults, and growing or clearing throws std::logic_error.
+template <typename T, typename GrowthPolicy = doubling_growth>
+class mmap_vector {
+  static_assert(std::is_trivially_copyable_v<T>,
+                "mmap_vector requires trivially copyable elements");
+  static_assert(alignof(T) <= sizeof(detail::mmap_vector_header),
+                "mmap_vector element alignment too large");
+
+  using header_type = detail::mmap_vector_header;
+
+public:
+  // types:
+  using value_type = T;
+  using pointer = T *;
+  using const_pointer = const T *;
+  using reference = value_type &;
+  using const_reference = const value_type &;
+  using size_type = size_t;
+  using difference_type = std::ptrdiff_t;
+  using iterator = vector_iterator<value_type>;
+  using const_iterator = vector_const_iterator<value_type>;
+  using reverse_iterator = std::reverse_iterator<iterator>;
+  using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+  // construct/copy/destroy
+  mmap_vector() noexcept = default;
+
+  /// Opens `path`. An existing non-empty file must have been written by
+  /// an mmap_vector with the same element size, or std::runtime_error is
+  /// thrown.
+  explicit mmap_vector(const char *path,
+                       mmap_mode mode = mmap_mode::read_write)
+      : m_file(path, mode) {
+    if (m_file.size() == 0) {
+      if (!m_file.writable())
+        UTL_THROW(std::runtime_error("mmap_vector: empty file"));
+      m_file.resize(detail::page_size);
+      init_header();
+    } else {
+      check_header();
+    }
+  }
+
+  explicit mmap_vector(const std::string &path,
+                       mmap_mode mode = mmap_mode::read_write)
+      : mmap_vector(path.c_str(), mode) {}
+
+  mmap_vector(const mmap_vector &) = delete;
+  mmap_vector &operator=(const mmap_vector &) = delete;
+
+  mmap_vector(mmap_vector &&other) noexcept = default;
+
+  mmap_vector &operator=(mmap_vector &&other) noexcept {
+    m_file.swap(other.m_file);
+    other.close();
+    return *this;
+  }
+
+  ~mmap_vector() = default;
+
+  // iterators:
+  iterator begin() noexcept { return iterator{data()}; }
+  const_iterator begin() const noexcept { return const_iterator{data()}; }
+  iterator end() noexcept { return iterator{data() + size()}; }
+  const_iterator end() const noexcept {
+    return const_iterator{data() + size()};
+  }
+  reverse_iterator rbegin() noexcept { return reverse_iterator(end()); }
+  const_reverse_iterator rbegin() const noexcept {
+    return const_reverse_iterator(end());
+  }
+  reverse_iterator rend() noexcept { return reverse_iterator(begin()); }
+  const_reverse_iterator rend() const noexcept {
+    return const_reverse_iterator(begin());
+  }
+  const_iterator cbegin() const noexcept { return begin(); }
+  const_iterator cend() const noexcept { return end(); }
+  const_reverse_iterator crbegin() const noexcept { return rbegin(); }
+  const_reverse_iterator crend() const noexcept { return rend(); }
+
+  // capacity
+  bool empty() const noexcept { return size() == 0; }
+  size_type size() const noexcept {
+    return m_file.data() ? static_cast<size_type>(header()->size) : 0;
+  }
+  size_type capacity() const noexcept {
+    return m_file.size() ? (m_file.size() - sizeof(header_type)) / sizeof(T)
+                         : 0;
+  }
+  size_type max_size() const noexcept {
+    return (size_type(-1) - sizeof(header_type)) / sizeof(T);
+  }
+
+  void resize(size_type num) { resize(num, value_type()); }
+
+  void resize(size_type num, const_reference val) {
+    const size_type old = size();
+    if (num > old) {
+      const value_type copy = val; // `val` may live in the mapping
+      reserve(num);
+      std::uninitialized_fill_n(data() + old, num - old, copy);
+    }
+    set_size(num);
+  }
+
+  void reserve(size_type num) {
+    if (num > capacity())
+      remap(GrowthPolicy::grow(capacity(), num, sizeof(T)));
+  }
+
+  /// Truncates the file to the pages the elements occupy.
+  void shrink_to_fit() {
+    if (is_open() && !read_only())
+      remap(size());
+  }
+
+  // element access:
+  reference operator[](size_type num) { return data()[num]; }
+  const_reference operator[](size_type num) const { return data()[num]; }
+  const_reference at(size_type num) const {
+    if (num < size())
+      return data()[num];
+    UTL_THROW(std::out_of_range("mmap_vector::at"));
+  }
+  reference at(size_type num) {
+    if (num < size())
+      return data()[num];
+    UTL_THROW(std::out_of_range("mmap_vector::at"));
+  }
+  reference front() { return data()[0]; }
+  const_reference front() const { return data()[0]; }
+  reference back() { return data()[size() - 1]; }
+  const_reference back() const { return data()[size() - 1]; }
+
+  // data access
+  pointer data() noexcept { return elements(); }
+  const_pointer data() const noexcept { return elements(); }
+
+  // modifiers
+  template <typename... Args> reference emplace_back(Args &&... args) {
+    const size_type num = size();
+    // Build the element before growing: `args` may live in the mapping.
+    const value_type elem(std::forward<Args>(args)...);
+    reserve(num + 1);
+    pointer p = data() + num;
+    std::memcpy(static_cast<void *>(p), &elem, sizeof(T));
+    set_size(num + 1);
+    return *p;
+  }
+
+  void push_back(const_reference elem) { emplace_back(elem); }
+
+  template <typename InputIterator,
+            typename = typename iterator_traits<InputIterator>::iterator_category>
+  void append(InputIterator first, InputIterator last) {
+    if constexpr (std::is_base_of_v<
+                      std::forward_iterator_tag,
+                      typename iterator_traits<InputIterator>::iterator_category>) {
+      const size_type num = size();
+      const auto count = static_cast<size_type>(std::distance(first, last));
+      reserve(num + count);
+      std::uninitialized_copy(first, last, data() + num);
+      set_size(num + count);
+    } else {
+      for (; first != last; ++first)
+        emplace_back(*first);
+    }
+  }
+
+  void pop_back() noexcept {
+    assert(!empty());
+    set_size(size() - 1);
+  }
+
+  iterator erase(const_iterator position) {
+    return erase(position, position + 1);
+  }
+
+  iterator erase(const_iterator first, const_iterator last) {
+    const auto idx = static_cast<size_type>(first - cbegin());
+    const auto count = static_cast<size_type>(last - first);
+    if (count) {
+      pointer p = data();
+      std::memmove(static_cast<void *>(p + idx), p + idx + count,
+                   (size() - idx - count) * sizeof(T));
+      set_size(size() - count);
+    }
+    return begin() + idx;
+  }
+
+  void clear() {
+    if (!is_open())
+      return;
+    if (read_only())
+      UTL_THROW(std::logic_error("mmap_vector: file not writable"));
+    if (m_file.data())
+      set_size(0);
+  }
+
+  void swap(mmap_vector &other) noexcept { m_file.swap(other.m_file); }
+
+  // file
+  bool is_open() const noexcept { return m_file.is_open(); }
+  bool read_only() const noexcept { return !m_file.writable(); }
+
+  /// Writes modified pages back to the file: with `async` the write is
+  /// only scheduled, otherwise flush returns once it is on disk.
+  void flush(bool async = false) { m_file.sync(async); }
+
+  /// Unmaps and closes the file without flushing; the vector becomes
+  /// empty.
+  void close() noexcept { m_file.close(); }
+
+private:
+  header_type *header() const noexcept {
+    return reinterpret_cast<header_type *>(m_file.data());
+  }
+
+  pointer elements() const noexcept {
+    return m_file.data() ? reinterpret_cast<pointer>(m_file.data() +
+                                                     sizeof(header_type))
+                         : nullptr;
+  }
+
+  void set_size(size_type num) noexcept {
+    assert(num <= capacity());
+    header()->size = num;
+  }
+
+  void init_header() noexcept {
+    header_type *h = header();
+    std::memcpy(h->magic, header_type::signature, sizeof(h->magic));
+    h->elem_size = sizeof(T);
+    h->elem_align = alignof(T);
+    h->size = 0;
+  }
+
+  void check_header() const {
+    const header_type *h = header();
+    if (m_file.size() < sizeof(header_type) ||
+        std::memcmp(h->magic, header_type::signature, sizeof(h->magic)) ||
+        h->elem_size != sizeof(T))
+      UTL_THROW(std::runtime_error("mmap_vector: not a matching vector file"));
+    if (h->size > capacity())
+      UTL_THROW(std::runtime_error("mmap_vector: truncated file"));
+  }
+
+  void remap(size_type cap) {
+    if (!is_open() || read_only())
+      UTL_THROW(std::logic_error("mmap_vector: file not writable"));
+    if (cap > max_size())
+      UTL_THROW(std::length_error("mmap_vector"));
+    const size_t bytes = sizeof(header_type) + cap * sizeof(T);
+    m_file.resize((bytes + detail::page_size - 1) & ~(detail::page_size - 1));
+  }
+
+  detail::mapped_file m_file;
+};
+
+template <typename T, typename GrowthPolicy>
+inline void swap(mmap_vector<T, GrowthPolicy> &x,
+                 mmap_vector<T, GrowthPolicy> &y) noexcept {
+  x.swap(y);
+}
+
+} // namespace utl
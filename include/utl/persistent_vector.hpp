@@ -0,0 +1,736 @@
+#pragma once
+#include <utl/allocator.hpp>
+#include <utl/config.hpp>
+#include <utl/iterator.hpp>
+#include <utl/type_traits.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace utl {
+namespace detail {
+
+constexpr size_t pvector_bits = 5;
+constexpr size_t pvector_width = size_t(1) << pvector_bits;
+constexpr size_t pvector_mask = pvector_width - 1;
+
+/// Every node of a persistent_vector is reference counted. A node with a
+/// count of one is reachable from a single vector only, which may change
+/// it in place; shared nodes are copied first.
+struct pvector_node {
+  std::atomic<size_t> refs{1};
+};
+
+struct pvector_inner : pvector_node {
+  pvector_node *children[pvector_width] = {};
+};
+
+template <typename T> struct pvector_leaf : pvector_node {
+  pvector_leaf() noexcept {}
+  ~pvector_leaf() {}
+
+  size_t count = 0;
+  union {
+    T elems[pvector_width];
+  };
+};
+
+/// The trie shared by persistent_vector and transient_vector.
+///
+/// Elements live in leaves of 32; inner nodes hold 32 children, so a
+/// lookup reads one node per 5 bits of the index. The last, possibly
+/// partial leaf is kept out of the trie as the tail, which makes appends
+/// touch only the tail 31 times out of 32. Modifications copy the nodes on
+/// the path to the change unless they are unshared; copying the vector
+/// only takes a reference to the root and the tail.
+template <typename T, typename Allocator> class pvector_base {
+protected:
+  using alloc_traits = allocator_traits<Allocator>;
+  using leaf = pvector_leaf<T>;
+  using inner = pvector_inner;
+  using node = pvector_node;
+  using leaf_allocator = typename alloc_traits::template rebind_alloc<leaf>;
+  using inner_allocator = typename alloc_traits::template rebind_alloc<inner>;
+  using leaf_traits = allocator_traits<leaf_allocator>;
+  using inner_traits = allocator_traits<inner_allocator>;
+
+  static constexpr size_t bits = pvector_bits;
+  static constexpr size_t width = pvector_width;
+  static constexpr size_t mask = pvector_mask;
+
+public:
+  pvector_base() noexcept(std::is_nothrow_default_constructible_v<Allocator>)
+      : m_alloc() {}
+
+  explicit pvector_base(const Allocator &alloc) noexcept : m_alloc(alloc) {}
+
+  pvector_base(const pvector_base &other) noexcept
+      : m_alloc(other.m_alloc), m_root(other.m_root), m_tail(other.m_tail),
+        m_size(other.m_size), m_shift(other.m_shift) {
+    retain(m_root);
+    retain(m_tail);
+  }
+
+  pvector_base(pvector_base &&other) noexcept
+      : m_alloc(other.m_alloc), m_root(std::exchange(other.m_root, nullptr)),
+        m_tail(std::exchange(other.m_tail, nullptr)),
+        m_size(std::exchange(other.m_size, 0)),
+        m_shift(std::exchange(other.m_shift, bits)) {}
+
+  pvector_base &operator=(pvector_base other) noexcept {
+    swap(other);
+    return *this;
+  }
+
+  ~pvector_base() { reset(); }
+
+protected:
+  void swap(pvector_base &other) noexcept {
+    using std::swap;
+    swap(m_alloc, other.m_alloc);
+    swap(m_root, other.m_root);
+    swap(m_tail, other.m_tail);
+    swap(m_size, other.m_size);
+    swap(m_shift, other.m_shift);
+  }
+
+  void reset() noexcept {
+    release(m_root, m_shift);
+    release(m_tail, 0);
+    m_root = nullptr;
+    m_tail = nullptr;
+    m_size = 0;
+    m_shift = bits;
+  }
+
+  size_t tail_offset() const noexcept {
+    return m_size ? (m_size - 1) & ~mask : 0;
+  }
+
+public:
+  /// First element of the leaf holding element `idx`.
+  const T *leaf_for(size_t idx) const noexcept {
+    assert(idx < m_size);
+    if (idx >= tail_offset())
+      return m_tail->elems;
+    const node *n = m_root;
+    for (size_t level = m_shift; level; level -= bits)
+      n = static_cast<const inner *>(n)->children[(idx >> level) & mask];
+    return static_cast<const leaf *>(n)->elems;
+  }
+
+  size_t size() const noexcept { return m_size; }
+
+protected:
+  template <typename... Args> void emplace_back(Args &&... args) {
+    if (m_size == 0 || m_size - tail_offset() < width) {
+      leaf *t = m_tail ? unique_leaf(m_tail) : new_tail();
+      alloc_traits::construct(m_alloc, t->elems + t->count,
+                              std::forward<Args>(args)...);
+      ++t->count;
+      ++m_size;
+      return;
+    }
+
+    // The tail is full: start a new one and move the old one into the trie.
+    leaf *fresh = new_leaf();
+    UTL_TRY {
+      alloc_traits::construct(m_alloc, fresh->elems,
+                              std::forward<Args>(args)...);
+      fresh->count = 1;
+      if (m_root && (m_size >> bits) > (size_t(1) << m_shift)) {
+        inner *r = new_inner();
+        r->children[0] = m_root;
+        m_root = r;
+        m_shift += bits;
+      }
+      insert_leaf(m_root, m_shift, tail_offset(), m_tail);
+    }
+    UTL_CATCH(...) {
+      release(fresh, 0);
+      UTL_RETHROW;
+    }
+    m_tail = fresh;
+    ++m_size;
+  }
+
+  /// Unshares the path to element `idx` and returns it.
+  T &mutable_at(size_t idx) {
+    assert(idx < m_size);
+    if (idx >= tail_offset())
+      return unique_leaf(m_tail)->elems[idx & mask];
+    node **slot = &m_root;
+    for (size_t level = m_shift; level; level -= bits)
+      slot = &unique_inner(*slot, level)->children[(idx >> level) & mask];
+    return unique_leaf(*slot)->elems[idx & mask];
+  }
+
+  void pop_back() {
+    assert(m_size);
+    if (m_size == 1) {
+      reset();
+      return;
+    }
+    if (m_size - tail_offset() > 1) {
+      leaf *t = unique_leaf(m_tail);
+      alloc_traits::destroy(m_alloc, t->elems + --t->count);
+      --m_size;
+      return;
+    }
+
+    // The tail empties: the last leaf of the trie becomes the tail.
+    leaf *last = pop_leaf(m_root, m_shift, m_size - 2);
+    release(m_tail, 0);
+    m_tail = last;
+    --m_size;
+    if (!m_root) {
+      m_shift = bits;
+    } else if (m_shift > bits &&
+               !static_cast<inner *>(m_root)->children[1]) {
+      node *child = static_cast<inner *>(m_root)->children[0];
+      retain(child);
+      release(m_root, m_shift);
+      m_root = child;
+      m_shift -= bits;
+    }
+  }
+
+  static void retain(node *n) noexcept {
+    if (n)
+      n->refs.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  void release(node *n, size_t level) noexcept {
+    if (!n || n->refs.fetch_sub(1, std::memory_order_acq_rel) != 1)
+      return;
+    if (level == 0) {
+      destroy_leaf(static_cast<leaf *>(n));
+      return;
+    }
+    auto *in = static_cast<inner *>(n);
+    for (node *child : in->children)
+      release(child, level - bits);
+    inner_allocator alloc(m_alloc);
+    in->~inner();
+    inner_traits::deallocate(alloc, in, 1);
+  }
+
+  Allocator m_alloc;
+  node *m_root = nullptr;
+  leaf *m_tail = nullptr;
+  size_t m_size = 0;
+  size_t m_shift = bits;
+
+private:
+  inner *new_inner() {
+    inner_allocator alloc(m_alloc);
+    return ::new (static_cast<void *>(inner_traits::allocate(alloc, 1)))
+        inner();
+  }
+
+  leaf *new_leaf() {
+    leaf_allocator alloc(m_alloc);
+    return ::new (static_cast<void *>(leaf_traits::allocate(alloc, 1))) leaf();
+  }
+
+  leaf *new_tail() { return m_tail = new_leaf(); }
+
+  void destroy_leaf(leaf *l) noexcept {
+    for (size_t i = 0; i != l->count; ++i)
+      alloc_traits::destroy(m_alloc, l->elems + i);
+    leaf_allocator alloc(m_alloc);
+    l->~leaf();
+    leaf_traits::deallocate(alloc, l, 1);
+  }
+
+  /// Makes `*slot` an inner node owned by this vector alone.
+  inner *unique_inner(node *&slot, size_t level) {
+    auto *n = static_cast<inner *>(slot);
+    if (n->refs.load(std::memory_order_acquire) == 1)
+      return n;
+    inner *copy = new_inner();
+    for (size_t i = 0; i != width; ++i)
+      retain(copy->children[i] = n->children[i]);
+    slot = copy;
+    release(n, level);
+    return copy;
+  }
+
+  template <typename Slot> leaf *unique_leaf(Slot &slot) {
+    auto *l = static_cast<leaf *>(slot);
+    if (l->refs.load(std::memory_order_acquire) == 1)
+      return l;
+    leaf *copy = new_leaf();
+    UTL_TRY {
+      for (; copy->count != l->count; ++copy->count)
+        alloc_traits::construct(m_alloc, copy->elems + copy->count,
+                                l->elems[copy->count]);
+    }
+    UTL_CATCH(...) {
+      destroy_leaf(copy);
+      UTL_RETHROW;
+    }
+    slot = copy;
+    release(l, 0);
+    return copy;
+  }
+
+  /// Hangs leaf `l`, holding elements from `idx`, below `slot`. Missing
+  /// inner nodes on the way are created empty, so a failed allocation
+  /// leaves a valid trie behind.
+  void insert_leaf(node *&slot, size_t level, size_t idx, leaf *l) {
+    inner *n = slot ? unique_inner(slot, level) : new_inner();
+    slot = n;
+    node *&child = n->children[(idx >> level) & mask];
+    if (level == bits)
+      child = l;
+    else
+      insert_leaf(child, level - bits, idx, l);
+  }
+
+  /// Detaches the leaf holding element `idx`, the rightmost one below
+  /// `slot`, and hands over its reference. Nodes left empty are freed.
+  leaf *pop_leaf(node *&slot, size_t level, size_t idx) {
+    inner *n = unique_inner(slot, level);
+    const size_t sub = (idx >> level) & mask;
+    leaf *l;
+    if (level == bits)
+      l = static_cast<leaf *>(std::exchange(n->children[sub], nullptr));
+    else
+      l = pop_leaf(n->children[sub], level - bits, idx);
+    if (sub == 0 && !n->children[0]) {
+      release(n, level);
+      slot = nullptr;
+    }
+    return l;
+  }
+};
+
+/// Position in a persistent_vector. The leaf holding the position is
+/// cached, so stepping through a leaf does not walk the trie.
+template <typename Base> class pvector_cursor {
+  using T = std::remove_const_t<
+      std::remove_pointer_t<decltype(std::declval<Base>().leaf_for(0))>>;
+
+public:
+  constexpr pvector_cursor() noexcept = default;
+
+  pvector_cursor(const Base *vec, std::ptrdiff_t pos) noexcept
+      : m_vec(vec), m_pos(pos), m_leaf(find_leaf()) {}
+
+  const T &operator*() const noexcept {
+    assert(m_leaf);
+    return m_leaf[static_cast<size_t>(m_pos) & pvector_mask];
+  }
+
+  const T &operator[](std::ptrdiff_t idx) const noexcept {
+    return *pvector_cursor(m_vec, m_pos + idx);
+  }
+
+  explicit operator const T *() const noexcept { return &**this; }
+
+  explicit constexpr operator bool() const noexcept {
+    return m_vec != nullptr;
+  }
+
+  pvector_cursor &operator+=(std::ptrdiff_t diff) noexcept {
+    const auto old = m_pos;
+    m_pos += diff;
+    if (!m_leaf || ((old ^ m_pos) & ~std::ptrdiff_t(pvector_mask)))
+      m_leaf = find_leaf();
+    return *this;
+  }
+
+  friend pvector_cursor operator+(const pvector_cursor &c,
+                                  std::ptrdiff_t diff) noexcept {
+    return pvector_cursor(c.m_vec, c.m_pos + diff);
+  }
+
+  friend pvector_cursor operator-(const pvector_cursor &c,
+                                  std::ptrdiff_t diff) noexcept {
+    return pvector_cursor(c.m_vec, c.m_pos - diff);
+  }
+
+  friend constexpr std::ptrdiff_t
+  operator-(const pvector_cursor &lhs, const pvector_cursor &rhs) noexcept {
+    return lhs.m_pos - rhs.m_pos;
+  }
+
+  friend constexpr bool operator==(const pvector_cursor &lhs,
+                                   const pvector_cursor &rhs) noexcept {
+    return lhs.m_pos == rhs.m_pos;
+  }
+
+  friend constexpr bool operator!=(const pvector_cursor &lhs,
+                                   const pvector_cursor &rhs) noexcept {
+    return lhs.m_pos != rhs.m_pos;
+  }
+
+  friend constexpr bool operator!=(const pvector_cursor &c,
+                                   std::nullptr_t) noexcept {
+    return c.m_vec != nullptr;
+  }
+
+  friend constexpr bool operator<(const pvector_cursor &lhs,
+                                  const pvector_cursor &rhs) noexcept {
+    return lhs.m_pos < rhs.m_pos;
+  }
+
+  friend constexpr bool operator>(const pvector_cursor &lhs,
+                                  const pvector_cursor &rhs) noexcept {
+    return lhs.m_pos > rhs.m_pos;
+  }
+
+  friend constexpr bool operator<=(const pvector_cursor &lhs,
+                                   const pvector_cursor &rhs) noexcept {
+    return lhs.m_pos <= rhs.m_pos;
+  }
+
+  friend constexpr bool operator>=(const pvector_cursor &lhs,
+                                   const pvector_cursor &rhs) noexcept {
+    return lhs.m_pos >= rhs.m_pos;
+  }
+
+private:
+  const T *find_leaf() const noexcept {
+    return m_vec && m_pos >= 0 && static_cast<size_t>(m_pos) < m_vec->size()
+               ? m_vec->leaf_for(static_cast<size_t>(m_pos))
+               : nullptr;
+  }
+
+  const Base *m_vec = nullptr;
+  std::ptrdiff_t m_pos = 0;
+  const T *m_leaf = nullptr;
+};
+
+} // namespace detail
+
+template <typename Tp, typename Base>
+class persistent_vector_iterator
+    : public iterator_wrapper<persistent_vector_iterator<Tp, Base>, Tp,
+                              const Tp &, const Tp *,
+                              std::random_access_iterator_tag> {
+public:
+  persistent_vector_iterator() noexcept = default;
+
+  explicit persistent_vector_iterator(detail::pvector_cursor<Base> data) noexcept
+      : m_data(data) {}
+
+  detail::pvector_cursor<Base> m_data;
+};
+
+template <typename Tp, typename Allocator> class transient_vector;
+
+/// An immutable vector whose copies share structure.
+///
+/// Copying is O(1) and never copies elements, so a snapshot can be handed
+/// to other threads while the owner keeps producing new versions.
+/// push_back, set and pop_back leave the vector alone and return a new
+/// version that shares everything except the path to the change: at most
+/// one node per 5 bits of the size, plus the 32-element tail. Called on an
+/// rvalue whose nodes are not shared, they update in place instead.
+///
+/// Distinct versions may be read and copied concurrently; the nodes are
+/// reference counted with atomics. For many edits in a row, transient()
+/// gives a mutable builder that copies each node at most once.
+template <typename Tp, typename Allocator = allocator<Tp>>
+class persistent_vector : detail::pvector_base<Tp, Allocator> {
+  using base = detail::pvector_base<Tp, Allocator>;
+  using alloc_traits = typename base::alloc_traits;
+  using base::m_alloc;
+  using base::m_root;
+  using base::m_size;
+  using base::m_tail;
+
+  friend class transient_vector<Tp, Allocator>;
+
+  explicit persistent_vector(base &&impl) noexcept : base(std::move(impl)) {}
+
+public:
+  // types:
+  using value_type = Tp;
+  using allocator_type = Allocator;
+  using pointer = typename alloc_traits::pointer;
+  using const_pointer = typename alloc_traits::const_pointer;
+  using reference = const value_type &;
+  using const_reference = const value_type &;
+  using size_type = size_t;
+  using difference_type = std::ptrdiff_t;
+  using iterator = persistent_vector_iterator<value_type, base>;
+  using const_iterator = iterator;
+  using reverse_iterator = std::reverse_iterator<iterator>;
+  using const_reverse_iterator = reverse_iterator;
+  using transient_type = transient_vector<Tp, Allocator>;
+
+  // construct/copy/destroy
+  persistent_vector() noexcept(
+      std::is_nothrow_default_constructible_v<Allocator>) = default;
+
+  explicit persistent_vector(const Allocator &alloc) noexcept : base(alloc) {}
+
+  template <typename InputIterator,
+            typename = typename iterator_traits<InputIterator>::iterator_category>
+  persistent_vector(InputIterator first, InputIterator last,
+                    const Allocator &alloc = Allocator())
+      : base(alloc) {
+    for (; first != last; ++first)
+      base::emplace_back(*first);
+  }
+
+  persistent_vector(std::initializer_list<value_type> il,
+                    const Allocator &alloc = Allocator())
+      : persistent_vector(il.begin(), il.end(), alloc) {}
+
+  persistent_vector(const persistent_vector &) noexcept = default;
+  persistent_vector(persistent_vector &&) noexcept = default;
+  persistent_vector &operator=(const persistent_vector &) noexcept = default;
+  persistent_vector &operator=(persistent_vector &&) noexcept = default;
+
+  allocator_type get_allocator() const noexcept { return m_alloc; }
+
+  // iterators:
+  iterator begin() const noexcept { return iterator{{this, 0}}; }
+  iterator end() const noexcept {
+    return iterator{{this, static_cast<difference_type>(m_size)}};
+  }
+  iterator cbegin() const noexcept { return begin(); }
+  iterator cend() const noexcept { return end(); }
+  reverse_iterator rbegin() const noexcept { return reverse_iterator(end()); }
+  reverse_iterator rend() const noexcept { return reverse_iterator(begin()); }
+  reverse_iterator crbegin() const noexcept { return rbegin(); }
+  reverse_iterator crend() const noexcept { return rend(); }
+
+  // capacity
+  bool empty() const noexcept { return m_size == 0; }
+  using base::size;
+  size_type max_size() const noexcept { return size_type(-1); }
+
+  // element access:
+  const_reference operator[](size_type num) const noexcept {
+    return base::leaf_for(num)[num & base::mask];
+  }
+  const_reference at(size_type num) const {
+    if (num < m_size)
+      return (*this)[num];
+    UTL_THROW(std::out_of_range("persistent_vector::at"));
+  }
+  const_reference front() const noexcept { return (*this)[0]; }
+  const_reference back() const noexcept { return (*this)[m_size - 1]; }
+
+  // modifiers, returning the new version
+  [[nodiscard]] persistent_vector push_back(const value_type &elem) const & {
+    return persistent_vector(*this).push_back(elem);
+  }
+
+  [[nodiscard]] persistent_vector push_back(value_type &&elem) const & {
+    return persistent_vector(*this).push_back(std::move(elem));
+  }
+
+  [[nodiscard]] persistent_vector push_back(const value_type &elem) && {
+    base::emplace_back(elem);
+    return std::move(*this);
+  }
+
+  [[nodiscard]] persistent_vector push_back(value_type &&elem) && {
+    base::emplace_back(std::move(elem));
+    return std::move(*this);
+  }
+
+  template <typename... Args>
+  [[nodiscard]] persistent_vector emplace_back(Args &&... args) const & {
+    return persistent_vector(*this).emplace_back(std::forward<Args>(args)...);
+  }
+
+  template <typename... Args>
+  [[nodiscard]] persistent_vector emplace_back(Args &&... args) && {
+    base::emplace_back(std::forward<Args>(args)...);
+    return std::move(*this);
+  }
+
+  /// Returns a version with element `num` replaced by `elem`.
+  template <typename U>
+  [[nodiscard]] persistent_vector set(size_type num, U &&elem) const & {
+    return persistent_vector(*this).set(num, std::forward<U>(elem));
+  }
+
+  template <typename U>
+  [[nodiscard]] persistent_vector set(size_type num, U &&elem) && {
+    base::mutable_at(num) = std::forward<U>(elem);
+    return std::move(*this);
+  }
+
+  [[nodiscard]] persistent_vector pop_back() const & {
+    return persistent_vector(*this).pop_back();
+  }
+
+  [[nodiscard]] persistent_vector pop_back() && {
+    base::pop_back();
+    return std::move(*this);
+  }
+
+  /// A mutable builder starting from this version.
+  transient_type transient() const & { return transient_type(*this); }
+
+  transient_type transient() && { return transient_type(std::move(*this)); }
+
+  void swap(persistent_vector &other) noexcept { base::swap(other); }
+
+  /// Whether both vectors are versions sharing the same nodes, which
+  /// implies equal contents.
+  bool identical(const persistent_vector &other) const noexcept {
+    return m_root == other.m_root && m_tail == other.m_tail &&
+           m_size == other.m_size;
+  }
+};
+
+/// A mutable persistent_vector under construction.
+///
+/// Modifications happen in place on nodes the transient owns alone and
+/// copy shared ones once, after which they are owned too. persistent()
+/// takes an O(1) snapshot; the transient stays usable, and later changes
+/// copy whatever the snapshot now shares.
+template <typename Tp, typename Allocator = allocator<Tp>>
+class transient_vector : detail::pvector_base<Tp, Allocator> {
+  using base = detail::pvector_base<Tp, Allocator>;
+  using alloc_traits = typename base::alloc_traits;
+  using base::m_alloc;
+  using base::m_size;
+
+public:
+  // types:
+  using value_type = Tp;
+  using allocator_type = Allocator;
+  using pointer = typename alloc_traits::pointer;
+  using const_pointer = typename alloc_traits::const_pointer;
+  using reference = value_type &;
+  using const_reference = const value_type &;
+  using size_type = size_t;
+  using difference_type = std::ptrdiff_t;
+  using const_iterator = persistent_vector_iterator<value_type, base>;
+  using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+  using persistent_type = persistent_vector<Tp, Allocator>;
+
+  // construct/copy/destroy
+  transient_vector() noexcept(
+      std::is_nothrow_default_constructible_v<Allocator>) = default;
+
+  explicit transient_vector(const Allocator &alloc) noexcept : base(alloc) {}
+
+  explicit transient_vector(const persistent_type &vec) noexcept
+      : base(vec) {}
+
+  explicit transient_vector(persistent_type &&vec) noexcept
+      : base(std::move(vec)) {}
+
+  transient_vector(const transient_vector &) noexcept = default;
+  transient_vector(transient_vector &&) noexcept = default;
+  transient_vector &operator=(const transient_vector &) noexcept = default;
+  transient_vector &operator=(transient_vector &&) noexcept = default;
+
+  allocator_type get_allocator() const noexcept { return m_alloc; }
+
+  // iterators:
+  const_iterator begin() const noexcept { return const_iterator{{this, 0}}; }
+  const_iterator end() const noexcept {
+    return const_iterator{{this, static_cast<difference_type>(m_size)}};
+  }
+  const_iterator cbegin() const noexcept { return begin(); }
+  const_iterator cend() const noexcept { return end(); }
+  const_reverse_iterator rbegin() const noexcept {
+    return const_reverse_iterator(end());
+  }
+  const_reverse_iterator rend() const noexcept {
+    return const_reverse_iterator(begin());
+  }
+
+  // capacity
+  bool empty() const noexcept { return m_size == 0; }
+  using base::size;
+
+  // element access:
+  const_reference operator[](size_type num) const noexcept {
+    return base::leaf_for(num)[num & base::mask];
+  }
+  const_reference at(size_type num) const {
+    if (num < m_size)
+      return (*this)[num];
+    UTL_THROW(std::out_of_range("transient_vector::at"));
+  }
+  const_reference front() const noexcept { return (*this)[0]; }
+  const_reference back() const noexcept { return (*this)[m_size - 1]; }
+
+  /// Writable access to element `num`, copying the nodes on its path if
+  /// they are shared.
+  reference mutable_at(size_type num) { return base::mutable_at(num); }
+
+  // modifiers
+  template <typename... Args> reference emplace_back(Args &&... args) {
+    base::emplace_back(std::forward<Args>(args)...);
+    return mutable_at(m_size - 1);
+  }
+
+  void push_back(const value_type &elem) { base::emplace_back(elem); }
+
+  void push_back(value_type &&elem) { base::emplace_back(std::move(elem)); }
+
+  template <typename U> void set(size_type num, U &&elem) {
+    mutable_at(num) = std::forward<U>(elem);
+  }
+
+  void pop_back() { base::pop_back(); }
+
+  void clear() noexcept { base::reset(); }
+
+  /// O(1) snapshot of the current contents.
+  persistent_type persistent() const & { return persistent_type(base(*this)); }
+
+  /// Turns the transient into a persistent vector without copying.
+  persistent_type persistent() && {
+    return persistent_type(base(std::move(*this)));
+  }
+
+  void swap(transient_vector &other) noexcept { base::swap(other); }
+};
+
+template <typename Tp, typename Allocator>
+inline bool operator==(const persistent_vector<Tp, Allocator> &x,
+                       const persistent_vector<Tp, Allocator> &y) {
+  return x.identical(y) ||
+         (x.size() == y.size() && std::equal(x.begin(), x.end(), y.begin()));
+}
+
+template <typename Tp, typename Allocator>
+inline bool operator!=(const persistent_vector<Tp, Allocator> &x,
+                       const persistent_vector<Tp, Allocator> &y) {
+  return !(x == y);
+}
+
+template <typename Tp, typename Allocator>
+inline void swap(persistent_vector<Tp, Allocator> &x,
+                 persistent_vector<Tp, Allocator> &y) noexcept {
+  x.swap(y);
+}
+
+template <typename Tp, typename Allocator>
+inline void swap(transient_vector<Tp, Allocator> &x,
+                 transient_vector<Tp, Allocator> &y) noexcept {
+  x.swap(y);
+}
+
+template <typename Tp, typename Allocator>
+struct is_trivially_relocatable<persistent_vector<Tp, Allocator>>
+    : is_trivially_relocatable<Allocator> {};
+
+template <typename Tp, typename Allocator>
+struct is_trivially_relocatable<transient_vector<Tp, Allocator>>
+    : is_trivially_relocatable<Allocator> {};
+
+} // namespace utl
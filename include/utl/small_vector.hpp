@@ -0,0 +1,271 @@
+#pragma once
+#include <utl/allocator.hpp>
+#include <utl/config.hpp>
+#include <utl/vector.hpp>
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+namespace utl {
+
+/// Allocator that hands out a fixed inline buffer of N elements once and
+/// forwards everything else to `Allocator`.
+///
+/// Each small_vector owns one of these, pointing at its own buffer, so two
+/// instances only compare equal when they share that buffer.
+template <typename T, size_t N, typename Allocator = allocator<T>>
+class small_vector_allocator {
+  using inner_traits = allocator_traits<Allocator>;
+
+public:
+  using value_type = T;
+  using inner_allocator_type = Allocator;
+  using propagate_on_container_copy_assignment = std::false_type;
+  using propagate_on_container_move_assignment = std::false_type;
+  using propagate_on_container_swap = std::false_type;
+  using is_always_equal = std::false_type;
+
+  template <typename U> struct rebind {
+    using other = small_vector_allocator<
+        U, N, typename inner_traits::template rebind_alloc<U>>;
+  };
+
+  small_vector_allocator(T *buffer, const Allocator &inner) noexcept
+      : m_inner(inner), m_buffer(buffer) {}
+
+  small_vector_allocator(const small_vector_allocator &) noexcept = default;
+
+  /// Rebound copies have no inline buffer.
+  template <typename U, typename A>
+  small_vector_allocator(const small_vector_allocator<U, N, A> &other) noexcept
+      : m_inner(other.inner_allocator()), m_buffer(nullptr) {}
+
+  small_vector_allocator &
+  operator=(const small_vector_allocator &) noexcept = default;
+
+  T *allocate(size_t n) {
+    if (n <= N && m_buffer && !m_in_use) {
+      m_in_use = true;
+      return m_buffer;
+    }
+    return inner_traits::allocate(m_inner, n);
+  }
+
+  allocation_result<T *> allocate_at_least(size_t n) {
+    if (n <= N && m_buffer && !m_in_use) {
+      m_in_use = true;
+      return {m_buffer, N};
+    }
+    const auto result = utl::allocate_at_least(m_inner, n);
+    return {result.ptr, result.count};
+  }
+
+  void deallocate(T *p, size_t n) noexcept {
+    if (p == m_buffer)
+      m_in_use = false;
+    else
+      inner_traits::deallocate(m_inner, p, n);
+  }
+
+  size_t try_expand(T *p, size_t n, size_t new_n) noexcept {
+    return p == m_buffer ? 0 : utl::try_expand(m_inner, p, n, new_n);
+  }
+
+  allocation_result<T *> try_reallocate(T *p, size_t n, size_t new_n) noexcept {
+    if (p == m_buffer)
+      return {nullptr, 0};
+    const auto result = utl::try_reallocate(m_inner, p, n, new_n);
+    return {result.ptr, result.count};
+  }
+
+  const Allocator &inner_allocator() const noexcept { return m_inner; }
+
+  friend bool operator==(const small_vector_allocator &lhs,
+                         const small_vector_allocator &rhs) noexcept {
+    return lhs.m_buffer == rhs.m_buffer && lhs.m_inner == rhs.m_inner;
+  }
+
+  friend bool operator!=(const small_vector_allocator &lhs,
+                         const small_vector_allocator &rhs) noexcept {
+    return !(lhs == rhs);
+  }
+
+private:
+  Allocator m_inner;
+  T *m_buffer;
+  bool m_in_use = false;
+};
+
+namespace detail {
+
+template <typename T, size_t N> struct small_vector_storage {
+  T *inline_data() noexcept { return reinterpret_cast<T *>(m_inline); }
+
+  alignas(T) unsigned char m_inline[N * sizeof(T)];
+};
+
+} // namespace detail
+
+/// A vector that keeps up to N elements in place and spills to `Allocator`
+/// beyond that.
+///
+/// All operations are those of utl::vector, with the same exception
+/// guarantees; only the source of the first N elements' storage differs.
+/// Moving a small_vector steals its heap buffer but has to move elements
+/// that are still inline.
+template <typename T, size_t N, typename Allocator = allocator<T>>
+class small_vector
+    : private detail::small_vector_storage<T, N>,
+      public vector<T, small_vector_allocator<T, N, Allocator>> {
+  static_assert(N > 0, "small_vector needs room for at least one element");
+
+  using storage = detail::small_vector_storage<T, N>;
+  using base = vector<T, small_vector_allocator<T, N, Allocator>>;
+  using inner_traits = allocator_traits<Allocator>;
+
+public:
+  using typename base::const_reference;
+  using typename base::size_type;
+  using typename base::value_type;
+
+  static constexpr size_t inline_capacity = N;
+
+  small_vector() noexcept(noexcept(Allocator())) : small_vector(Allocator()) {}
+
+  explicit small_vector(const Allocator &allocator) noexcept
+      : base(make_allocator(allocator)) {}
+
+  explicit small_vector(size_type num,
+                        const Allocator &allocator = Allocator())
+      : small_vector(allocator) {
+    this->resize(num);
+  }
+
+  small_vector(size_type num, const_reference val,
+               const Allocator &allocator = Allocator())
+      : small_vector(allocator) {
+    this->assign(num, val);
+  }
+
+  template <typename InputIterator,
+            typename = typename iterator_traits<InputIterator>::iterator_category>
+  small_vector(InputIterator first, InputIterator last,
+               const Allocator &allocator = Allocator())
+      : small_vector(allocator) {
+    this->assign(first, last);
+  }
+
+  small_vector(initializer_list<value_type> il,
+               const Allocator &allocator = Allocator())
+      : small_vector(allocator) {
+    this->assign(il.begin(), il.end());
+  }
+
+  small_vector(const small_vector &other)
+      : small_vector(inner_traits::select_on_container_copy_construction(
+            other.inner_allocator())) {
+    this->assign(other.begin(), other.end());
+  }
+
+  small_vector(small_vector &&other) noexcept(
+      std::is_nothrow_move_constructible_v<T>)
+      : small_vector(other.inner_allocator()) {
+    take(other);
+  }
+
+  small_vector &operator=(const small_vector &other) {
+    base::operator=(other);
+    return *this;
+  }
+
+  /// Steals `other`'s heap buffer, along with its inner allocator if that
+  /// propagates, unless the inner allocators differ and do not propagate.
+  /// Otherwise, or if `other` is inline, moves element by element; that
+  /// only allocates in the unequal case.
+  small_vector &operator=(small_vector &&other) noexcept(
+      std::is_nothrow_move_constructible_v<T> &&
+      std::is_nothrow_move_assignable_v<T> &&
+      (inner_traits::propagate_on_container_move_assignment::value ||
+       inner_traits::is_always_equal::value)) {
+    constexpr bool move_inner =
+        inner_traits::propagate_on_container_move_assignment::value;
+    if (this == &other)
+      return *this;
+    if (!other.is_inline() &&
+        (move_inner || inner_allocator() == other.inner_allocator())) {
+      base::destroy_and_dealloc(this->m_data, this->m_size, this->cap(),
+                                this->alloc());
+      this->m_data = nullptr;
+      this->cap() = 0;
+      this->m_size = 0;
+      if constexpr (move_inner)
+        this->alloc() = make_allocator(other.inner_allocator());
+      take(other);
+    } else {
+      base::operator=(std::move(other));
+    }
+    return *this;
+  }
+
+  small_vector &operator=(initializer_list<value_type> il) {
+    this->assign(il.begin(), il.end());
+    return *this;
+  }
+
+  void swap(small_vector &other) {
+    if (!is_inline() && !other.is_inline() &&
+        inner_allocator() == other.inner_allocator()) {
+      using std::swap;
+      swap(this->m_data, other.m_data);
+      swap(this->cap(), other.cap());
+      swap(this->m_size, other.m_size);
+    } else {
+      base::swap(other);
+    }
+  }
+
+  /// Whether the elements live in the inline buffer (or nowhere yet).
+  bool is_inline() const noexcept {
+    return !this->m_data || this->m_data == inline_data();
+  }
+
+  const Allocator &inner_allocator() const noexcept {
+    return this->alloc().inner_allocator();
+  }
+
+private:
+  small_vector_allocator<T, N, Allocator>
+  make_allocator(const Allocator &allocator) noexcept {
+    return {storage::inline_data(), allocator};
+  }
+
+  const T *inline_data() const noexcept {
+    return reinterpret_cast<const T *>(storage::m_inline);
+  }
+
+  /// Takes `other`'s heap buffer, or moves its inline elements, leaving it
+  /// empty. Expects this vector to hold no storage.
+  void take(small_vector &other) {
+    if (other.is_inline()) {
+      this->reserve(other.m_size);
+      for (auto &elem : other)
+        this->emplace_back(std::move(elem));
+      other.clear();
+      return;
+    }
+    this->m_data = other.m_data;
+    this->cap() = other.cap();
+    this->m_size = other.m_size;
+    other.m_data = nullptr;
+    other.cap() = 0;
+    other.m_size = 0;
+  }
+};
+
+template <typename T, size_t N, typename Allocator>
+void swap(small_vector<T, N, Allocator> &x, small_vector<T, N, Allocator> &y) {
+  x.swap(y);
+}
+
+} // namespace utl
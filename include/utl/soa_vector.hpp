@@ -0,0 +1,388 @@
+#pragma once
+#include <utl/allocator.hpp>
+#include <utl/config.hpp>
+#include <utl/span.hpp>
+#include <utl/vector.hpp>
+
+#include <cstddef>
+#include <iterator>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace utl {
+
+template <typename Vector, typename Ref> class soa_iterator {
+public:
+  using value_type = typename Vector::value_type;
+  using reference = Ref;
+  using pointer = void;
+  using difference_type = std::ptrdiff_t;
+  // Like std::vector<bool>, a random access iterator over proxies.
+  using iterator_category = std::random_access_iterator_tag;
+
+  constexpr soa_iterator() noexcept = default;
+
+  constexpr soa_iterator(Vector *vec, size_t idx) noexcept
+      : m_vec(vec), m_idx(idx) {}
+
+  template <typename V, typename R,
+            typename = std::enable_if_t<std::is_convertible_v<V *, Vector *>>>
+  constexpr soa_iterator(const soa_iterator<V, R> &other) noexcept
+      : m_vec(other.m_vec), m_idx(other.m_idx) {}
+
+  reference operator*() const { return (*m_vec)[m_idx]; }
+  reference operator[](difference_type diff) const {
+    return (*m_vec)[m_idx + diff];
+  }
+
+  constexpr size_t index() const noexcept { return m_idx; }
+
+  constexpr soa_iterator &operator++() noexcept {
+    ++m_idx;
+    return *this;
+  }
+  constexpr soa_iterator operator++(int) noexcept {
+    const soa_iterator retval = *this;
+    ++m_idx;
+    return retval;
+  }
+  constexpr soa_iterator &operator--() noexcept {
+    --m_idx;
+    return *this;
+  }
+  constexpr soa_iterator operator--(int) noexcept {
+    const soa_iterator retval = *this;
+    --m_idx;
+    return retval;
+  }
+  constexpr soa_iterator &operator+=(difference_type diff) noexcept {
+    m_idx += diff;
+    return *this;
+  }
+  constexpr soa_iterator &operator-=(difference_type diff) noexcept {
+    m_idx -= diff;
+    return *this;
+  }
+
+  friend constexpr soa_iterator operator+(soa_iterator it,
+                                          difference_type diff) noexcept {
+    return it += diff;
+  }
+  friend constexpr soa_iterator operator+(difference_type diff,
+                                          soa_iterator it) noexcept {
+    return it += diff;
+  }
+  friend constexpr soa_iterator operator-(soa_iterator it,
+                                          difference_type diff) noexcept {
+    return it -= diff;
+  }
+  friend constexpr difference_type operator-(const soa_iterator &lhs,
+                                             const soa_iterator &rhs) noexcept {
+    return static_cast<difference_type>(lhs.m_idx - rhs.m_idx);
+  }
+
+  friend constexpr bool operator==(const soa_iterator &lhs,
+                                   const soa_iterator &rhs) noexcept {
+    return lhs.m_idx == rhs.m_idx;
+  }
+  friend constexpr bool operator!=(const soa_iterator &lhs,
+                                   const soa_iterator &rhs) noexcept {
+    return lhs.m_idx != rhs.m_idx;
+  }
+  friend constexpr bool operator<(const soa_iterator &lhs,
+                                  const soa_iterator &rhs) noexcept {
+    return lhs.m_idx < rhs.m_idx;
+  }
+  friend constexpr bool operator>(const soa_iterator &lhs,
+                                  const soa_iterator &rhs) noexcept {
+    return lhs.m_idx > rhs.m_idx;
+  }
+  friend constexpr bool operator<=(const soa_iterator &lhs,
+                                   const soa_iterator &rhs) noexcept {
+    return lhs.m_idx <= rhs.m_idx;
+  }
+  friend constexpr bool operator>=(const soa_iterator &lhs,
+                                   const soa_iterator &rhs) noexcept {
+    return lhs.m_idx >= rhs.m_idx;
+  }
+
+private:
+  template <typename, typename> friend class soa_iterator;
+
+  Vector *m_vec = nullptr;
+  size_t m_idx = 0;
+};
+
+/// A sequence of records stored column by column: one contiguous
+/// utl::vector per field.
+///
+/// Rows are read and written through proxies, std::tuple<Ts &...>, and a
+/// whole field is available as a span from column<I>(). Every column
+/// allocates through `Allocator` rebound to its element type. Appending
+/// reserves room in all columns first and undoes the columns already
+/// written if a constructor throws, so push_back and emplace_back leave
+/// the container unchanged on failure.
+template <typename Allocator, typename... Ts> class basic_soa_vector {
+  static_assert(sizeof...(Ts) > 0, "soa_vector needs at least one column");
+
+  template <typename T>
+  using column_allocator =
+      typename allocator_traits<Allocator>::template rebind_alloc<T>;
+
+  template <typename T> using column_type = vector<T, column_allocator<T>>;
+
+  using indices = std::index_sequence_for<Ts...>;
+
+public:
+  // types:
+  using value_type = std::tuple<Ts...>;
+  using allocator_type = Allocator;
+  using reference = std::tuple<Ts &...>;
+  using const_reference = std::tuple<const Ts &...>;
+  using size_type = size_t;
+  using difference_type = std::ptrdiff_t;
+  using iterator = soa_iterator<basic_soa_vector, reference>;
+  using const_iterator = soa_iterator<const basic_soa_vector, const_reference>;
+  using reverse_iterator = std::reverse_iterator<iterator>;
+  using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+  template <size_t I>
+  using column_value_type = std::tuple_element_t<I, value_type>;
+
+  // construct/copy/destroy
+  basic_soa_vector() noexcept(noexcept(Allocator()))
+      : basic_soa_vector(Allocator()) {}
+
+  explicit basic_soa_vector(const allocator_type &allocator) noexcept
+      : m_columns(column_type<Ts>(column_allocator<Ts>(allocator))...) {}
+
+  explicit basic_soa_vector(size_type num,
+                            const allocator_type &allocator = allocator_type())
+      : m_columns(column_type<Ts>(num, column_allocator<Ts>(allocator))...) {}
+
+  basic_soa_vector(initializer_list<value_type> il,
+                   const allocator_type &allocator = allocator_type())
+      : basic_soa_vector(allocator) {
+    reserve(il.size());
+    for (const auto &row : il)
+      push_back(row);
+  }
+
+  allocator_type get_allocator() const noexcept {
+    return allocator_type(std::get<0>(m_columns).get_allocator());
+  }
+
+  // iterators:
+  iterator begin() noexcept { return iterator(this, 0); }
+  const_iterator begin() const noexcept { return const_iterator(this, 0); }
+  iterator end() noexcept { return iterator(this, size()); }
+  const_iterator end() const noexcept { return const_iterator(this, size()); }
+  reverse_iterator rbegin() noexcept { return reverse_iterator(end()); }
+  const_reverse_iterator rbegin() const noexcept {
+    return const_reverse_iterator(end());
+  }
+  reverse_iterator rend() noexcept { return reverse_iterator(begin()); }
+  const_reverse_iterator rend() const noexcept {
+    return const_reverse_iterator(begin());
+  }
+  const_iterator cbegin() const noexcept { return begin(); }
+  const_iterator cend() const noexcept { return end(); }
+  const_reverse_iterator crbegin() const noexcept { return rbegin(); }
+  const_reverse_iterator crend() const noexcept { return rend(); }
+
+  // capacity
+  bool empty() const noexcept { return size() == 0; }
+  size_type size() const noexcept { return std::get<0>(m_columns).size(); }
+
+  /// Rows that fit in every column without reallocating.
+  size_type capacity() const noexcept {
+    return std::apply(
+        [](const auto &... column) {
+          size_type cap = size_type(-1);
+          ((cap = utl::min(cap, column.capacity())), ...);
+          return cap;
+        },
+        m_columns);
+  }
+
+  void reserve(size_type num) {
+    std::apply([num](auto &... column) { (column.reserve(num), ...); },
+               m_columns);
+  }
+
+  void resize(size_type num) {
+    reserve(num);
+    resize_columns(num, indices());
+  }
+
+  void shrink_to_fit() {
+    std::apply([](auto &... column) { (column.shrink_to_fit(), ...); },
+               m_columns);
+  }
+
+  // column access:
+  template <size_t I> span<column_value_type<I>> column() noexcept {
+    auto &col = std::get<I>(m_columns);
+    return {col.data(), col.size()};
+  }
+
+  template <size_t I> span<const column_value_type<I>> column() const noexcept {
+    const auto &col = std::get<I>(m_columns);
+    return {col.data(), col.size()};
+  }
+
+  // element access:
+  reference operator[](size_type num) { return row(num, indices()); }
+  const_reference operator[](size_type num) const {
+    return row(num, indices());
+  }
+  reference at(size_type num) {
+    if (num < size())
+      return row(num, indices());
+    UTL_THROW(std::out_of_range("soa_vector::at"));
+  }
+  const_reference at(size_type num) const {
+    if (num < size())
+      return row(num, indices());
+    UTL_THROW(std::out_of_range("soa_vector::at"));
+  }
+  reference front() { return row(0, indices()); }
+  const_reference front() const { return row(0, indices()); }
+  reference back() { return row(size() - 1, indices()); }
+  const_reference back() const { return row(size() - 1, indices()); }
+
+  // modifiers
+  /// Appends a row built from one argument per column.
+  template <typename... Args> reference emplace_back(Args &&... args) {
+    static_assert(sizeof...(Args) == sizeof...(Ts),
+                  "emplace_back takes one argument per column");
+    reserve_one();
+    append(indices(), std::forward<Args>(args)...);
+    return back();
+  }
+
+  void push_back(const value_type &row) {
+    reserve_one();
+    std::apply(
+        [this](const auto &... fields) { append(indices(), fields...); }, row);
+  }
+
+  void push_back(value_type &&row) {
+    reserve_one();
+    std::apply(
+        [this](auto &&... fields) { append(indices(), std::move(fields)...); },
+        row);
+  }
+
+  void pop_back() {
+    std::apply([](auto &... column) { (column.pop_back(), ...); }, m_columns);
+  }
+
+  iterator erase(const_iterator position) {
+    return erase(position, position + 1);
+  }
+
+  iterator erase(const_iterator first, const_iterator last) {
+    const size_type idx = first.index();
+    const size_type num = last - first;
+    std::apply(
+        [idx, num](auto &... column) {
+          (column.erase(column.cbegin() + idx, column.cbegin() + idx + num),
+           ...);
+        },
+        m_columns);
+    return begin() + idx;
+  }
+
+  void swap(basic_soa_vector &other) { swap_columns(other, indices()); }
+
+  void clear() noexcept {
+    std::apply([](auto &... column) { (column.clear(), ...); }, m_columns);
+  }
+
+  friend bool operator==(const basic_soa_vector &x,
+                         const basic_soa_vector &y) {
+    return x.m_columns == y.m_columns;
+  }
+
+  friend bool operator!=(const basic_soa_vector &x,
+                         const basic_soa_vector &y) {
+    return !(x == y);
+  }
+
+private:
+  template <size_t... I>
+  reference row(size_type num, std::index_sequence<I...>) {
+    return reference(std::get<I>(m_columns)[num]...);
+  }
+
+  template <size_t... I>
+  const_reference row(size_type num, std::index_sequence<I...>) const {
+    return const_reference(std::get<I>(m_columns)[num]...);
+  }
+
+  void reserve_one() {
+    const size_type num = size() + 1;
+    std::apply(
+        [num](auto &... column) {
+          ((num > column.capacity() ? column.reserve(num) : void()), ...);
+        },
+        m_columns);
+  }
+
+  /// Constructs one field per column; every column has room for it. If a
+  /// constructor throws, the fields already added are removed again.
+  template <size_t... I, typename... Args>
+  void append(std::index_sequence<I...>, Args &&... args) {
+    size_type done = 0;
+    UTL_TRY {
+      ((std::get<I>(m_columns).emplace_back(std::forward<Args>(args)),
+        ++done),
+       ...);
+    }
+    UTL_CATCH(...) {
+      ((I < done ? std::get<I>(m_columns).pop_back() : void()), ...);
+      UTL_RETHROW;
+    }
+  }
+
+  template <size_t... I>
+  void resize_columns(size_type num, std::index_sequence<I...>) {
+    const size_type old = size();
+    size_type done = 0;
+    UTL_TRY {
+      ((std::get<I>(m_columns).resize(num), ++done), ...);
+    }
+    UTL_CATCH(...) {
+      ((I < done ? std::get<I>(m_columns).resize(old) : void()), ...);
+      UTL_RETHROW;
+    }
+  }
+
+  template <size_t... I>
+  void swap_columns(basic_soa_vector &other, std::index_sequence<I...>) {
+    (std::get<I>(m_columns).swap(std::get<I>(other.m_columns)), ...);
+  }
+
+  std::tuple<column_type<Ts>...> m_columns;
+};
+
+template <typename Allocator, typename... Ts>
+void swap(basic_soa_vector<Allocator, Ts...> &x,
+          basic_soa_vector<Allocator, Ts...> &y) {
+  x.swap(y);
+}
+
+template <typename... Ts>
+using soa_vector = basic_soa_vector<allocator<std::byte>, Ts...>;
+
+namespace pmr {
+template <typename T> class polymorphic_allocator;
+
+template <typename... Ts>
+using soa_vector = basic_soa_vector<polymorphic_allocator<std::byte>, Ts...>;
+} // namespace pmr
+
+} // namespace utl
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <utl/algorithm.hpp>
 #include <utl/config.hpp>
 #include <utl/iterator.hpp>
 
@@ -296,6 +297,24 @@ as_writable_bytes(span<T, N> s) noexcept {
   return {reinterpret_cast<byte *>(s.data()), s.size_bytes()};
 }
 
+/// Element-wise equality; views of integers compare with memcmp.
+template <class T, std::size_t N, class U, std::size_t M,
+          typename = std::enable_if_t<
+              std::is_same_v<std::remove_cv_t<T>, std::remove_cv_t<U>>>>
+bool operator==(span<T, N> x, span<U, M> y) {
+  return x.size() == y.size() &&
+         utl::equal(static_cast<const T *>(x.data()),
+                    static_cast<const T *>(x.data()) + x.size(),
+                    static_cast<const T *>(y.data()));
+}
+
+template <class T, std::size_t N, class U, std::size_t M,
+          typename = std::enable_if_t<
+              std::is_same_v<std::remove_cv_t<T>, std::remove_cv_t<U>>>>
+bool operator!=(span<T, N> x, span<U, M> y) {
+  return !(x == y);
+}
+
 template <std::size_t I, class T, std::size_t N>
 constexpr T &get(span<T, N> s) noexcept {
   return s[I];
@@ -0,0 +1,479 @@
+#pragma once
+#include <utl/algorithm.hpp>
+#include <utl/config.hpp>
+#include <utl/type_traits.hpp>
+#include <utl/vector.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace utl {
+namespace detail {
+
+/// Array of trivial elements for static_vector, left uninitialized. From
+/// C++20 it shares a union with a placeholder, which keeps it usable in
+/// constant expressions. C++17 cannot start a constant expression with
+/// uninitialized storage, so there arrays of up to 64 bytes are zeroed
+/// instead, which costs a few stores.
+#if __cpp_constexpr >= 202002L
+template <typename T, size_t N, bool = true> struct static_vector_array {
+  constexpr static_vector_array() noexcept : m_unused() {}
+
+  union {
+    char m_unused;
+    T m_data[N ? N : 1];
+  };
+};
+#else
+template <typename T, size_t N, bool = (N * sizeof(T) <= 64)>
+struct static_vector_array {
+  T m_data[N ? N : 1] = {};
+};
+
+template <typename T, size_t N> struct static_vector_array<T, N, false> {
+  T m_data[N ? N : 1];
+};
+#endif
+
+/// Element storage for static_vector. Trivial types live in a plain array,
+/// so the whole container is trivially copyable and construction costs
+/// next to nothing.
+template <typename T, size_t N, bool = std::is_trivial_v<T>>
+class static_vector_storage : static_vector_array<T, N> {
+protected:
+  constexpr T *elements() noexcept { return this->m_data; }
+  constexpr const T *elements() const noexcept { return this->m_data; }
+
+  template <typename... Args>
+  constexpr void construct(size_t i, Args &&... args) {
+    this->m_data[i] = T(std::forward<Args>(args)...);
+  }
+
+  constexpr void destroy(size_t, size_t) noexcept {}
+
+  size_t m_size = 0;
+};
+
+/// Other types are built in uninitialized storage and copied or moved
+/// element by element.
+template <typename T, size_t N> class static_vector_storage<T, N, false> {
+protected:
+  static_vector_storage() noexcept {}
+
+  static_vector_storage(const static_vector_storage &other) {
+    construct_from(other.m_data, other.m_size);
+  }
+
+  static_vector_storage(static_vector_storage &&other) noexcept(
+      std::is_nothrow_move_constructible_v<T>) {
+    construct_from(std::make_move_iterator(other.m_data), other.m_size);
+  }
+
+  static_vector_storage &operator=(const static_vector_storage &other) {
+    if (this != &other)
+      assign_from(other.m_data, other.m_size);
+    return *this;
+  }
+
+  static_vector_storage &operator=(static_vector_storage &&other) noexcept(
+      std::is_nothrow_move_constructible_v<T> &&
+      std::is_nothrow_move_assignable_v<T>) {
+    if (this != &other)
+      assign_from(std::make_move_iterator(other.m_data), other.m_size);
+    return *this;
+  }
+
+  ~static_vector_storage() { destroy(0, m_size); }
+
+  T *elements() noexcept { return m_data; }
+  const T *elements() const noexcept { return m_data; }
+
+  template <typename... Args> void construct(size_t i, Args &&... args) {
+    ::new (static_cast<void *>(m_data + i)) T(std::forward<Args>(args)...);
+  }
+
+  void destroy(size_t first, size_t last) noexcept {
+    if constexpr (!std::is_trivially_destructible_v<T>)
+      for (size_t i = first; i != last; ++i)
+        m_data[i].~T();
+  }
+
+  union {
+    T m_data[N ? N : 1];
+  };
+  size_t m_size = 0;
+
+private:
+  template <typename It> void construct_from(It it, size_t count) {
+    UTL_TRY {
+      for (; m_size != count; ++m_size)
+        construct(m_size, *it++);
+    }
+    UTL_CATCH(...) {
+      destroy(0, m_size);
+      UTL_RETHROW;
+    }
+  }
+
+  template <typename It> void assign_from(It it, size_t count) {
+    const size_t common = utl::min(m_size, count);
+    for (size_t i = 0; i != common; ++i)
+      m_data[i] = *it++;
+    destroy(common, m_size);
+    m_size = common;
+    for (; m_size != count; ++m_size)
+      construct(m_size, *it++);
+  }
+};
+
+} // namespace detail
+
+/// A vector with room for N elements inside the object; it never
+/// allocates.
+///
+/// Growing past N throws std::bad_alloc (or aborts under
+/// UTL_NO_EXCEPTIONS); try_push_back and try_emplace_back return nullptr
+/// instead. For trivial T everything except insert, erase and swap is
+/// constexpr; before C++20 that needs N * sizeof(T) <= 64, and only larger
+/// arrays are left unzeroed.
+template <typename T, size_t N>
+class static_vector : detail::static_vector_storage<T, N> {
+  using base = detail::static_vector_storage<T, N>;
+  using base::construct;
+  using base::destroy;
+  using base::elements;
+  using base::m_size;
+
+public:
+  // types:
+  using value_type = T;
+  using pointer = T *;
+  using const_pointer = const T *;
+  using reference = value_type &;
+  using const_reference = const value_type &;
+  using size_type = size_t;
+  using difference_type = std::ptrdiff_t;
+  using iterator = vector_iterator<value_type>;
+  using const_iterator = vector_const_iterator<value_type>;
+  using reverse_iterator = std::reverse_iterator<iterator>;
+  using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+  // construct/copy/destroy
+  constexpr static_vector() noexcept = default;
+
+  constexpr explicit static_vector(size_type num) { resize(num); }
+
+  constexpr static_vector(size_type num, const_reference val) {
+    assign(num, val);
+  }
+
+  template <typename InputIterator,
+            typename = typename iterator_traits<InputIterator>::iterator_category>
+  constexpr static_vector(InputIterator first, InputIterator last) {
+    assign(first, last);
+  }
+
+  constexpr static_vector(initializer_list<value_type> il) {
+    assign(il.begin(), il.end());
+  }
+
+  constexpr static_vector &operator=(initializer_list<value_type> il) {
+    assign(il.begin(), il.end());
+    return *this;
+  }
+
+  constexpr void assign(size_type num, const_reference val) {
+    check_capacity(num);
+    clear();
+    for (; m_size != num; ++m_size)
+      construct(m_size, val);
+  }
+
+  template <typename InputIterator,
+            typename = typename iterator_traits<InputIterator>::iterator_category>
+  constexpr void assign(InputIterator first, InputIterator last) {
+    clear();
+    while (first != last)
+      emplace_back(*first++);
+  }
+
+  constexpr void assign(initializer_list<value_type> il) {
+    assign(il.begin(), il.end());
+  }
+
+  // iterators:
+  constexpr iterator begin() noexcept { return iterator{data()}; }
+  constexpr const_iterator begin() const noexcept {
+    return const_iterator{data()};
+  }
+  constexpr iterator end() noexcept { return iterator{data() + m_size}; }
+  constexpr const_iterator end() const noexcept {
+    return const_iterator{data() + m_size};
+  }
+  constexpr reverse_iterator rbegin() noexcept {
+    return reverse_iterator(end());
+  }
+  constexpr const_reverse_iterator rbegin() const noexcept {
+    return const_reverse_iterator(end());
+  }
+  constexpr reverse_iterator rend() noexcept {
+    return reverse_iterator(begin());
+  }
+  constexpr const_reverse_iterator rend() const noexcept {
+    return const_reverse_iterator(begin());
+  }
+  constexpr const_iterator cbegin() const noexcept { return begin(); }
+  constexpr const_iterator cend() const noexcept { return end(); }
+  constexpr const_reverse_iterator crbegin() const noexcept {
+    return rbegin();
+  }
+  constexpr const_reverse_iterator crend() const noexcept { return rend(); }
+
+  // capacity
+  constexpr bool empty() const noexcept { return m_size == 0; }
+  constexpr bool full() const noexcept { return m_size == N; }
+  constexpr size_type size() const noexcept { return m_size; }
+  static constexpr size_type max_size() noexcept { return N; }
+  static constexpr size_type capacity() noexcept { return N; }
+
+  constexpr void resize(size_type size) {
+    check_capacity(size);
+    for (; m_size < size; ++m_size)
+      construct(m_size);
+    shrink(size);
+  }
+
+  constexpr void resize(size_type size, const_reference val) {
+    check_capacity(size);
+    for (; m_size < size; ++m_size)
+      construct(m_size, val);
+    shrink(size);
+  }
+
+  constexpr void reserve(size_type num) { check_capacity(num); }
+
+  constexpr void shrink_to_fit() noexcept {}
+
+  // element access:
+  constexpr reference operator[](size_type num) { return data()[num]; }
+  constexpr const_reference operator[](size_type num) const {
+    return data()[num];
+  }
+  constexpr reference at(size_type num) {
+    if (num < m_size)
+      return data()[num];
+    UTL_THROW(std::out_of_range("static_vector::at"));
+  }
+  constexpr const_reference at(size_type num) const {
+    if (num < m_size)
+      return data()[num];
+    UTL_THROW(std::out_of_range("static_vector::at"));
+  }
+  constexpr reference front() { return data()[0]; }
+  constexpr const_reference front() const { return data()[0]; }
+  constexpr reference back() { return data()[m_size - 1]; }
+  constexpr const_reference back() const { return data()[m_size - 1]; }
+
+  // data access
+  constexpr pointer data() noexcept { return elements(); }
+  constexpr const_pointer data() const noexcept { return elements(); }
+
+  // modifiers
+  template <typename... Args>
+  constexpr reference emplace_back(Args &&... args) {
+    check_capacity(m_size + 1);
+    construct(m_size, std::forward<Args>(args)...);
+    return data()[m_size++];
+  }
+
+  constexpr void push_back(const_reference elem) { emplace_back(elem); }
+
+  constexpr void push_back(value_type &&elem) {
+    emplace_back(std::move(elem));
+  }
+
+  /// Appends an element unless the vector is full; returns a pointer to it,
+  /// or nullptr without constructing anything.
+  template <typename... Args>
+  constexpr pointer try_emplace_back(Args &&... args) {
+    if (full())
+      return nullptr;
+    construct(m_size, std::forward<Args>(args)...);
+    return data() + m_size++;
+  }
+
+  constexpr pointer try_push_back(const_reference elem) {
+    return try_emplace_back(elem);
+  }
+
+  constexpr pointer try_push_back(value_type &&elem) {
+    return try_emplace_back(std::move(elem));
+  }
+
+  constexpr void pop_back() noexcept { shrink(m_size - 1); }
+
+  template <typename... Args>
+  iterator emplace(const_iterator position, Args &&... args) {
+    const size_type idx = position - cbegin();
+    emplace_back(std::forward<Args>(args)...);
+    rotate_tail(idx, m_size - 1);
+    return begin() + idx;
+  }
+
+  iterator insert(const_iterator position, const_reference elem) {
+    return emplace(position, elem);
+  }
+
+  iterator insert(const_iterator position, value_type &&elem) {
+    return emplace(position, std::move(elem));
+  }
+
+  iterator insert(const_iterator position, size_type num,
+                  const_reference elem) {
+    check_capacity(m_size + num);
+    const size_type idx = position - cbegin();
+    const size_type size = m_size;
+    append([&] {
+      for (size_type i = 0; i != num; ++i)
+        emplace_back(elem);
+    });
+    rotate_tail(idx, size);
+    return begin() + idx;
+  }
+
+  template <typename InputIterator,
+            typename = typename iterator_traits<InputIterator>::iterator_category>
+  iterator insert(const_iterator position, InputIterator first,
+                  InputIterator last) {
+    const size_type idx = position - cbegin();
+    const size_type size = m_size;
+    append([&] {
+      while (first != last)
+        emplace_back(*first++);
+    });
+    rotate_tail(idx, size);
+    return begin() + idx;
+  }
+
+  iterator insert(const_iterator position, initializer_list<value_type> il) {
+    return insert(position, il.begin(), il.end());
+  }
+
+  iterator erase(const_iterator position) {
+    return erase(position, position + 1);
+  }
+
+  iterator erase(const_iterator first, const_iterator last) {
+    const auto p = first.data();
+    const auto end = data() + m_size;
+    if constexpr (std::is_trivially_copyable_v<value_type>)
+      utl::copy(static_cast<const T *>(last.data()),
+                static_cast<const T *>(end), p);
+    else
+      std::move(last.data(), end, p);
+    shrink(m_size - static_cast<size_type>(last - first));
+    return iterator{p};
+  }
+
+  void swap(static_vector &other) noexcept(
+      std::is_nothrow_swappable_v<value_type> &&
+      std::is_nothrow_move_constructible_v<value_type>) {
+    auto &longer = m_size < other.m_size ? other : *this;
+    auto &shorter = m_size < other.m_size ? *this : other;
+    using std::swap;
+    for (size_type i = 0; i != shorter.m_size; ++i)
+      swap(data()[i], other.data()[i]);
+    for (size_type i = shorter.m_size; i != longer.m_size; ++i)
+      shorter.construct(i, std::move(longer.data()[i]));
+    const size_type size = shorter.m_size;
+    shorter.m_size = longer.m_size;
+    longer.shrink(size);
+  }
+
+  constexpr void clear() noexcept { shrink(0); }
+
+private:
+  static constexpr void check_capacity(size_type num) {
+    if (num > N)
+      UTL_THROW(std::bad_alloc());
+  }
+
+  constexpr void shrink(size_type size) noexcept {
+    if (size < m_size) {
+      destroy(size, m_size);
+      m_size = size;
+    }
+  }
+
+  /// Runs `fn`, which appends elements, and drops what it appended if it
+  /// throws.
+  template <typename Fn> void append(Fn &&fn) {
+    const size_type size = m_size;
+    UTL_TRY { fn(); }
+    UTL_CATCH(...) {
+      shrink(size);
+      UTL_RETHROW;
+    }
+  }
+
+  /// Moves the elements appended after `size` to position `idx`.
+  void rotate_tail(size_type idx, size_type size) {
+    if (idx != size)
+      std::rotate(data() + idx, data() + size, data() + m_size);
+  }
+};
+
+template <typename T, size_t N>
+constexpr bool operator==(const static_vector<T, N> &x,
+                          const static_vector<T, N> &y) {
+  if (x.size() != y.size())
+    return false;
+  for (size_t i = 0; i != x.size(); ++i)
+    if (!(x[i] == y[i]))
+      return false;
+  return true;
+}
+
+template <typename T, size_t N>
+constexpr bool operator!=(const static_vector<T, N> &x,
+                          const static_vector<T, N> &y) {
+  return !(x == y);
+}
+
+template <typename T, size_t N>
+bool operator<(const static_vector<T, N> &x, const static_vector<T, N> &y) {
+  return utl::lexicographical_compare(x.data(), x.data() + x.size(), y.data(),
+                                      y.data() + y.size());
+}
+
+template <typename T, size_t N>
+bool operator>(const static_vector<T, N> &x, const static_vector<T, N> &y) {
+  return y < x;
+}
+
+template <typename T, size_t N>
+bool operator<=(const static_vector<T, N> &x, const static_vector<T, N> &y) {
+  return !(y < x);
+}
+
+template <typename T, size_t N>
+bool operator>=(const static_vector<T, N> &x, const static_vector<T, N> &y) {
+  return !(x < y);
+}
+
+template <typename T, size_t N>
+void swap(static_vector<T, N> &x,
+          static_vector<T, N> &y) noexcept(noexcept(x.swap(y))) {
+  x.swap(y);
+}
+
+template <typename T, size_t N>
+struct is_trivially_relocatable<static_vector<T, N>>
+    : is_trivially_relocatable<T> {};
+
+} // namespace utl
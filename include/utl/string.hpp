@@ -1,8 +1,11 @@
 #pragma once
+#include <utl/algorithm.hpp>
 #include <utl/allocator.hpp>
 #include <utl/config.hpp>
 #include <utl/iterator.hpp>
+#include <utl/type_traits.hpp>
 
+#include <cassert>
 #include <string>
 
 namespace utl {
@@ -71,14 +74,65 @@ protected:
   string_base(size_type count, value_type ch,
               const allocator_type &alloc = allocator_type())
       : m_alloc(alloc), m_size(count) {
-    if (m_size >= max_buffer_size) {
-      m_data.data = alloc_traits::allocate(m_alloc, count + 1);
-      m_data.cap = count + 1;
+    if (m_size >= buffer_capacity) {
+      const auto result = utl::allocate_at_least(m_alloc, count + 1);
+      m_data.data = result.ptr;
+      m_data.cap = result.count;
       m_onheap = true;
     }
 
     traits_type::assign(data(), count, ch);
-    traits_type::assign(data() + count, value_type{});
+    traits_type::assign(data()[count], value_type{});
+  }
+
+  string_base(const string_base &other)
+      : string_base(other, alloc_traits::select_on_container_copy_construction(
+                               other.m_alloc)) {}
+
+  string_base(const string_base &other, const allocator_type &alloc)
+      : string_base(alloc) {
+    assign(other.data(), other.m_size);
+  }
+
+  string_base(string_base &&other) noexcept
+      : m_alloc(std::move(other.m_alloc)) {
+    take(other);
+  }
+
+  ~string_base() { deallocate(); }
+
+  string_base &operator=(const string_base &other) {
+    if (this == &other)
+      return *this;
+
+    if constexpr (alloc_traits::propagate_on_container_copy_assignment::value) {
+      if (m_alloc != other.m_alloc)
+        deallocate();
+      m_alloc = other.m_alloc;
+    }
+
+    assign(other.data(), other.m_size);
+    return *this;
+  }
+
+  string_base &operator=(string_base &&other) noexcept(
+      alloc_traits::propagate_on_container_move_assignment::value ||
+      alloc_traits::is_always_equal::value) {
+    if (this == &other)
+      return *this;
+
+    constexpr bool move_allocator =
+        alloc_traits::propagate_on_container_move_assignment::value;
+
+    if (move_allocator || m_alloc == other.m_alloc) {
+      deallocate();
+      if constexpr (move_allocator)
+        m_alloc = std::move(other.m_alloc);
+      take(other);
+    } else {
+      assign(other.data(), other.m_size);
+    }
+    return *this;
   }
 
 public:
@@ -112,10 +166,44 @@ public:
 
   size_type length() const noexcept { return m_size; }
 
+  size_type capacity() const noexcept {
+    return (m_onheap ? m_data.cap : buffer_capacity) - 1;
+  }
+
+  void reserve(size_type count) { grow(count); }
+
+  void resize(size_type count) { resize(count, value_type{}); }
+
+  void resize(size_type count, value_type ch) {
+    grow(count);
+    if (count > m_size)
+      traits_type::assign(data() + m_size, count - m_size, ch);
+    set_size(count);
+  }
+
+  /// Like resize(count), but new characters are left indeterminate.
+  void resize_uninitialized(size_type count) {
+    grow(count);
+    set_size(count);
+  }
+
+  /// Resizes to `count` indeterminate characters, calls
+  /// `op(data(), count)` to fill them and keeps the number of leading
+  /// characters it returns, which must not exceed `count`.
+  template <typename Operation>
+  void resize_and_overwrite(size_type count, Operation op) {
+    grow(count);
+    const size_type keep = std::move(op)(data(), count);
+    assert(keep <= count);
+    set_size(keep);
+  }
+
   pointer data() { return m_onheap ? m_data.data : m_buffer; }
 
   const_pointer data() const { return m_onheap ? m_data.data : m_buffer; }
 
+  allocator_type get_allocator() const noexcept { return m_alloc; }
+
 protected:
   struct HeapData {
     value_type *data;
@@ -123,6 +211,67 @@ protected:
   };
 
   static constexpr size_type max_buffer_size = 16;
+  static constexpr size_type buffer_capacity =
+      max_buffer_size / sizeof(value_type);
+
+  void deallocate() noexcept {
+    if (m_onheap) {
+      alloc_traits::deallocate(m_alloc, m_data.data, m_data.cap);
+      m_onheap = false;
+      m_size = 0;
+      m_buffer[0] = value_type{};
+    }
+  }
+
+  void assign(const value_type *s, size_type count) {
+    const size_type cap = m_onheap ? m_data.cap : buffer_capacity;
+    if (count >= cap) {
+      const auto result = utl::allocate_at_least(m_alloc, count + 1);
+      deallocate();
+      m_data.data = result.ptr;
+      m_data.cap = result.count;
+      m_onheap = true;
+    }
+
+    traits_type::copy(data(), s, count);
+    traits_type::assign(data()[count], value_type{});
+    m_size = count;
+  }
+
+  /// Makes room for `count` characters and the terminator, keeping the
+  /// contents. Capacity at least doubles so repeated growth is amortized.
+  void grow(size_type count) {
+    const size_type cap = m_onheap ? m_data.cap : buffer_capacity;
+    if (count < cap)
+      return;
+
+    const auto result =
+        utl::allocate_at_least(m_alloc, utl::max(count + 1, 2 * cap));
+    traits_type::copy(result.ptr, data(), m_size + 1);
+    if (m_onheap)
+      alloc_traits::deallocate(m_alloc, m_data.data, m_data.cap);
+    m_data.data = result.ptr;
+    m_data.cap = result.count;
+    m_onheap = true;
+  }
+
+  void set_size(size_type count) noexcept {
+    m_size = count;
+    traits_type::assign(data()[count], value_type{});
+  }
+
+  void take(string_base &other) noexcept {
+    m_onheap = other.m_onheap;
+    m_size = other.m_size;
+    if (m_onheap)
+      m_data = other.m_data;
+    else
+      traits_type::copy(m_buffer, other.m_buffer, buffer_capacity);
+
+    other.m_onheap = false;
+    other.m_size = 0;
+    other.m_buffer[0] = value_type{};
+  }
 
   allocator_type m_alloc;
   bool m_onheap = false;
@@ -140,14 +289,41 @@ class basic_string : public string_base<CharType, Traits, Allocator> {
   using base_type = string_base<CharType, Traits, Allocator>;
 
 public:
-  using base_type::base_type;
+  using typename base_type::size_type;
 
   basic_string() = default;
+
+  explicit basic_string(const Allocator &alloc) noexcept : base_type(alloc) {}
+
+  basic_string(size_type count, CharType ch,
+               const Allocator &alloc = Allocator())
+      : base_type(count, ch, alloc) {}
+
+  basic_string(const basic_string &other, const Allocator &alloc)
+      : base_type(other, alloc) {}
 };
 
+// The small buffer is addressed through data(), never by a stored pointer.
+template <typename CharType, typename Traits, typename Allocator>
+struct is_trivially_relocatable<basic_string<CharType, Traits, Allocator>>
+    : is_trivially_relocatable<Allocator> {};
+
 extern template class basic_string<char>;
 extern template class basic_string<wchar_t>;
 extern template class basic_string<char16_t>;
 extern template class basic_string<char32_t>;
 
+namespace pmr {
+template <typename T> class polymorphic_allocator;
+
+template <typename CharType, typename Traits = char_traits<CharType>>
+using basic_string =
+    utl::basic_string<CharType, Traits, polymorphic_allocator<CharType>>;
+
+using string = basic_string<char>;
+using wstring = basic_string<wchar_t>;
+using u16string = basic_string<char16_t>;
+using u32string = basic_string<char32_t>;
+} // namespace pmr
+
 } // namespace utl
@@ -0,0 +1,190 @@
+#pragma once
+#include <utl/allocator.hpp>
+#include <utl/config.hpp>
+
+#include <cstddef>
+#include <type_traits>
+
+namespace utl {
+namespace detail {
+
+/// Per-thread free lists, one per size class, backed by a central heap that
+/// exchanges blocks with the threads in batches.
+class thread_cache {
+public:
+  static constexpr size_t max_size = 32 * 1024;
+  static constexpr size_t max_align = 4096;
+  static constexpr size_t class_count = 40;
+
+  /// Size class for a request of `bytes` bytes, 0 < bytes <= max_size.
+  ///
+  /// Classes step by 16 bytes up to 128 and then four per power of two.
+  /// A class is always a multiple of the alignment of any type whose size
+  /// divides the request, so blocks carved from page-aligned spans are
+  /// suitably aligned.
+  static size_t size_class(size_t bytes) noexcept {
+    if (bytes <= 128)
+      return bytes == 0 ? 0 : (bytes - 1) / 16;
+    const size_t lg = log2(bytes - 1);
+    return 8 + (lg - 7) * 4 + ((bytes - 1) >> (lg - 2)) - 4;
+  }
+
+  static size_t class_size(size_t cls) noexcept {
+    if (cls < 8)
+      return 16 * (cls + 1);
+    const size_t base = size_t(128) << ((cls - 8) / 4);
+    return base + ((cls - 8) % 4 + 1) * (base / 4);
+  }
+
+  /// Blocks moved between a thread and the central heap at once.
+  static size_t batch_size(size_t cls) noexcept {
+    const size_t n = 16 * 1024 / class_size(cls);
+    return n < 2 ? 2 : n > 64 ? 64 : n;
+  }
+
+  static void *allocate(size_t cls) {
+    if (const auto cache = local())
+      return cache->allocate_local(cls);
+    return central_allocate(cls);
+  }
+
+  static void deallocate(void *p, size_t cls) noexcept {
+    if (const auto cache = local())
+      cache->deallocate_local(p, cls);
+    else
+      central_deallocate(p, cls);
+  }
+
+  thread_cache() noexcept;
+  thread_cache(const thread_cache &) = delete;
+  thread_cache &operator=(const thread_cache &) = delete;
+  ~thread_cache();
+
+private:
+  struct free_block {
+    free_block *next;
+  };
+
+  struct free_list {
+    free_block *head;
+    size_t count;
+  };
+
+  static size_t log2(size_t x) noexcept {
+#if defined(__GNUC__)
+    return sizeof(unsigned long long) * 8 - 1 -
+           static_cast<size_t>(__builtin_clzll(x));
+#else
+    size_t r = 0;
+    while (x >>= 1)
+      ++r;
+    return r;
+#endif
+  }
+
+  /// The calling thread's cache, or nullptr once it has been destroyed
+  /// during thread exit.
+  static thread_cache *local() noexcept {
+    thread_local thread_cache cache;
+    return cache.m_alive ? &cache : nullptr;
+  }
+
+  void *allocate_local(size_t cls) {
+    auto &list = m_lists[cls];
+    if (const auto block = list.head) {
+      list.head = block->next;
+      --list.count;
+      return block;
+    }
+    return refill(cls);
+  }
+
+  void deallocate_local(void *p, size_t cls) noexcept {
+    auto &list = m_lists[cls];
+    const auto block = static_cast<free_block *>(p);
+    block->next = list.head;
+    list.head = block;
+    if (++list.count > 2 * batch_size(cls))
+      flush(cls, batch_size(cls));
+  }
+
+  void *refill(size_t cls);
+  void flush(size_t cls, size_t count) noexcept;
+
+  static void *central_allocate(size_t cls);
+  static void central_deallocate(void *p, size_t cls) noexcept;
+
+  free_list m_lists[class_count];
+  bool m_alive;
+};
+
+} // namespace detail
+
+/// Stateless allocator that serves small requests from per-thread caches.
+///
+/// Blocks may be freed on any thread. Requests above thread_cache::max_size
+/// bytes, and over-aligned types, go to utl::allocator.
+template <typename T> class thread_cache_allocator {
+public:
+  using value_type = T;
+  using propagate_on_container_move_assignment = std::true_type;
+  using is_always_equal = std::true_type;
+  thread_cache_allocator() noexcept = default;
+  thread_cache_allocator(const thread_cache_allocator &) noexcept = default;
+  template <class U>
+  thread_cache_allocator(const thread_cache_allocator<U> &) noexcept {}
+  ~thread_cache_allocator() = default;
+  thread_cache_allocator &
+  operator=(const thread_cache_allocator &) noexcept = default;
+
+  T *allocate(size_t n) {
+    if (cached(n))
+      return static_cast<T *>(detail::thread_cache::allocate(
+          detail::thread_cache::size_class(n * sizeof(T))));
+    return allocator<T>().allocate(n);
+  }
+
+  allocation_result<T *> allocate_at_least(size_t n) {
+    if (cached(n)) {
+      const auto cls = detail::thread_cache::size_class(n * sizeof(T));
+      return {static_cast<T *>(detail::thread_cache::allocate(cls)),
+              detail::thread_cache::class_size(cls) / sizeof(T)};
+    }
+    return allocator<T>().allocate_at_least(n);
+  }
+
+  void deallocate(T *p, size_t n) noexcept {
+    if (cached(n))
+      detail::thread_cache::deallocate(
+          p, detail::thread_cache::size_class(n * sizeof(T)));
+    else
+      allocator<T>().deallocate(p, n);
+  }
+
+  size_t try_expand(T *p, size_t n, size_t new_n) noexcept {
+    return cached(n) ? 0 : allocator<T>().try_expand(p, n, new_n);
+  }
+
+  allocation_result<T *> try_reallocate(T *p, size_t n, size_t new_n) noexcept {
+    if (cached(n))
+      return {nullptr, 0};
+    return allocator<T>().try_reallocate(p, n, new_n);
+  }
+
+  friend constexpr bool operator==(const thread_cache_allocator &,
+                                   const thread_cache_allocator &) noexcept {
+    return true;
+  }
+  friend constexpr bool operator!=(const thread_cache_allocator &,
+                                   const thread_cache_allocator &) noexcept {
+    return false;
+  }
+
+private:
+  static constexpr bool cached(size_t n) noexcept {
+    return alignof(T) <= detail::thread_cache::max_align &&
+           n <= detail::thread_cache::max_size / sizeof(T);
+  }
+};
+
+} // namespace utl
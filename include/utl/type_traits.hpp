@@ -0,0 +1,29 @@
+#pragma once
+#include <utl/config.hpp>
+
+#include <memory>
+#include <type_traits>
+
+namespace utl {
+
+/// Whether an object of type T can be moved to new storage by copying its
+/// bytes and then forgetting the original without running its destructor.
+///
+/// True for trivially copyable types. Other types opt in by specializing
+/// the trait; they must not hold pointers into themselves or register
+/// their own address anywhere.
+template <typename T>
+struct is_trivially_relocatable
+    : std::bool_constant<std::is_trivially_copyable_v<T>> {};
+
+template <typename T>
+inline constexpr bool is_trivially_relocatable_v =
+    is_trivially_relocatable<T>::value;
+
+// libstdc++'s std::string points into its own small buffer, so only
+// unique_ptr is marked among the standard types.
+template <typename T>
+struct is_trivially_relocatable<std::unique_ptr<T, std::default_delete<T>>>
+    : std::true_type {};
+
+} // namespace utl
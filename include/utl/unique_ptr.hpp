@@ -1,7 +1,9 @@
 #pragma once
 
+#include <utl/allocator.hpp>
 #include <utl/compressed_pair.hpp>
 #include <utl/config.hpp>
+#include <utl/type_traits.hpp>
 #include <cassert>
 
 namespace utl {
@@ -134,6 +136,12 @@ public:
 
 template <class T, class Deleter> class unique_ptr<T[], Deleter> {};
 
+template <class T, class Deleter>
+struct is_trivially_relocatable<unique_ptr<T, Deleter>>
+    : std::bool_constant<
+          is_trivially_relocatable_v<typename unique_ptr<T, Deleter>::pointer> &&
+          is_trivially_relocatable_v<Deleter>> {};
+
 template <class T1, class D1, class T2, class D2>
 bool operator==(const unique_ptr<T1, D1> &x, const unique_ptr<T2, D2> &y) {
   return x.get() == y.get();
@@ -237,4 +245,33 @@ unique_ptr<T> make_unique(Args &&... args) {
   return unique_ptr<T>(new T(std::forward<Args>(args)...));
 }
 
+/// Deleter for objects created by allocate_unique: destroys and frees the
+/// object through a copy of the allocator that made it.
+template <typename Alloc> struct allocator_delete {
+  using pointer = typename allocator_traits<Alloc>::pointer;
+
+  Alloc alloc;
+
+  void operator()(pointer p) {
+    allocator_traits<Alloc>::destroy(alloc, p);
+    allocator_traits<Alloc>::deallocate(alloc, p, 1);
+  }
+};
+
+/// make_unique with the object allocated through `alloc`.
+template <typename T, typename Alloc, typename... Args>
+auto allocate_unique(const Alloc &alloc, Args &&... args) {
+  using rebound = typename allocator_traits<Alloc>::template rebind_alloc<T>;
+  using traits = allocator_traits<rebound>;
+
+  allocator_delete<rebound> deleter{rebound(alloc)};
+  const auto p = traits::allocate(deleter.alloc, 1);
+  UTL_TRY { traits::construct(deleter.alloc, p, std::forward<Args>(args)...); }
+  UTL_CATCH(...) {
+    traits::deallocate(deleter.alloc, p, 1);
+    UTL_RETHROW;
+  }
+  return unique_ptr<T, allocator_delete<rebound>>(p, std::move(deleter));
+}
+
 } // namespace utl
@@ -1,13 +1,21 @@
 ﻿#pragma once
 #include <utl/algorithm.hpp>
 #include <utl/allocator.hpp>
+#include <utl/compressed_pair.hpp>
 #include <utl/config.hpp>
+#include <utl/execution.hpp>
+#include <utl/growth_policy.hpp>
 #include <utl/iterator.hpp>
+#include <utl/type_traits.hpp>
 
+#include <algorithm>
 #include <cassert>
+#include <cstdint>
 #include <cstring>
 #include <iterator>
+#include <limits>
 #include <memory>
+#include <stdexcept>
 
 namespace utl {
 
@@ -20,7 +28,7 @@ class vector_iterator
 public:
   constexpr vector_iterator() noexcept = default;
 
-  explicit vector_iterator(Tp *data) noexcept : m_data(data) {}
+  constexpr explicit vector_iterator(Tp *data) noexcept : m_data(data) {}
 
   constexpr operator vector_const_iterator<Tp>() const noexcept;
 
@@ -34,7 +42,7 @@ class vector_const_iterator
 public:
   constexpr vector_const_iterator() noexcept = default;
 
-  explicit vector_const_iterator(const Tp *data) noexcept
+  constexpr explicit vector_const_iterator(const Tp *data) noexcept
       : m_data(const_cast<Tp *>(data)) {}
 
   constexpr explicit vector_const_iterator(vector_iterator<Tp> it) noexcept
@@ -49,18 +57,33 @@ constexpr vector_iterator<Tp>::operator vector_const_iterator<Tp>() const
   return vector_const_iterator<Tp>{*this};
 }
 
-template <typename Tp, typename Allocator = allocator<Tp>> class vector {
+template <typename Tp, size_t N, typename Allocator> class small_vector;
+
+/// Dynamic array. `GrowthPolicy` picks the capacity to reallocate to when an
+/// insertion or reserve needs more room (see growth_policy.hpp).
+///
+/// `SizeType` is the type size and capacity are stored as. A narrower one
+/// limits max_size() to what it can hold, and growing past that throws
+/// std::length_error; compact_vector stores them as 32 bits.
+template <typename Tp, typename Allocator = allocator<Tp>,
+          typename GrowthPolicy = doubling_growth, typename SizeType = size_t>
+class vector {
+  static_assert(std::is_unsigned_v<SizeType> &&
+                    sizeof(SizeType) <= sizeof(size_t),
+                "vector size type must be an unsigned integer up to size_t");
+
 public:
   // types:
   using value_type = Tp;
   using allocator_type = Allocator;
+  using growth_policy = GrowthPolicy;
   using alloc_traits = allocator_traits<allocator_type>;
   using pointer = typename alloc_traits::pointer;
   using const_pointer = typename alloc_traits::const_pointer;
   using reference = value_type &;
   using rvalue_reference = value_type &&;
   using const_reference = const value_type &;
-  using size_type = size_t;                                 // see 26.2
+  using size_type = SizeType;                               // see 26.2
   using difference_type = std::ptrdiff_t;                   // see 26.2
   using iterator = vector_iterator<value_type>;             // see 26.2
   using const_iterator = vector_const_iterator<value_type>; // see 26.2
@@ -68,6 +91,16 @@ public:
   using const_reverse_iterator = std::reverse_iterator<const_iterator>;
 
 private:
+  static constexpr bool relocatable = is_trivially_relocatable_v<value_type>;
+
+  /// Moves `count` elements from `src` to the possibly overlapping `dst`
+  /// bitwise; the source objects are left without having been destroyed.
+  static void relocate(pointer dst, pointer src, size_type count) noexcept {
+    if (count)
+      std::memmove(static_cast<void *>(dst), static_cast<const void *>(src),
+                   count * sizeof(value_type));
+  }
+
   static void destroy(pointer data, size_type count,
                       allocator_type &allocator) noexcept {
     if (!std::is_trivially_destructible_v<value_type> &&
@@ -80,15 +113,17 @@ private:
   static void destroy_and_dealloc(pointer data, size_type count, size_type cap,
                                   allocator_type &allocator) noexcept {
     destroy(data, count, allocator);
-    alloc_traits::deallocate(allocator, data, cap);
+    if (data)
+      alloc_traits::deallocate(allocator, data, cap);
   }
 
   static void construct(pointer data, size_type count, std::tuple<>,
                         allocator_type &allocator) {
-    if constexpr (std::is_trivially_default_constructible_v<value_type>)
-      return;
-    if constexpr (std::is_fundamental_v<value_type>) {
-      std::memset(data, 0, count * sizeof(value_type));
+    // Value-initialization zeroes trivial types.
+    if constexpr (std::is_trivial_v<value_type> &&
+                  !std::is_member_pointer_v<value_type>) {
+      if (count)
+        std::memset(static_cast<void *>(data), 0, count * sizeof(value_type));
       return;
     }
     size_type i = 0;
@@ -104,6 +139,25 @@ private:
     }
   }
 
+  /// Default-initializes `count` elements; trivial types are left
+  /// indeterminate.
+  static void default_construct(pointer data, size_type count,
+                                allocator_type &allocator) {
+    if constexpr (!std::is_trivially_default_constructible_v<value_type>) {
+      size_type i = 0;
+      UTL_TRY {
+        while (i < count) {
+          ::new (static_cast<void *>(data + i)) value_type;
+          ++i;
+        }
+      }
+      UTL_CATCH(...) {
+        destroy(data, i, allocator);
+        UTL_RETHROW;
+      }
+    }
+  }
+
   template <typename Arg>
   static auto construct(pointer data, size_type count, Arg &&arg,
                         allocator_type &allocator)
@@ -154,11 +208,45 @@ private:
     std::memmove(data, it.data(), count * sizeof(value_type));
   }
 
+  /// Like construct, but split into page-aligned chunks that run on the
+  /// parallel pool, so each thread also first-touches the pages it fills.
+  /// The allocator's construct is called from several threads.
   template <typename Arg>
-  static pointer alloc_and_construct(size_type count, size_type cap, Arg &&arg,
-                                     allocator_type &allocator,
-                                     pointer hint = nullptr) {
-    pointer const data = alloc_traits::allocate(allocator, cap, hint);
+  static void parallel_construct(pointer data, size_type count,
+                                 const Arg &arg, allocator_type &allocator) {
+    detail::parallel_chunks(
+        count, sizeof(value_type),
+        [&](size_type first, size_type last) {
+          construct(data + first, last - first, arg, allocator);
+        },
+        [&](size_type first, size_type last) {
+          destroy(data + first, last - first, allocator);
+        });
+  }
+
+  /// Allocates room for at least `cap` elements and updates `cap` to the
+  /// capacity the allocator really provided, unless `exact` is set.
+  static pointer allocate(size_type &cap, allocator_type &allocator,
+                          bool exact = false) {
+    if (exact)
+      return alloc_traits::allocate(allocator, cap);
+    const auto result = utl::allocate_at_least(allocator, cap);
+    cap = clamp_capacity(result.count);
+    return result.ptr;
+  }
+
+  /// Capacity to record for `count` elements provided by the allocator:
+  /// any excess a narrow size_type cannot hold goes unused.
+  static size_type clamp_capacity(size_t count) noexcept {
+    return static_cast<size_type>(
+        utl::min(count, size_t(std::numeric_limits<size_type>::max())));
+  }
+
+  template <typename Arg>
+  static pointer alloc_and_construct(size_type count, size_type &cap,
+                                     Arg &&arg, allocator_type &allocator,
+                                     bool exact = false) {
+    pointer const data = allocate(cap, allocator, exact);
     UTL_TRY {
       construct(data, count, arg, allocator);
       return data;
@@ -170,11 +258,18 @@ private:
   }
 
   template <typename Arg>
-  static pointer alloc_and_construct(size_type count, Arg &&arg,
-                                     allocator_type &allocator,
-                                     pointer hint = nullptr) {
-    return alloc_and_construct(count, count, std::forward<Arg>(arg), allocator,
-                               hint);
+  static pointer alloc_and_parallel_construct(size_type count, size_type &cap,
+                                              const Arg &arg,
+                                              allocator_type &allocator) {
+    pointer const data = allocate(cap, allocator);
+    UTL_TRY {
+      parallel_construct(data, count, arg, allocator);
+      return data;
+    }
+    UTL_CATCH(...) {
+      alloc_traits::deallocate(allocator, data, cap);
+      UTL_RETHROW;
+    }
   }
 
   template <typename... Args>
@@ -183,20 +278,41 @@ private:
   }
 
   static void realloc(pointer &data, size_type count, size_type &cap,
-                      size_type new_cap, allocator_type &allocator) {
+                      size_type new_cap, allocator_type &allocator,
+                      bool exact = false) {
     assert((!data && !count) || (data && cap));
 
-    if constexpr (std::is_trivially_copyable_v<value_type>) {
-      const auto new_data = alloc_traits::allocate(allocator, new_cap);
-      if (data)
-        std::memcpy(new_data, data, count * sizeof(value_type));
-      alloc_traits::deallocate(allocator, data, cap);
+    if (data && new_cap > cap) {
+      if (const auto expanded =
+              utl::try_expand(allocator, data, cap, new_cap)) {
+        cap = clamp_capacity(expanded);
+        return;
+      }
+    }
+
+    if constexpr (relocatable) {
+      if (data && new_cap > cap) {
+        const auto result =
+            utl::try_reallocate(allocator, data, cap, new_cap);
+        if (result.ptr) {
+          data = result.ptr;
+          cap = clamp_capacity(result.count);
+          return;
+        }
+      }
+
+      const auto new_data = allocate(new_cap, allocator, exact);
+      if (data) {
+        relocate(new_data, data, count);
+        alloc_traits::deallocate(allocator, data, cap);
+      }
       data = new_data;
       cap = new_cap;
     } else {
-      pointer const new_data = alloc_and_construct(
-          count, new_cap, make_move_if_noexcept_iterator(data), allocator,
-          data);
+      pointer const new_data =
+          alloc_and_construct(count, new_cap,
+                              make_move_if_noexcept_iterator(data), allocator,
+                              exact);
       destroy_and_dealloc(data, count, cap, allocator);
       data = new_data;
       cap = new_cap;
@@ -208,69 +324,86 @@ public:
   vector() noexcept(noexcept(Allocator())) : vector(Allocator()) {}
 
   explicit vector(const allocator_type &allocator) noexcept
-      : m_alloc(allocator), m_data(nullptr), m_cap(0), m_size(0) {}
+      : m_data(nullptr), m_alloc_cap(allocator, 0), m_size(0) {}
 
   explicit vector(size_type num,
                   const allocator_type &allocator = allocator_type())
-      : m_alloc(allocator),
-        m_data(alloc_and_construct(num, forward_args(), m_alloc)), m_cap(num),
-        m_size(num) {}
+      : m_alloc_cap(allocator, num), m_size(num) {
+    m_data = alloc_and_construct(num, cap(), forward_args(), alloc());
+  }
 
   vector(size_type num, const_reference val,
          const allocator_type &allocator = allocator_type())
-      : m_alloc(allocator),
-        m_data(alloc_and_construct(num, forward_args(val), m_alloc)),
-        m_cap(num), m_size(num) {}
+      : m_alloc_cap(allocator, num), m_size(num) {
+    m_data = alloc_and_construct(num, cap(), forward_args(val), alloc());
+  }
+
+  /// Constructs `num` value-initialized elements on all cores. Large
+  /// vectors get their pages first touched by the threads that fill them,
+  /// which spreads them across NUMA nodes.
+  vector(size_type num, parallel_policy,
+         const allocator_type &allocator = allocator_type())
+      : m_alloc_cap(allocator, num), m_size(num) {
+    m_data = alloc_and_parallel_construct(num, cap(), std::tuple<>(), alloc());
+  }
+
+  vector(size_type num, const_reference val, parallel_policy,
+         const allocator_type &allocator = allocator_type())
+      : m_alloc_cap(allocator, num), m_size(num) {
+    m_data = alloc_and_parallel_construct(num, cap(), forward_args(val),
+                                          alloc());
+  }
 
   template <typename InputIterator>
   vector(InputIterator first, InputIterator last,
          const allocator_type &allocator = allocator_type())
-      : m_alloc(allocator) {
+      : m_alloc_cap(allocator, 0) {
     if constexpr (std::is_same_v<typename iterator_traits<
                                      InputIterator>::iterator_category,
                                  std::input_iterator_tag>) {
-      m_cap = 0;
+      cap() = 0;
       m_size = 0;
       m_data = nullptr;
       UTL_TRY {
         while (first != last)
           emplace_back(*first++);
       }
-      UTL_CATCH(...) { destroy_and_dealloc(m_data, m_size, m_cap, m_alloc); }
+      UTL_CATCH(...) { destroy_and_dealloc(m_data, m_size, cap(), alloc()); }
     } else {
       const size_type num = std::distance(first, last);
       assert(num >= 0);
-      m_data = alloc_and_construct(num, first, m_alloc);
-      m_cap = num;
+      cap() = num;
+      m_data = alloc_and_construct(num, cap(), first, alloc());
       m_size = num;
     }
   }
 
   vector(const vector &other)
       : vector(other, alloc_traits::select_on_container_copy_construction(
-                          other.m_alloc)) {}
+                          other.alloc())) {}
 
   vector(vector &&other) noexcept
       : vector(std::move(other), other.get_allocator()) {}
 
   vector(const vector &other, const allocator_type &allocator)
-      : m_alloc(allocator),
-        m_data(alloc_and_construct(other.m_size, other.m_data, m_alloc)),
-        m_cap(other.m_size), m_size(other.m_size) {}
+      : m_alloc_cap(allocator, other.m_size), m_size(other.m_size) {
+    m_data = alloc_and_construct(m_size, cap(), other.m_data, alloc());
+  }
 
-  vector(vector &&other, const allocator_type &allocator) : m_alloc(allocator) {
+  vector(vector &&other, const allocator_type &allocator)
+      : m_alloc_cap(allocator, 0) {
     if (alloc_traits::is_always_equal::value ||
-        m_alloc == other.get_allocator()) {
+        alloc() == other.get_allocator()) {
       m_data = other.m_data;
-      m_cap = other.m_cap;
+      cap() = other.cap();
       m_size = other.m_size;
     } else {
-      m_data = alloc_and_construct(other.m_size, other.m_data, m_alloc);
       m_size = other.m_size;
-      m_cap = m_size;
+      cap() = m_size;
+      m_data = alloc_and_construct(m_size, cap(), other.m_data, alloc());
     }
     other.m_data = nullptr;
-    other.m_cap = 0;
+    other.cap() = 0;
     other.m_size = 0;
   }
 
@@ -278,29 +411,28 @@ public:
          const allocator_type &allocator = Allocator())
       : vector(il.begin(), il.end(), allocator) {}
 
-  ~vector() { destroy_and_dealloc(m_data, m_size, m_cap, m_alloc); }
+  ~vector() { destroy_and_dealloc(m_data, m_size, cap(), alloc()); }
 
   vector &operator=(const vector &other) {
     constexpr bool copy_allocator =
         alloc_traits::propagate_on_container_copy_assignment::value;
     const bool reallocate =
-        m_cap < other.m_size ||
-        (copy_allocator && m_alloc != other.get_allocator());
+        cap() < other.m_size ||
+        (copy_allocator && alloc() != other.get_allocator());
 
     if (reallocate) {
-      destroy_and_dealloc(m_data, m_size, m_cap, m_alloc);
-      m_cap = 0;
+      destroy_and_dealloc(m_data, m_size, cap(), alloc());
+      cap() = 0;
       m_size = 0;
     }
 
     if constexpr (copy_allocator)
-      m_alloc = other.get_allocator();
+      alloc() = other.get_allocator();
 
     if (reallocate) {
-      m_data = alloc_traits::allocate(m_alloc, other.m_size, other.m_data);
-
-      m_cap = other.m_size;
-      m_size = 0;
+      size_type new_cap = other.m_size;
+      m_data = allocate(new_cap, alloc());
+      cap() = new_cap;
     }
 
     const size_type common = utl::min(m_size, other.m_size);
@@ -311,14 +443,14 @@ public:
 
     // Erasable
     if (m_size > common) {
-      destroy(m_data + common, m_size - common, m_alloc);
+      destroy(m_data + common, m_size - common, alloc());
       m_size = common;
     }
 
     // CopyInsertible
     if (m_size < other.m_size) {
       construct(m_data + m_size, other.m_size - m_size, other.m_data + m_size,
-                m_alloc);
+                alloc());
       m_size = other.m_size;
     }
 
@@ -331,31 +463,32 @@ public:
     constexpr bool move_allocator =
         alloc_traits::propagate_on_container_move_assignment::value;
     const bool can_take_ownership =
-        move_allocator || m_alloc == other.get_allocator();
-    const bool deallocate = can_take_ownership || m_cap < other.m_size;
+        move_allocator || alloc() == other.get_allocator();
+    const bool deallocate = can_take_ownership || cap() < other.m_size;
 
     if (deallocate) {
-      destroy_and_dealloc(m_data, m_size, m_cap, m_alloc);
+      destroy_and_dealloc(m_data, m_size, cap(), alloc());
       m_data = nullptr;
-      m_cap = 0;
+      cap() = 0;
       m_size = 0;
     }
 
     if constexpr (move_allocator) {
-      m_alloc = std::move(other.m_alloc);
+      alloc() = std::move(other.alloc());
     }
 
     if (can_take_ownership) {
       using std::swap;
       swap(m_data, other.m_data);
-      swap(m_cap, other.m_cap);
+      swap(cap(), other.cap());
       swap(m_size, other.m_size);
       return *this;
     }
 
-    if (m_cap < other.m_size) {
-      m_data = alloc_traits::allocate(m_alloc, other.m_size, other.m_data);
-      m_cap = other.m_size;
+    if (cap() < other.m_size) {
+      size_type new_cap = other.m_size;
+      m_data = allocate(new_cap, alloc());
+      cap() = new_cap;
     }
 
     const size_type common = utl::min(m_size, other.m_size);
@@ -366,14 +499,14 @@ public:
 
     // Erasable
     if (m_size > common) {
-      destroy(m_data + common, m_size - common, m_alloc);
+      destroy(m_data + common, m_size - common, alloc());
       m_size = common;
     }
 
     // MoveInsertible
     if (m_size < other.m_size) {
       construct(m_data + m_size, other.m_size - m_size,
-                make_move_if_noexcept_iterator(other.m_data + m_size), m_alloc);
+                make_move_if_noexcept_iterator(other.m_data + m_size), alloc());
       m_size = other.m_size;
     }
 
@@ -403,11 +536,15 @@ public:
     } else {
       const size_type count = std::distance(first, last);
 
-      if (m_cap < count) {
-        destroy_and_dealloc(m_data, m_size, m_cap, m_alloc);
-        m_data = alloc_traits::allocate(m_alloc, count);
-        m_cap = count;
+      if (cap() < count) {
+        destroy_and_dealloc(m_data, m_size, cap(), alloc());
+        m_data = nullptr;
+        cap() = 0;
         m_size = 0;
+
+        size_type new_cap = count;
+        m_data = allocate(new_cap, alloc());
+        cap() = new_cap;
       }
 
       const size_type common = utl::min(m_size, count);
@@ -418,24 +555,28 @@ public:
 
       // Erasable
       if (m_size > common) {
-        destroy(m_data + common, m_size - common, m_alloc);
+        destroy(m_data + common, m_size - common, alloc());
         m_size = common;
       }
 
       // CopyInsertible
       if (m_size < count) {
-        construct(m_data + m_size, count - m_size, first + m_size, m_alloc);
+        construct(m_data + m_size, count - m_size, first + m_size, alloc());
         m_size = count;
       }
     }
   }
 
   void assign(size_type num, const_reference val) {
-    if (m_cap < num) {
-      destroy_and_dealloc(m_data, m_size, m_cap, m_alloc);
-      m_data = alloc_traits::allocate(m_alloc, num, m_data);
-      m_cap = num;
+    if (cap() < num) {
+      destroy_and_dealloc(m_data, m_size, cap(), alloc());
+      m_data = nullptr;
+      cap() = 0;
       m_size = 0;
+
+      size_type new_cap = num;
+      m_data = allocate(new_cap, alloc());
+      cap() = new_cap;
     }
 
     const size_type common = utl::min(m_size, num);
@@ -446,20 +587,20 @@ public:
 
     // Erasable
     if (m_size > common) {
-      destroy(m_data + common, m_size - common, m_alloc);
+      destroy(m_data + common, m_size - common, alloc());
       m_size = common;
     }
 
     // CopyInsertible
     if (m_size < num) {
-      construct(m_data + m_size, num - m_size, forward_args(val), m_alloc);
+      construct(m_data + m_size, num - m_size, forward_args(val), alloc());
       m_size = num;
     }
   }
 
   void assign(initializer_list<value_type> il) { assign(il.begin(), il.end()); }
 
-  allocator_type get_allocator() const noexcept { return m_alloc; }
+  allocator_type get_allocator() const noexcept { return alloc(); }
 
   // iterators:
   iterator begin() noexcept { return iterator{m_data}; }
@@ -489,10 +630,12 @@ public:
   bool empty() const noexcept { return m_size == 0; }
   size_type size() const noexcept { return m_size; }
   size_type max_size() const noexcept {
-    return alloc_traits::max_size(m_alloc);
+    return static_cast<size_type>(
+        utl::min(size_t(alloc_traits::max_size(alloc())),
+                 size_t(std::numeric_limits<size_type>::max())));
   }
 
-  size_type capacity() const noexcept { return m_cap; }
+  size_type capacity() const noexcept { return cap(); }
 
   void resize(size_type size) { resize_impl(size, std::tuple<>()); }
 
@@ -500,26 +643,71 @@ public:
     resize_impl(size, forward_args(val));
   }
 
+  /// resize with the new elements constructed on all cores.
+  void resize(size_type size, parallel_policy) {
+    resize_impl(size, std::tuple<>(), par);
+  }
+
+  void resize(size_type size, const_reference val, parallel_policy) {
+    resize_impl(size, forward_args(val), par);
+  }
+
+  template <typename Arg>
+  void resize_impl(size_type size, const Arg &arg, parallel_policy) {
+    reserve(size);
+    if (m_size < size)
+      parallel_construct(m_data + m_size, size - m_size, arg, alloc());
+    if (m_size > size)
+      destroy(m_data + size, m_size - size, alloc());
+    m_size = size;
+  }
+
   template <typename Arg> void resize_impl(size_type size, Arg &&arg) {
     reserve(size);
     if (m_size < size)
       construct(m_data + m_size, size - m_size, std::forward<Arg>(arg),
-                m_alloc);
+                alloc());
     if (m_size > size)
-      destroy(m_data + size, m_size - size, m_alloc);
+      destroy(m_data + size, m_size - size, alloc());
     m_size = size;
   }
 
+  /// Like resize(size), but new elements are default-initialized, so
+  /// trivial types are not zeroed first.
+  void resize_uninitialized(size_type size) {
+    reserve(size);
+    if (m_size < size)
+      default_construct(m_data + m_size, size - m_size, alloc());
+    if (m_size > size)
+      destroy(m_data + size, m_size - size, alloc());
+    m_size = size;
+  }
+
+  /// Resizes to `size` default-initialized elements, calls
+  /// `op(data(), size)` to fill them and keeps the number of leading
+  /// elements it returns, which must not exceed `size`.
+  ///
+  /// If `op` throws, the vector keeps all `size` elements.
+  template <typename Operation>
+  void resize_and_overwrite(size_type size, Operation op) {
+    resize_uninitialized(size);
+    const size_type keep = std::move(op)(m_data, size);
+    assert(keep <= size);
+    destroy(m_data + keep, size - keep, alloc());
+    m_size = keep;
+  }
+
   void reserve(size_type num) {
-    if (num > m_cap) {
-      auto new_cap = utl::max(m_cap * 2, num);
-      realloc(m_data, m_size, m_cap, new_cap, m_alloc);
+    if (num > cap()) {
+      if (num > max_size())
+        UTL_THROW(std::length_error("vector::reserve"));
+      realloc(m_data, m_size, cap(), next_capacity(num), alloc());
     }
   }
 
   void shrink_to_fit() {
-    if (m_cap != m_size) {
-      realloc(m_data, m_size, m_cap, m_size, m_alloc);
+    if (cap() != m_size) {
+      realloc(m_data, m_size, cap(), m_size, alloc(), true);
     }
   }
 
@@ -547,28 +735,28 @@ public:
 
   // 26.3.11.5, modifiers
   template <typename... Args> reference emplace_back(Args &&... args) {
-    reserve(m_size + 1);
-    alloc_traits::construct(m_alloc, &m_data[m_size],
+    reserve(grown_size(1));
+    alloc_traits::construct(alloc(), &m_data[m_size],
                             std::forward<Args>(args)...);
     ++m_size;
     return back();
   }
 
   void push_back(const_reference elem) {
-    reserve(m_size + 1);
-    alloc_traits::construct(m_alloc, &m_data[m_size], elem);
+    reserve(grown_size(1));
+    alloc_traits::construct(alloc(), &m_data[m_size], elem);
     ++m_size;
   }
 
   void push_back(rvalue_reference elem) {
-    reserve(m_size + 1);
-    alloc_traits::construct(m_alloc, &m_data[m_size], std::move(elem));
+    reserve(grown_size(1));
+    alloc_traits::construct(alloc(), &m_data[m_size], std::move(elem));
     ++m_size;
   }
 
   void pop_back() // noexcept
   {
-    alloc_traits::destroy(m_alloc, &m_data[--m_size]);
+    alloc_traits::destroy(alloc(), &m_data[--m_size]);
   }
 
   template <typename... Args>
@@ -580,53 +768,62 @@ public:
 
   template <typename Arg>
   pointer insert_impl(size_type idx, size_type count, Arg &&arg) {
-    if (m_size + count > m_cap) {
-      const auto new_cap = utl::max(m_size + count, m_size * 2);
+    const size_type new_size = grown_size(count);
+    if (m_data && new_size > cap()) {
+      if (const auto expanded = utl::try_expand(alloc(), m_data, cap(),
+                                                next_capacity(new_size)))
+        cap() = clamp_capacity(expanded);
+    }
+
+    if constexpr (relocatable)
+      return relocating_insert(idx, count, std::forward<Arg>(arg));
+
+    if (new_size > cap()) {
+      size_type new_cap = next_capacity(new_size);
       const pointer new_data = alloc_and_construct(
-          idx, new_cap, make_move_if_noexcept_iterator(m_data), m_alloc,
-          m_data);
+          idx, new_cap, make_move_if_noexcept_iterator(m_data), alloc());
 
       UTL_TRY {
-        construct(new_data + idx, count, std::forward<Arg>(arg), m_alloc);
+        construct(new_data + idx, count, std::forward<Arg>(arg), alloc());
       }
       UTL_CATCH(...) {
-        destroy_and_dealloc(new_data, idx, new_cap, m_alloc);
+        destroy_and_dealloc(new_data, idx, new_cap, alloc());
         UTL_RETHROW;
       }
 
       UTL_TRY {
         construct(new_data + idx + count, m_size - idx,
-                  make_move_if_noexcept_iterator(m_data + idx), m_alloc);
+                  make_move_if_noexcept_iterator(m_data + idx), alloc());
       }
       UTL_CATCH(...) {
-        destroy_and_dealloc(new_data, idx + count, new_cap, m_alloc);
+        destroy_and_dealloc(new_data, idx + count, new_cap, alloc());
         UTL_RETHROW;
       }
 
-      destroy_and_dealloc(m_data, m_size, m_cap, m_alloc);
+      destroy_and_dealloc(m_data, m_size, cap(), alloc());
 
       m_data = new_data;
-      m_cap = new_cap;
+      cap() = new_cap;
       m_size = m_size + count;
       return m_data + idx;
     } else {
       const size_type num = utl::min(m_size - idx, count);
       const auto size = m_size;
       construct(m_data + size + count - num, num,
-                make_move_if_noexcept_iterator(m_data + size - num), m_alloc);
+                make_move_if_noexcept_iterator(m_data + size - num), alloc());
       m_size += count;
       utl::copy_backward(make_move_if_noexcept_iterator(m_data + idx),
                          make_move_if_noexcept_iterator(m_data + size - num),
                          m_data + size + count - num);
-      destroy(m_data + idx, num, m_alloc); // destruction might be unneeded
+      destroy(m_data + idx, num, alloc()); // destruction might be unneeded
       UTL_TRY {
-        construct(m_data + idx, count, std::forward<Arg>(arg), m_alloc);
+        construct(m_data + idx, count, std::forward<Arg>(arg), alloc());
       }
       UTL_CATCH(...) {
         utl::copy(make_move_if_noexcept_iterator(m_data + size - num),
                   make_move_if_noexcept_iterator(m_data + idx),
                   m_data + size + count - num);
-        destroy(m_data + size + count - num, num, m_alloc);
+        destroy(m_data + size + count - num, num, alloc());
         m_size -= count;
         UTL_RETHROW;
       }
@@ -634,6 +831,41 @@ public:
     }
   }
 
+  /// insert_impl for trivially relocatable types: the new elements are
+  /// built first and the existing ones are then moved with memmove.
+  template <typename Arg>
+  pointer relocating_insert(size_type idx, size_type count, Arg &&arg) {
+    if (m_size + count > cap()) {
+      size_type new_cap = next_capacity(m_size + count);
+      const pointer new_data = allocate(new_cap, alloc());
+      UTL_TRY {
+        construct(new_data + idx, count, std::forward<Arg>(arg), alloc());
+      }
+      UTL_CATCH(...) {
+        alloc_traits::deallocate(alloc(), new_data, new_cap);
+        UTL_RETHROW;
+      }
+      if (m_data) {
+        relocate(new_data, m_data, idx);
+        relocate(new_data + idx + count, m_data + idx, m_size - idx);
+        alloc_traits::deallocate(alloc(), m_data, cap());
+      }
+      m_data = new_data;
+      cap() = new_cap;
+    } else {
+      relocate(m_data + idx + count, m_data + idx, m_size - idx);
+      UTL_TRY {
+        construct(m_data + idx, count, std::forward<Arg>(arg), alloc());
+      }
+      UTL_CATCH(...) {
+        relocate(m_data + idx, m_data + idx + count, m_size - idx);
+        UTL_RETHROW;
+      }
+    }
+    m_size += count;
+    return m_data + idx;
+  }
+
   iterator insert(const_iterator position, const_reference elem) {
     auto *ptr = insert_impl(position - begin(), 1, forward_args(elem));
     return iterator{ptr};
@@ -657,11 +889,20 @@ public:
     if constexpr (std::is_same_v<std::input_iterator_tag,
                                  typename iterator_traits<
                                      InputIterator>::iterator_category>) {
-      auto idx = position - begin();
-      const auto idx_origin = idx;
-      while (first != last)
-        insert_impl(idx++, 1, forward_args(*first++));
-      return iterator{m_data + idx_origin};
+      // Append, then move the new elements into place with one rotation.
+      const size_type idx = position - cbegin();
+      const size_type size = m_size;
+      UTL_TRY {
+        while (first != last)
+          emplace_back(*first++);
+        rotate_tail(idx, size);
+      }
+      UTL_CATCH(...) {
+        destroy(m_data + size, m_size - size, alloc());
+        m_size = size;
+        UTL_RETHROW;
+      }
+      return iterator{m_data + idx};
     } else {
       const size_type num = std::distance(first, last);
       auto *const ptr = insert_impl(position - begin(), num, first);
@@ -669,20 +910,91 @@ public:
     }
   }
 
+  /// Inserts the elements of `range` before `position`. Sized ranges of
+  /// input iterators reserve room once up front.
+  template <typename Range>
+  iterator insert_range(const_iterator position, Range &&range) {
+    using std::begin;
+    using std::end;
+    using It = decltype(begin(range));
+    if constexpr (std::is_same_v<typename iterator_traits<It>::iterator_category,
+                                 std::input_iterator_tag> &&
+                  is_sized<Range>::value) {
+      const size_type idx = position - cbegin();
+      reserve(grown_size(std::size(range)));
+      return insert(cbegin() + idx, begin(range), end(range));
+    } else {
+      return insert(position, begin(range), end(range));
+    }
+  }
+
+  template <typename Range> void append_range(Range &&range) {
+    insert_range(cend(), std::forward<Range>(range));
+  }
+
   iterator insert(const_iterator position, initializer_list<value_type> il) {
     auto *const ptr = insert_impl(position - begin(), il.size(), il.begin());
     return iterator{ptr};
   }
 
+private:
+  template <typename Range, typename = void>
+  struct is_sized : std::false_type {};
+
+  template <typename Range>
+  struct is_sized<Range,
+                  std::void_t<decltype(std::size(std::declval<Range &>()))>>
+      : std::true_type {};
+
+  /// Capacity to grow to so that `required` elements fit.
+  size_type next_capacity(size_type required) const noexcept {
+    return static_cast<size_type>(utl::min(
+        GrowthPolicy::grow(cap(), required, sizeof(value_type)),
+        size_t(max_size())));
+  }
+
+  /// Size after adding `count` elements; throws std::length_error if that
+  /// exceeds max_size().
+  size_type grown_size(size_t count) const {
+    if (count > size_t(max_size() - m_size))
+      UTL_THROW(std::length_error("vector"));
+    return static_cast<size_type>(m_size + count);
+  }
+
+  /// Moves the elements appended after `size` to position `idx`.
+  void rotate_tail(size_type idx, size_type size) {
+    const size_type count = m_size - size;
+    if (idx == size || count == 0)
+      return;
+
+    if constexpr (relocatable) {
+      // Park the new elements, slide the old tail up and drop them in.
+      size_type tmp_cap = count;
+      const pointer tmp = allocate(tmp_cap, alloc(), true);
+      relocate(tmp, m_data + size, count);
+      relocate(m_data + idx + count, m_data + idx, size - idx);
+      relocate(m_data + idx, tmp, count);
+      alloc_traits::deallocate(alloc(), tmp, tmp_cap);
+    } else {
+      std::rotate(m_data + idx, m_data + size, m_data + m_size);
+    }
+  }
+
+public:
   iterator erase(const_iterator position) {
     return erase(position, position + 1);
   }
 
   iterator erase(const_iterator first, const_iterator last) {
     const size_type num = last - first;
-    utl::copy(make_move_if_noexcept_iterator(last.data()),
-              make_move_if_noexcept_iterator(cend().data()), first.data());
-    destroy(m_data + m_size - num, num, m_alloc);
+    if constexpr (relocatable) {
+      destroy(first.data(), num, alloc());
+      relocate(first.data(), last.data(), cend().data() - last.data());
+    } else {
+      utl::copy(make_move_if_noexcept_iterator(last.data()),
+                make_move_if_noexcept_iterator(cend().data()), first.data());
+      destroy(m_data + m_size - num, num, alloc());
+    }
     m_size -= num;
     return iterator(first.data());
   }
@@ -693,39 +1005,65 @@ public:
     using std::swap;
     if constexpr (alloc_traits::propagate_on_container_swap::value ||
                   alloc_traits::is_always_equal::value) {
-      swap(m_alloc, other.m_alloc);
+      swap(alloc(), other.alloc());
       swap(m_data, other.m_data);
       swap(m_size, other.m_size);
-      swap(m_cap, other.m_cap);
-    } else if (m_alloc == other.get_allocator()) {
+      swap(cap(), other.cap());
+    } else if (alloc() == other.get_allocator()) {
       swap(m_data, other.m_data);
       swap(m_size, other.m_size);
-      swap(m_cap, other.m_cap);
+      swap(cap(), other.cap());
     } else if (m_size != other.m_size) {
       auto [t_more, t_less] = other.m_size > m_size ? std::tie(other, *this)
                                                     : std::tie(*this, other);
+      size_type new_cap = t_more.m_size;
+      if constexpr (relocatable) {
+        // Each side keeps its own allocator; only the elements change
+        // buffers, so nothing can throw once the new one is allocated.
+        const pointer new_data = allocate(new_cap, t_less.alloc());
+        relocate(new_data, t_more.m_data, t_more.m_size);
+        relocate(t_more.m_data, t_less.m_data, t_less.m_size);
+        if (t_less.m_data)
+          alloc_traits::deallocate(t_less.alloc(), t_less.m_data, t_less.cap());
+        t_less.m_data = new_data;
+        t_less.cap() = new_cap;
+        swap(t_less.m_size, t_more.m_size);
+        return;
+      }
       auto *const new_data = alloc_and_construct(
-          t_more.m_size, move_if_noexcept_iterator(t_more.m_data),
-          t_less.m_alloc, t_more.m_data);
+          t_more.m_size, new_cap, move_if_noexcept_iterator(t_more.m_data),
+          t_less.alloc());
 
       UTL_TRY {
         for (size_type i = 0; i != t_less.m_size; ++i)
           t_more.m_data[i] = std::move_if_noexcept(t_less.m_data[i]);
       }
       UTL_CATCH(...) {
-        destroy_and_dealloc(new_data, t_more.m_size, t_more.m_size,
-                            t_less.m_alloc);
+        destroy_and_dealloc(new_data, t_more.m_size, new_cap, t_less.alloc());
         UTL_RETHROW;
       }
 
-      destroy_and_dealloc(t_less.m_data, t_less.m_size, t_less.m_cap,
-                          t_less.m_alloc);
+      destroy_and_dealloc(t_less.m_data, t_less.m_size, t_less.cap(),
+                          t_less.alloc());
 
       t_less.m_data = new_data;
+      t_less.cap() = new_cap;
       destroy(t_more.m_data + t_less.m_size, t_more.m_size - t_less.m_size,
-              t_more.m_alloc);
+              t_more.alloc());
       swap(t_less.m_size, t_more.m_size);
-      swap(t_less.m_cap, t_more.m_cap);
+    } else if constexpr (relocatable) {
+      // Exchange the bytes through a small buffer rather than calling swap
+      // on every element.
+      unsigned char tmp[256];
+      const auto a = reinterpret_cast<unsigned char *>(m_data);
+      const auto b = reinterpret_cast<unsigned char *>(other.m_data);
+      const size_t bytes = m_size * sizeof(value_type);
+      for (size_t i = 0; i < bytes; i += sizeof(tmp)) {
+        const size_t n = utl::min(sizeof(tmp), bytes - i);
+        std::memcpy(tmp, a + i, n);
+        std::memcpy(a + i, b + i, n);
+        std::memcpy(b + i, tmp, n);
+      }
     } else {
       for (size_type i{0}; i != m_size; ++i) {
         swap(m_data[i], other.m_data[i]);
@@ -734,14 +1072,21 @@ public:
   }
 
   void clear() noexcept {
-    destroy(m_data, m_size, m_alloc);
+    destroy(m_data, m_size, alloc());
     m_size = 0;
   }
 
 private:
-  allocator_type m_alloc;
+  template <typename, size_t, typename> friend class small_vector;
+
+  allocator_type &alloc() noexcept { return m_alloc_cap.first(); }
+  const allocator_type &alloc() const noexcept { return m_alloc_cap.first(); }
+  size_type &cap() noexcept { return m_alloc_cap.second(); }
+  size_type cap() const noexcept { return m_alloc_cap.second(); }
+
+  // An empty allocator shares its storage with the capacity.
   pointer m_data;
-  size_type m_cap;
+  compressed_pair<allocator_type, size_type> m_alloc_cap;
   size_type m_size;
 };
 
@@ -751,37 +1096,122 @@ template <typename InputIterator,
 vector(InputIterator, InputIterator, Allocator = Allocator())
     ->vector<typename iterator_traits<InputIterator>::value_type, Allocator>;
 
-template <typename Tp, typename Allocator>
-inline bool operator==(const vector<Tp, Allocator> &x,
-                       const vector<Tp, Allocator> &y) {
-  if (x.size() != y.size())
-    return false;
-  for (auto i = x.begin(), j = y.begin(), end = x.end(); i != end; ++i, ++j)
-    if (*i != *j)
-      return false;
-  return true;
+template <typename Tp, typename Allocator, typename GrowthPolicy,
+          typename SizeType>
+inline bool operator==(const vector<Tp, Allocator, GrowthPolicy, SizeType> &x,
+                       const vector<Tp, Allocator, GrowthPolicy, SizeType> &y) {
+  return x.size() == y.size() &&
+         utl::equal(x.data(), x.data() + x.size(), y.data());
 }
 
-template <typename Tp, typename Allocator>
-bool operator<(const vector<Tp, Allocator> &x, const vector<Tp, Allocator> &y);
+template <typename Tp, typename Allocator, typename GrowthPolicy,
+          typename SizeType>
+inline bool operator<(const vector<Tp, Allocator, GrowthPolicy, SizeType> &x,
+                      const vector<Tp, Allocator, GrowthPolicy, SizeType> &y) {
+  return utl::lexicographical_compare(x.data(), x.data() + x.size(), y.data(),
+                                      y.data() + y.size());
+}
 
-template <typename Tp, typename Allocator>
-bool operator!=(const vector<Tp, Allocator> &x, const vector<Tp, Allocator> &y);
+template <typename Tp, typename Allocator, typename GrowthPolicy,
+          typename SizeType>
+inline bool operator!=(const vector<Tp, Allocator, GrowthPolicy, SizeType> &x,
+                       const vector<Tp, Allocator, GrowthPolicy, SizeType> &y) {
+  return !(x == y);
+}
 
-template <typename Tp, typename Allocator>
-bool operator>(const vector<Tp, Allocator> &x, const vector<Tp, Allocator> &y);
+template <typename Tp, typename Allocator, typename GrowthPolicy,
+          typename SizeType>
+inline bool operator>(const vector<Tp, Allocator, GrowthPolicy, SizeType> &x,
+                      const vector<Tp, Allocator, GrowthPolicy, SizeType> &y) {
+  return y < x;
+}
 
-template <typename Tp, typename Allocator>
-bool operator>=(const vector<Tp, Allocator> &x, const vector<Tp, Allocator> &y);
+template <typename Tp, typename Allocator, typename GrowthPolicy,
+          typename SizeType>
+inline bool operator>=(const vector<Tp, Allocator, GrowthPolicy, SizeType> &x,
+                       const vector<Tp, Allocator, GrowthPolicy, SizeType> &y) {
+  return !(x < y);
+}
 
-template <typename Tp, typename Allocator>
-bool operator<=(const vector<Tp, Allocator> &x, const vector<Tp, Allocator> &y);
+template <typename Tp, typename Allocator, typename GrowthPolicy,
+          typename SizeType>
+inline bool operator<=(const vector<Tp, Allocator, GrowthPolicy, SizeType> &x,
+                       const vector<Tp, Allocator, GrowthPolicy, SizeType> &y) {
+  return !(y < x);
+}
 
 // 26.3.11.6, specialized algorithms
-template <typename Tp, typename Allocator>
-void swap(vector<Tp, Allocator> &x,
-          vector<Tp, Allocator> &y) noexcept(noexcept(x.swap(y))) {
+template <typename Tp, typename Allocator, typename GrowthPolicy,
+          typename SizeType>
+void swap(vector<Tp, Allocator, GrowthPolicy, SizeType> &x,
+          vector<Tp, Allocator, GrowthPolicy, SizeType> &y) noexcept(
+    noexcept(x.swap(y))) {
   x.swap(y);
 }
 
+/// Erases the elements satisfying `pred`, keeping the order of the rest,
+/// and returns how many were erased. `pred` is called once per element,
+/// in order. Vectors of 4- and 8-byte arithmetic types are compacted with
+/// SIMD, other small trivially copyable types without branches.
+template <typename Tp, typename Allocator, typename GrowthPolicy,
+          typename SizeType, typename Predicate>
+typename vector<Tp, Allocator, GrowthPolicy, SizeType>::size_type
+erase_if(vector<Tp, Allocator, GrowthPolicy, SizeType> &vec, Predicate pred) {
+  const auto size = vec.size();
+  const auto kept = detail::remove_if_compact(vec.data(), size, pred);
+  vec.erase(vec.begin() + kept, vec.end());
+  return size - kept;
+}
+
+template <typename Tp, typename Allocator, typename GrowthPolicy,
+          typename SizeType, typename U>
+typename vector<Tp, Allocator, GrowthPolicy, SizeType>::size_type
+erase(vector<Tp, Allocator, GrowthPolicy, SizeType> &vec, const U &value) {
+  // Compare against a copy: `value` may be an element, which compaction
+  // would overwrite or move from.
+  return utl::erase_if(vec, [value](const Tp &x) { return x == value; });
+}
+
+/// Erases the elements satisfying `pred` by moving the last element into
+/// each hole; the order of the rest is not kept. Moves one element per
+/// erased element instead of shifting everything after it.
+template <typename Tp, typename Allocator, typename GrowthPolicy,
+          typename SizeType, typename Predicate>
+typename vector<Tp, Allocator, GrowthPolicy, SizeType>::size_type
+erase_if_unordered(vector<Tp, Allocator, GrowthPolicy, SizeType> &vec,
+                   Predicate pred) {
+  const auto first = vec.data();
+  const auto size = vec.size();
+  auto last = size;
+  for (decltype(last) i = 0; i != last;) {
+    if (pred(first[i])) {
+      if (i != --last)
+        first[i] = std::move(first[last]);
+    } else {
+      ++i;
+    }
+  }
+  vec.erase(vec.begin() + last, vec.end());
+  return size - last;
+}
+
+template <typename Tp, typename Allocator, typename GrowthPolicy,
+          typename SizeType>
+struct is_trivially_relocatable<vector<Tp, Allocator, GrowthPolicy, SizeType>>
+    : is_trivially_relocatable<Allocator> {};
+
+/// A vector that stores its size and capacity as 32 bits, for the many
+/// small vectors kept inside other objects. With an empty allocator it
+/// is 16 bytes instead of 24, and holds up to 2^32 - 1 elements.
+template <typename Tp, typename Allocator = allocator<Tp>,
+          typename GrowthPolicy = doubling_growth>
+using compact_vector = vector<Tp, Allocator, GrowthPolicy, std::uint32_t>;
+
+namespace pmr {
+template <typename T> class polymorphic_allocator;
+
+template <typename Tp>
+using vector = utl::vector<Tp, polymorphic_allocator<Tp>>;
+} // namespace pmr
+
 } // namespace utl
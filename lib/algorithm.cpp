@@ -0,0 +1,202 @@
+#include <utl/algorithm.hpp>
+
+#include <array>
+#include <cassert>
+#include <cstring>
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define UTL_X86_DISPATCH 1
+#include <immintrin.h>
+#else
+#define UTL_X86_DISPATCH 0
+#endif
+
+namespace utl {
+namespace detail {
+
+namespace {
+
+// Copies every element and advances the output only past kept ones, so
+// the loop has no data-dependent branch. The value goes through a local
+// because `dst` may alias `src`.
+template <typename U>
+size_t compress_generic(void *dst, const void *src, const unsigned char *keep,
+                        size_t num) noexcept {
+  auto *out = static_cast<unsigned char *>(dst);
+  const auto *in = static_cast<const unsigned char *>(src);
+  size_t kept = 0;
+  for (size_t i = 0; i != num; ++i) {
+    U value;
+    std::memcpy(&value, in + i * sizeof(U), sizeof(U));
+    std::memcpy(out + kept * sizeof(U), &value, sizeof(U));
+    kept += keep[i] != 0;
+  }
+  return kept;
+}
+
+#if UTL_X86_DISPATCH
+
+// For each mask of kept lanes, the source lane of each output lane, one
+// byte per lane; unused lanes are left zero.
+template <size_t Lanes> constexpr auto make_compress_table() noexcept {
+  std::array<std::uint64_t, size_t(1) << Lanes> table{};
+  for (size_t mask = 0; mask != table.size(); ++mask) {
+    size_t out = 0;
+    for (size_t lane = 0; lane != Lanes; ++lane)
+      if (mask & (size_t(1) << lane))
+        table[mask] |= std::uint64_t(lane) << (8 * out++);
+  }
+  return table;
+}
+
+// 64-bit lanes are permuted as pairs of 32-bit lanes.
+constexpr auto make_compress_table64() noexcept {
+  std::array<std::uint64_t, 16> table{};
+  for (size_t mask = 0; mask != table.size(); ++mask) {
+    size_t out = 0;
+    for (size_t lane = 0; lane != 4; ++lane)
+      if (mask & (size_t(1) << lane)) {
+        table[mask] |= std::uint64_t(2 * lane) << (8 * out++);
+        table[mask] |= std::uint64_t(2 * lane + 1) << (8 * out++);
+      }
+  }
+  return table;
+}
+
+constexpr auto compress_table32 = make_compress_table<8>();
+constexpr auto compress_table64 = make_compress_table64();
+
+/// Bit i is set if keep[i] is non-zero, for 8 bytes of `keep`.
+__attribute__((target("sse2"))) inline unsigned
+keep_mask8(const unsigned char *keep) noexcept {
+  const __m128i bytes =
+      _mm_loadl_epi64(reinterpret_cast<const __m128i *>(keep));
+  const __m128i zero = _mm_cmpeq_epi8(bytes, _mm_setzero_si128());
+  return ~static_cast<unsigned>(_mm_movemask_epi8(zero)) & 0xffu;
+}
+
+__attribute__((target("sse2"))) inline unsigned
+keep_mask16(const unsigned char *keep) noexcept {
+  const __m128i bytes =
+      _mm_loadu_si128(reinterpret_cast<const __m128i *>(keep));
+  const __m128i zero = _mm_cmpeq_epi8(bytes, _mm_setzero_si128());
+  return ~static_cast<unsigned>(_mm_movemask_epi8(zero)) & 0xffffu;
+}
+
+// Each step permutes the kept lanes of a vector to its front and stores
+// the whole vector at the output position. The store may write past the
+// kept lanes, but never past the input already read, so compacting in
+// place is safe.
+__attribute__((target("avx2,popcnt"))) size_t
+compress32_avx2(void *dst, const void *src, const unsigned char *keep,
+                size_t num) noexcept {
+  auto *out = static_cast<std::uint32_t *>(dst);
+  const auto *in = static_cast<const std::uint32_t *>(src);
+  size_t kept = 0, i = 0;
+  for (; i + 8 <= num; i += 8) {
+    const unsigned mask = keep_mask8(keep + i);
+    const __m256i v =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(in + i));
+    const __m256i idx = _mm256_cvtepu8_epi32(
+        _mm_cvtsi64_si128(static_cast<long long>(compress_table32[mask])));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + kept),
+                        _mm256_permutevar8x32_epi32(v, idx));
+    kept += static_cast<size_t>(__builtin_popcount(mask));
+  }
+  return kept + compress_generic<std::uint32_t>(out + kept, in + i, keep + i,
+                                                num - i);
+}
+
+__attribute__((target("avx2,popcnt"))) size_t
+compress64_avx2(void *dst, const void *src, const unsigned char *keep,
+                size_t num) noexcept {
+  auto *out = static_cast<std::uint64_t *>(dst);
+  const auto *in = static_cast<const std::uint64_t *>(src);
+  size_t kept = 0, i = 0;
+  for (; i + 8 <= num; i += 8) {
+    const unsigned mask = keep_mask8(keep + i);
+    for (unsigned half = 0; half != 2; ++half) {
+      const unsigned m = (mask >> (4 * half)) & 0xfu;
+      const __m256i v = _mm256_loadu_si256(
+          reinterpret_cast<const __m256i *>(in + i + 4 * half));
+      const __m256i idx = _mm256_cvtepu8_epi32(
+          _mm_cvtsi64_si128(static_cast<long long>(compress_table64[m])));
+      _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + kept),
+                          _mm256_permutevar8x32_epi32(v, idx));
+      kept += static_cast<size_t>(__builtin_popcount(m));
+    }
+  }
+  return kept + compress_generic<std::uint64_t>(out + kept, in + i, keep + i,
+                                                num - i);
+}
+
+__attribute__((target("avx512f,popcnt"))) size_t
+compress32_avx512(void *dst, const void *src, const unsigned char *keep,
+                  size_t num) noexcept {
+  auto *out = static_cast<std::uint32_t *>(dst);
+  const auto *in = static_cast<const std::uint32_t *>(src);
+  size_t kept = 0, i = 0;
+  for (; i + 16 <= num; i += 16) {
+    const unsigned mask = keep_mask16(keep + i);
+    const __m512i v = _mm512_loadu_si512(in + i);
+    _mm512_storeu_si512(out + kept, _mm512_maskz_compress_epi32(
+                                        static_cast<__mmask16>(mask), v));
+    kept += static_cast<size_t>(__builtin_popcount(mask));
+  }
+  return kept + compress_generic<std::uint32_t>(out + kept, in + i, keep + i,
+                                                num - i);
+}
+
+__attribute__((target("avx512f,popcnt"))) size_t
+compress64_avx512(void *dst, const void *src, const unsigned char *keep,
+                  size_t num) noexcept {
+  auto *out = static_cast<std::uint64_t *>(dst);
+  const auto *in = static_cast<const std::uint64_t *>(src);
+  size_t kept = 0, i = 0;
+  for (; i + 8 <= num; i += 8) {
+    const unsigned mask = keep_mask8(keep + i);
+    const __m512i v = _mm512_loadu_si512(in + i);
+    _mm512_storeu_si512(out + kept, _mm512_maskz_compress_epi64(
+                                        static_cast<__mmask8>(mask), v));
+    kept += static_cast<size_t>(__builtin_popcount(mask));
+  }
+  return kept + compress_generic<std::uint64_t>(out + kept, in + i, keep + i,
+                                                num - i);
+}
+
+using compress_fn = size_t (*)(void *, const void *, const unsigned char *,
+                               size_t) noexcept;
+
+struct compress_kernels {
+  compress_fn fn32;
+  compress_fn fn64;
+};
+
+compress_kernels select_compress() noexcept {
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f"))
+    return {compress32_avx512, compress64_avx512};
+  if (__builtin_cpu_supports("avx2"))
+    return {compress32_avx2, compress64_avx2};
+  return {compress_generic<std::uint32_t>, compress_generic<std::uint64_t>};
+}
+
+#endif
+
+} // namespace
+
+size_t compress_store(void *dst, const void *src, const unsigned char *keep,
+                      size_t num, size_t elem_size) noexcept {
+  assert(elem_size == 4 || elem_size == 8);
+#if UTL_X86_DISPATCH
+  static const compress_kernels kernels = select_compress();
+  return (elem_size == 4 ? kernels.fn32 : kernels.fn64)(dst, src, keep, num);
+#else
+  return elem_size == 4
+             ? compress_generic<std::uint32_t>(dst, src, keep, num)
+             : compress_generic<std::uint64_t>(dst, src, keep, num);
+#endif
+}
+
+} // namespace detail
+} // namespace utl
@@ -0,0 +1,161 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE // mremap
+#endif
+
+#include <utl/algorithm.hpp>
+#include <utl/allocator.hpp>
+#include <utl/hugepage_allocator.hpp>
+
+#include <atomic>
+#include <cstdint>
+
+#if UTL_HAS_MMAP
+#include <sys/mman.h>
+#endif
+
+namespace utl {
+namespace detail {
+
+#if UTL_HAS_MMAP
+
+void *map_pages(size_t bytes) noexcept {
+  const auto p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  return p == MAP_FAILED ? nullptr : p;
+}
+
+void unmap_pages(void *p, size_t bytes) noexcept { munmap(p, bytes); }
+
+void *map_huge_pages(size_t bytes) noexcept {
+#ifdef MAP_HUGETLB
+  // Explicit huge pages only exist if the administrator reserved some; stop
+  // asking after the first refusal.
+  static std::atomic<bool> use_hugetlb{true};
+  if (use_hugetlb.load(std::memory_order_relaxed)) {
+    const auto p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (p != MAP_FAILED)
+      return p;
+    use_hugetlb.store(false, std::memory_order_relaxed);
+  }
+#endif
+
+  // Over-map by one huge page and trim both ends to get an aligned region
+  // that transparent huge pages can back completely.
+  const auto raw = static_cast<std::byte *>(map_pages(bytes + huge_page_size));
+  if (!raw)
+    return nullptr;
+
+  const auto addr = reinterpret_cast<std::uintptr_t>(raw);
+  const auto head =
+      ((addr + huge_page_size - 1) & ~std::uintptr_t(huge_page_size - 1)) -
+      addr;
+  if (head)
+    unmap_pages(raw, head);
+  if (head != huge_page_size)
+    unmap_pages(raw + head + bytes, huge_page_size - head);
+
+#ifdef MADV_HUGEPAGE
+  madvise(raw + head, bytes, MADV_HUGEPAGE);
+#endif
+  return raw + head;
+}
+
+#else
+
+void *map_pages(size_t) noexcept { return nullptr; }
+
+void *map_huge_pages(size_t) noexcept { return nullptr; }
+
+void unmap_pages(void *, size_t) noexcept {}
+
+#endif
+
+#if UTL_HAS_MREMAP
+
+bool expand_pages(void *p, size_t bytes, size_t new_bytes) noexcept {
+  return mremap(p, bytes, new_bytes, 0) != MAP_FAILED;
+}
+
+void *remap_pages(void *p, size_t bytes, size_t new_bytes) noexcept {
+  const auto ret = mremap(p, bytes, new_bytes, MREMAP_MAYMOVE);
+  return ret == MAP_FAILED ? nullptr : ret;
+}
+
+#else
+
+bool expand_pages(void *, size_t, size_t) noexcept { return false; }
+
+void *remap_pages(void *, size_t, size_t) noexcept { return nullptr; }
+
+#endif
+
+fixed_pool::fixed_pool(size_t block_size, size_t block_align,
+                       slab_source source) noexcept
+    : m_block_align(utl::max(block_align, alignof(free_block))),
+      m_slab_size(slab_bytes(block_size, block_align)), m_source(source) {
+  m_block_size =
+      round_up(utl::max(block_size, sizeof(free_block)), m_block_align);
+}
+
+fixed_pool::~fixed_pool() {
+  if (m_live + m_remote_live.load(std::memory_order_relaxed) == 0)
+    release();
+}
+
+void fixed_pool::release() noexcept {
+  for (auto slab = m_slabs; slab;) {
+    const auto next = slab->next;
+    if (m_source.deallocate)
+      m_source.deallocate(m_source.context, slab, m_slab_size, m_block_align);
+    else
+      operator delete(slab, static_cast<std::align_val_t>(m_slab_size));
+    slab = next;
+  }
+  m_slabs = nullptr;
+  m_free = nullptr;
+  m_bump = nullptr;
+  m_bump_end = nullptr;
+  m_live = 0;
+  m_inbox.store(nullptr, std::memory_order_relaxed);
+  m_remote_live.store(0, std::memory_order_relaxed);
+}
+
+void *fixed_pool::allocate_slab() {
+  void *raw = nullptr;
+  if (m_source.allocate) {
+    UTL_TRY {
+      raw = m_source.allocate(m_source.context, m_slab_size, m_block_align);
+    }
+    UTL_CATCH(...) {
+      --m_live;
+      UTL_RETHROW;
+    }
+  } else {
+    raw = operator new(m_slab_size, static_cast<std::align_val_t>(m_slab_size),
+                       std::nothrow);
+    if (!raw) {
+      --m_live;
+      UTL_THROW(std::bad_alloc());
+    }
+  }
+  const auto slab = static_cast<slab_header *>(raw);
+
+  slab->next = m_slabs;
+  slab->owner = this;
+  m_slabs = slab;
+
+  const auto begin = reinterpret_cast<std::byte *>(slab) +
+                     round_up(sizeof(slab_header), m_block_align);
+  const auto count =
+      (m_slab_size - static_cast<size_t>(begin - reinterpret_cast<std::byte *>(
+                                                     slab))) /
+      m_block_size;
+
+  m_bump = begin + m_block_size;
+  m_bump_end = begin + count * m_block_size;
+  return begin;
+}
+
+} // namespace detail
+} // namespace utl
@@ -0,0 +1,59 @@
+#include <utl/algorithm.hpp>
+#include <utl/arena.hpp>
+
+namespace utl {
+
+void *arena::allocate_slow(size_t bytes, size_t align) {
+  const size_t overhead = sizeof(block_header) + align;
+  if (bytes > size_t(-1) - overhead)
+    UTL_THROW(std::bad_alloc());
+
+  const size_t size = utl::max(m_next_block_size, bytes + overhead);
+  const auto block =
+      static_cast<block_header *>(operator new(size, std::nothrow));
+  if (!block)
+    UTL_THROW(std::bad_alloc());
+
+  block->next = m_head;
+  block->size = size;
+  m_head = block;
+  m_reserved += size;
+  m_cur = block_begin(block);
+  m_end = block_end(block);
+
+  if (m_next_block_size < max_block_size)
+    m_next_block_size = utl::min(m_next_block_size * 2, max_block_size);
+
+  return allocate(bytes, align);
+}
+
+void arena::reset() noexcept {
+  if (!m_head)
+    return;
+
+  for (auto block = m_head->next; block;) {
+    const auto next = block->next;
+    operator delete(block);
+    block = next;
+  }
+
+  m_head->next = nullptr;
+  m_reserved = m_head->size;
+  m_cur = block_begin(m_head);
+  m_end = block_end(m_head);
+}
+
+void arena::release() noexcept {
+  for (auto block = m_head; block;) {
+    const auto next = block->next;
+    operator delete(block);
+    block = next;
+  }
+
+  m_head = nullptr;
+  m_cur = nullptr;
+  m_end = nullptr;
+  m_reserved = 0;
+}
+
+} // namespace utl
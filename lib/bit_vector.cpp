@@ -0,0 +1,94 @@
+#include <utl/bit_vector.hpp>
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define UTL_X86_DISPATCH 1
+#include <immintrin.h>
+#else
+#define UTL_X86_DISPATCH 0
+#endif
+
+namespace utl {
+namespace detail {
+
+namespace {
+
+size_t popcount_generic(const std::uint64_t *words, size_t count) noexcept {
+  size_t total = 0;
+  for (size_t i = 0; i != count; ++i)
+    total += popcount64(words[i]);
+  return total;
+}
+
+#if UTL_X86_DISPATCH
+
+__attribute__((target("popcnt"))) size_t
+popcount_popcnt(const std::uint64_t *words, size_t count) noexcept {
+  size_t total = 0;
+  for (size_t i = 0; i != count; ++i)
+    total += static_cast<size_t>(__builtin_popcountll(words[i]));
+  return total;
+}
+
+// Counts each nibble through a 16-entry shuffle table and sums the bytes
+// with vpsadbw (Mula, Kurz and Lemire).
+__attribute__((target("avx2,popcnt"))) size_t
+popcount_avx2(const std::uint64_t *words, size_t count) noexcept {
+  const __m256i table =
+      _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4, 0, 1, 1,
+                       2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+  const __m256i nibble = _mm256_set1_epi8(0x0f);
+  __m256i sums = _mm256_setzero_si256();
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    const __m256i v =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(words + i));
+    const __m256i lo = _mm256_and_si256(v, nibble);
+    const __m256i hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), nibble);
+    const __m256i bytes = _mm256_add_epi8(_mm256_shuffle_epi8(table, lo),
+                                          _mm256_shuffle_epi8(table, hi));
+    sums = _mm256_add_epi64(sums,
+                            _mm256_sad_epu8(bytes, _mm256_setzero_si256()));
+  }
+  size_t total = static_cast<size_t>(_mm256_extract_epi64(sums, 0)) +
+                 static_cast<size_t>(_mm256_extract_epi64(sums, 1)) +
+                 static_cast<size_t>(_mm256_extract_epi64(sums, 2)) +
+                 static_cast<size_t>(_mm256_extract_epi64(sums, 3));
+  for (; i != count; ++i)
+    total += static_cast<size_t>(__builtin_popcountll(words[i]));
+  return total;
+}
+
+using popcount_fn = size_t (*)(const std::uint64_t *, size_t) noexcept;
+
+popcount_fn select_popcount() noexcept {
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt"))
+    return popcount_avx2;
+  if (__builtin_cpu_supports("popcnt"))
+    return popcount_popcnt;
+  return popcount_generic;
+}
+
+#endif
+
+} // namespace
+
+size_t popcount(const std::uint64_t *words, size_t count) noexcept {
+#if UTL_X86_DISPATCH
+  // Short runs, such as the tail of a rank query, are not worth the
+  // indirect call.
+  if (count < 8) {
+    size_t total = 0;
+    for (size_t i = 0; i != count; ++i)
+      total += popcount64(words[i]);
+    return total;
+  }
+  static const popcount_fn fn = select_popcount();
+  return fn(words, count);
+#else
+  return popcount_generic(words, count);
+#endif
+}
+
+} // namespace detail
+} // namespace utl
@@ -0,0 +1,113 @@
+#include <utl/algorithm.hpp>
+#include <utl/counting_allocator.hpp>
+
+#include <ostream>
+
+namespace utl {
+
+namespace {
+
+void write_json_string(std::ostream &os, const char *s) {
+  os << '"';
+  for (; *s; ++s) {
+    const auto c = static_cast<unsigned char>(*s);
+    if (c == '"' || c == '\\')
+      os << '\\' << *s;
+    else if (c < 0x20)
+      os << "\\u00" << "0123456789abcdef"[c >> 4] << "0123456789abcdef"[c & 15];
+    else
+      os << *s;
+  }
+  os << '"';
+}
+
+} // namespace
+
+allocation_site::allocation_site(const char *name, bool exact_peak) noexcept
+    : m_name(name),
+      m_fold_bytes(exact_peak ? 0 : std::ptrdiff_t(peak_granularity)) {
+  auto &head = allocation_registry::head();
+  m_next = head.load(std::memory_order_relaxed);
+  while (!head.compare_exchange_weak(m_next, this, std::memory_order_release,
+                                     std::memory_order_relaxed))
+    ;
+}
+
+allocation_site::statistics allocation_site::stats() const noexcept {
+  statistics s{};
+  std::ptrdiff_t live = m_live.load(std::memory_order_relaxed);
+  for (const auto &shard : m_shards) {
+    live += shard.live.load(std::memory_order_relaxed);
+    s.allocations += shard.allocations.load(std::memory_order_relaxed);
+    s.deallocations += shard.deallocations.load(std::memory_order_relaxed);
+    s.bytes_allocated += shard.bytes.load(std::memory_order_relaxed);
+    s.bytes_deallocated += shard.freed_bytes.load(std::memory_order_relaxed);
+    for (size_t i = 0; i != histogram_buckets; ++i)
+      s.histogram[i] += shard.histogram[i].load(std::memory_order_relaxed);
+  }
+  s.live_bytes = live > 0 ? size_t(live) : 0;
+  s.peak_live_bytes =
+      utl::max(m_peak.load(std::memory_order_relaxed), s.live_bytes);
+  return s;
+}
+
+allocation_site &allocation_site::unattributed() noexcept {
+  static allocation_site site("unattributed");
+  return site;
+}
+
+size_t allocation_site::next_shard_index() noexcept {
+  static std::atomic<size_t> next{0};
+  return next.fetch_add(1, std::memory_order_relaxed) % shard_count;
+}
+
+std::atomic<allocation_site *> &allocation_registry::head() noexcept {
+  static std::atomic<allocation_site *> sites{nullptr};
+  return sites;
+}
+
+void allocation_registry::dump_text(std::ostream &os) {
+  for_each([&](const allocation_site &site) {
+    const auto s = site.stats();
+    os << site.name() << ": allocations=" << s.allocations
+       << " deallocations=" << s.deallocations
+       << " bytes_allocated=" << s.bytes_allocated
+       << " bytes_deallocated=" << s.bytes_deallocated
+       << " live_bytes=" << s.live_bytes
+       << " peak_live_bytes=" << s.peak_live_bytes << '\n';
+    for (size_t i = 0; i != allocation_site::histogram_buckets; ++i) {
+      if (!s.histogram[i])
+        continue;
+      if (i == 0)
+        os << "  0: ";
+      else
+        os << "  [" << (size_t(1) << (i - 1)) << ", " << (size_t(1) << i)
+           << "): ";
+      os << s.histogram[i] << '\n';
+    }
+  });
+}
+
+void allocation_registry::dump_json(std::ostream &os) {
+  os << "{\"sites\": [";
+  bool first = true;
+  for_each([&](const allocation_site &site) {
+    const auto s = site.stats();
+    os << (first ? "\n  {" : ",\n  {") << "\"name\": ";
+    write_json_string(os, site.name());
+    os << ", \"allocations\": " << s.allocations
+       << ", \"deallocations\": " << s.deallocations
+       << ", \"bytes_allocated\": " << s.bytes_allocated
+       << ", \"bytes_deallocated\": " << s.bytes_deallocated
+       << ", \"live_bytes\": " << s.live_bytes
+       << ", \"peak_live_bytes\": " << s.peak_live_bytes
+       << ", \"histogram\": [";
+    for (size_t i = 0; i != allocation_site::histogram_buckets; ++i)
+      os << (i ? ", " : "") << s.histogram[i];
+    os << "]}";
+    first = false;
+  });
+  os << (first ? "]}\n" : "\n]}\n");
+}
+
+} // namespace utl
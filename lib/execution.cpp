@@ -0,0 +1,155 @@
+#include <utl/algorithm.hpp>
+#include <utl/allocator.hpp>
+#include <utl/execution.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace utl {
+namespace {
+
+/// Worker threads shared by all parallel operations. One operation runs at
+/// a time; the caller takes tasks alongside the workers.
+class thread_pool {
+public:
+  thread_pool() {
+    const unsigned hardware = std::thread::hardware_concurrency();
+    const size_t threads = hardware ? hardware : 1;
+    UTL_TRY {
+      m_workers.reserve(threads - 1);
+      for (size_t i = 1; i < threads; ++i)
+        m_workers.emplace_back([this] { work(); });
+    }
+    UTL_CATCH(...) {
+      // Run with the threads we got.
+    }
+  }
+
+  ~thread_pool() {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_stop = true;
+    }
+    m_wake.notify_all();
+    for (auto &worker : m_workers)
+      worker.join();
+  }
+
+  size_t concurrency() const noexcept { return m_workers.size() + 1; }
+
+  /// Runs the tasks unless another operation holds the pool.
+  bool run(size_t tasks, void (*fn)(void *, size_t), void *context) {
+    std::unique_lock<std::mutex> busy(m_busy, std::try_to_lock);
+    if (!busy)
+      return false;
+
+    job current{fn, context, tasks};
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_job = &current;
+      ++m_generation;
+    }
+    m_wake.notify_all();
+    execute(current);
+
+    // Workers that picked the job up may still be running its tasks.
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_job = nullptr;
+    m_idle.wait(lock, [this] { return m_active == 0; });
+    return true;
+  }
+
+private:
+  struct job {
+    void (*fn)(void *, size_t);
+    void *context;
+    size_t tasks;
+    std::atomic<size_t> next{0};
+  };
+
+  static void execute(job &j) {
+    for (size_t i; (i = j.next.fetch_add(1, std::memory_order_relaxed)) <
+                   j.tasks;)
+      j.fn(j.context, i);
+  }
+
+  void work() {
+    std::uint64_t seen = 0;
+    for (;;) {
+      job *j;
+      {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_wake.wait(lock, [&] {
+          return m_stop || (m_job && m_generation != seen);
+        });
+        if (m_stop)
+          return;
+        seen = m_generation;
+        j = m_job;
+        ++m_active;
+      }
+      execute(*j);
+      {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (--m_active == 0)
+          m_idle.notify_all();
+      }
+    }
+  }
+
+  std::mutex m_busy;
+  std::mutex m_mutex;
+  std::condition_variable m_wake;
+  std::condition_variable m_idle;
+  job *m_job = nullptr;
+  std::uint64_t m_generation = 0;
+  size_t m_active = 0;
+  bool m_stop = false;
+  std::vector<std::thread> m_workers;
+};
+
+thread_pool &pool() {
+  static thread_pool instance;
+  return instance;
+}
+
+} // namespace
+
+size_t parallel_concurrency() noexcept {
+  const unsigned hardware = std::thread::hardware_concurrency();
+  return hardware ? hardware : 1;
+}
+
+namespace detail {
+
+void parallel_invoke(size_t tasks, void (*fn)(void *, size_t),
+                     void *context) {
+  if (tasks > 1 && parallel_concurrency() > 1 &&
+      pool().run(tasks, fn, context))
+    return;
+  for (size_t i = 0; i != tasks; ++i)
+    fn(context, i);
+}
+
+size_t parallel_chunk_size(size_t count, size_t elem_size) noexcept {
+  constexpr size_t grain = size_t(1) << 20;
+  if (count == 0 || elem_size == 0)
+    return count;
+  const size_t bytes = count * elem_size;
+  size_t chunks = utl::min(parallel_concurrency(), bytes / grain);
+  if (chunks <= 1)
+    return count;
+  // Whole pages per chunk, so no page is first touched by two threads.
+  const size_t page_elems =
+      elem_size < detail::page_size ? detail::page_size / elem_size : 1;
+  size_t step = (count + chunks - 1) / chunks;
+  step = (step + page_elems - 1) / page_elems * page_elems;
+  return utl::min(step, count);
+}
+
+} // namespace detail
+} // namespace utl
@@ -0,0 +1,139 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE // mremap
+#endif
+
+#include <utl/mmap_vector.hpp>
+
+#include <cerrno>
+#include <system_error>
+
+#if UTL_HAS_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace utl {
+namespace detail {
+
+#if UTL_HAS_MMAP
+
+namespace {
+
+[[noreturn]] void throw_errno(const char *what) {
+  UTL_THROW(std::system_error(errno, std::generic_category(), what));
+}
+
+} // namespace
+
+mapped_file::mapped_file(const char *path, mmap_mode mode)
+    : m_writable(mode != mmap_mode::read_only) {
+  int flags = m_writable ? O_RDWR | O_CREAT : O_RDONLY;
+  if (mode == mmap_mode::truncate)
+    flags |= O_TRUNC;
+  m_fd = ::open(path, flags | O_CLOEXEC, 0644);
+  if (m_fd < 0)
+    throw_errno("mapped_file: open");
+
+  struct stat st;
+  if (::fstat(m_fd, &st) != 0) {
+    const int error = errno;
+    ::close(m_fd);
+    errno = error;
+    throw_errno("mapped_file: fstat");
+  }
+  m_size = static_cast<size_t>(st.st_size);
+  if (m_size == 0)
+    return;
+
+  const auto p = ::mmap(nullptr, m_size,
+                        m_writable ? PROT_READ | PROT_WRITE : PROT_READ,
+                        MAP_SHARED, m_fd, 0);
+  if (p == MAP_FAILED) {
+    const int error = errno;
+    ::close(m_fd);
+    errno = error;
+    throw_errno("mapped_file: mmap");
+  }
+  m_data = static_cast<std::byte *>(p);
+}
+
+mapped_file::~mapped_file() { close(); }
+
+void mapped_file::resize(size_t bytes) {
+  assert(m_writable);
+  if (bytes == m_size)
+    return;
+  if (::ftruncate(m_fd, static_cast<off_t>(bytes)) != 0)
+    throw_errno("mapped_file: ftruncate");
+
+  if (bytes == 0) {
+    if (m_data)
+      ::munmap(m_data, m_size);
+    m_data = nullptr;
+    m_size = 0;
+    return;
+  }
+
+  void *p;
+#if UTL_HAS_MREMAP
+  p = m_data ? ::mremap(m_data, m_size, bytes, MREMAP_MAYMOVE)
+             : ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED,
+                      m_fd, 0);
+#else
+  // The pages belong to the file, so a second mapping sees the same
+  // contents. Drop the old one only once the new one exists.
+  p = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+  if (p != MAP_FAILED && m_data)
+    ::munmap(m_data, m_size);
+#endif
+  if (p == MAP_FAILED) {
+    const int error = errno;
+    // Put the file back to the size the current mapping covers.
+    [[maybe_unused]] const int rc =
+        ::ftruncate(m_fd, static_cast<off_t>(m_size));
+    errno = error;
+    throw_errno("mapped_file: mremap");
+  }
+  m_data = static_cast<std::byte *>(p);
+  m_size = bytes;
+}
+
+void mapped_file::sync(bool async) {
+  if (m_data && ::msync(m_data, m_size, async ? MS_ASYNC : MS_SYNC) != 0)
+    throw_errno("mapped_file: msync");
+}
+
+void mapped_file::close() noexcept {
+  if (m_data)
+    ::munmap(m_data, m_size);
+  if (m_fd >= 0)
+    ::close(m_fd);
+  m_data = nullptr;
+  m_size = 0;
+  m_fd = -1;
+}
+
+#else
+
+mapped_file::mapped_file(const char *, mmap_mode) {
+  UTL_THROW(std::system_error(std::make_error_code(
+      std::errc::function_not_supported)));
+}
+
+mapped_file::~mapped_file() {}
+
+void mapped_file::resize(size_t) {
+  UTL_THROW(std::system_error(std::make_error_code(
+      std::errc::function_not_supported)));
+}
+
+void mapped_file::sync(bool) {}
+
+void mapped_file::close() noexcept {}
+
+#endif
+
+} // namespace detail
+} // namespace utl
@@ -0,0 +1,153 @@
+#include <utl/algorithm.hpp>
+#include <utl/memory_resource.hpp>
+
+#include <atomic>
+
+namespace utl {
+namespace pmr {
+
+namespace {
+
+class new_delete_memory_resource final : public memory_resource {
+  void *do_allocate(size_t bytes, size_t align) override {
+    return operator new(bytes, static_cast<std::align_val_t>(align));
+  }
+
+  void do_deallocate(void *p, size_t bytes, size_t align) noexcept override {
+    operator delete(p, bytes, static_cast<std::align_val_t>(align));
+  }
+
+  bool do_is_equal(const memory_resource &other) const noexcept override {
+    return this == &other;
+  }
+};
+
+class null_resource final : public memory_resource {
+  void *do_allocate(size_t, size_t) override { UTL_THROW(std::bad_alloc()); }
+
+  void do_deallocate(void *, size_t, size_t) noexcept override {}
+
+  bool do_is_equal(const memory_resource &other) const noexcept override {
+    return this == &other;
+  }
+};
+
+// Neither resource has state to tear down; keep them alive through static
+// destruction so containers with static storage duration can still free.
+template <typename Resource> memory_resource *immortal() noexcept {
+  alignas(Resource) static unsigned char storage[sizeof(Resource)];
+  static const auto resource = ::new (storage) Resource();
+  return resource;
+}
+
+void *allocate_slab(void *upstream, size_t bytes, size_t align) {
+  return static_cast<memory_resource *>(upstream)->allocate(bytes, align);
+}
+
+void deallocate_slab(void *upstream, void *p, size_t bytes,
+                     size_t align) noexcept {
+  static_cast<memory_resource *>(upstream)->deallocate(p, bytes, align);
+}
+
+std::atomic<memory_resource *> &default_resource() noexcept {
+  static std::atomic<memory_resource *> resource{new_delete_resource()};
+  return resource;
+}
+
+} // namespace
+
+memory_resource::~memory_resource() = default;
+
+memory_resource *new_delete_resource() noexcept {
+  return immortal<new_delete_memory_resource>();
+}
+
+memory_resource *null_memory_resource() noexcept {
+  return immortal<null_resource>();
+}
+
+memory_resource *get_default_resource() noexcept {
+  return default_resource().load(std::memory_order_acquire);
+}
+
+memory_resource *set_default_resource(memory_resource *r) noexcept {
+  return default_resource().exchange(r ? r : new_delete_resource(),
+                                     std::memory_order_acq_rel);
+}
+
+monotonic_buffer_resource::~monotonic_buffer_resource() = default;
+
+unsynchronized_pool_resource::unsynchronized_pool_resource(
+    const pool_options &options, memory_resource *upstream)
+    : m_upstream(upstream), m_largest_block(max_block) {
+  if (options.largest_required_pool_block) {
+    m_largest_block = min_block;
+    while (m_largest_block < max_block &&
+           m_largest_block < options.largest_required_pool_block)
+      m_largest_block *= 2;
+  }
+
+  m_pool_count = pool_index(m_largest_block, 1) + 1;
+  m_pools = static_cast<detail::fixed_pool *>(
+      operator new(m_pool_count * sizeof(detail::fixed_pool)));
+  const detail::slab_source slabs{&allocate_slab, &deallocate_slab, upstream};
+  for (size_t i = 0, size = min_block; i != m_pool_count; ++i, size *= 2)
+    ::new (m_pools + i) detail::fixed_pool(
+        size, utl::min(size, alignof(std::max_align_t)), slabs);
+}
+
+unsynchronized_pool_resource::~unsynchronized_pool_resource() {
+  release();
+  for (size_t i = 0; i != m_pool_count; ++i)
+    m_pools[i].~fixed_pool();
+  operator delete(m_pools);
+}
+
+void unsynchronized_pool_resource::release() noexcept {
+  for (size_t i = 0; i != m_pool_count; ++i)
+    m_pools[i].release();
+
+  while (m_large) {
+    const auto next = m_large->next;
+    m_upstream->deallocate(m_large, m_large->bytes, m_large->align);
+    m_large = next;
+  }
+}
+
+void *unsynchronized_pool_resource::allocate_large(size_t bytes,
+                                                   size_t align) {
+  align = utl::max(align, alignof(large_header));
+  const size_t offset = large_offset(align);
+  if (bytes > size_t(-1) - offset)
+    UTL_THROW(std::bad_alloc());
+
+  const auto header =
+      static_cast<large_header *>(m_upstream->allocate(bytes + offset, align));
+  header->prev = nullptr;
+  header->next = m_large;
+  header->bytes = bytes + offset;
+  header->align = align;
+  if (m_large)
+    m_large->prev = header;
+  m_large = header;
+  return reinterpret_cast<std::byte *>(header) + offset;
+}
+
+void unsynchronized_pool_resource::deallocate_large(void *p,
+                                                    size_t align) noexcept {
+  const size_t offset = large_offset(utl::max(align, alignof(large_header)));
+  const auto header =
+      reinterpret_cast<large_header *>(static_cast<std::byte *>(p) - offset);
+  if (header->prev)
+    header->prev->next = header->next;
+  else
+    m_large = header->next;
+  if (header->next)
+    header->next->prev = header->prev;
+  m_upstream->deallocate(header, header->bytes, header->align);
+}
+
+synchronized_pool_resource::~synchronized_pool_resource() = default;
+
+} // namespace pmr
+} // namespace utl
@@ -0,0 +1,130 @@
+#include <utl/algorithm.hpp>
+#include <utl/thread_cache.hpp>
+
+#include <mutex>
+
+namespace utl {
+namespace detail {
+
+namespace {
+
+constexpr size_t span_size = 64 * 1024;
+
+// A batch is a chain of free blocks linked through their first word. The
+// head block of each batch links to the next batch through its second word;
+// every size class is at least two pointers wide.
+struct chain_block {
+  chain_block *next;
+  chain_block *next_batch;
+};
+
+struct central_list {
+  std::mutex mutex;
+  chain_block *batches = nullptr;
+};
+
+// Never destroyed: threads may still return blocks during static
+// destruction, and spans are kept for the lifetime of the process.
+central_list *central() noexcept {
+  static const auto lists = new central_list[thread_cache::class_count];
+  return lists;
+}
+
+void push_batch(size_t cls, chain_block *batch) noexcept {
+  auto &list = central()[cls];
+  std::lock_guard<std::mutex> lock(list.mutex);
+  batch->next_batch = list.batches;
+  list.batches = batch;
+}
+
+chain_block *pop_batch(size_t cls) {
+  auto &list = central()[cls];
+  {
+    std::lock_guard<std::mutex> lock(list.mutex);
+    if (const auto batch = list.batches) {
+      list.batches = batch->next_batch;
+      return batch;
+    }
+  }
+
+  const auto span = static_cast<std::byte *>(operator new(
+      span_size, static_cast<std::align_val_t>(thread_cache::max_align),
+      std::nothrow));
+  if (!span)
+    UTL_THROW(std::bad_alloc());
+
+  const size_t size = thread_cache::class_size(cls);
+  const size_t count = span_size / size;
+  const size_t batch = thread_cache::batch_size(cls);
+
+  chain_block *first = nullptr;
+  for (size_t i = 0; i < count; i += batch) {
+    const size_t end = utl::min(i + batch, count);
+    for (size_t j = i; j != end; ++j) {
+      const auto block = reinterpret_cast<chain_block *>(span + j * size);
+      block->next = j + 1 != end
+                        ? reinterpret_cast<chain_block *>(span + (j + 1) * size)
+                        : nullptr;
+    }
+
+    const auto head = reinterpret_cast<chain_block *>(span + i * size);
+    if (first)
+      push_batch(cls, head);
+    else
+      first = head;
+  }
+  return first;
+}
+
+} // namespace
+
+thread_cache::thread_cache() noexcept : m_lists{}, m_alive(true) {}
+
+thread_cache::~thread_cache() {
+  for (size_t cls = 0; cls != class_count; ++cls)
+    while (m_lists[cls].count)
+      flush(cls, utl::min(m_lists[cls].count, batch_size(cls)));
+  m_alive = false;
+}
+
+void *thread_cache::refill(size_t cls) {
+  const auto batch = pop_batch(cls);
+  auto &list = m_lists[cls];
+
+  list.head = reinterpret_cast<free_block *>(batch->next);
+  list.count = 0;
+  for (auto block = list.head; block; block = block->next)
+    ++list.count;
+
+  return batch;
+}
+
+void thread_cache::flush(size_t cls, size_t count) noexcept {
+  auto &list = m_lists[cls];
+  const auto head = list.head;
+
+  auto last = head;
+  for (size_t i = 1; i < count; ++i)
+    last = last->next;
+
+  list.head = last->next;
+  list.count -= count;
+  last->next = nullptr;
+  push_batch(cls, reinterpret_cast<chain_block *>(head));
+}
+
+void *thread_cache::central_allocate(size_t cls) {
+  const auto batch = pop_batch(cls);
+  if (const auto rest = batch->next)
+    push_batch(cls, rest);
+  return batch;
+}
+
+void thread_cache::central_deallocate(void *p, size_t cls) noexcept {
+  const auto block = static_cast<chain_block *>(p);
+  block->next = nullptr;
+  push_batch(cls, block);
+}
+
+} // namespace detail
+} // namespace utl
@@ -0,0 +1,222 @@
+#include "doctest.h"
+
+#include <utl/allocator.hpp>
+#include <utl/string.hpp>
+#include <utl/vector.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <thread>
+
+TEST_SUITE("allocator") {
+  TEST_CASE("pool_allocator reuses freed blocks") {
+    utl::pool_allocator<long> alloc;
+    auto p1 = alloc.allocate(1);
+    auto p2 = alloc.allocate(1);
+    CHECK(p1 != p2);
+    alloc.deallocate(p1, 1);
+    CHECK(alloc.allocate(1) == p1);
+    alloc.deallocate(p1, 1);
+    alloc.deallocate(p2, 1);
+  }
+
+  TEST_CASE("pool_allocator keeps consecutive nodes close together") {
+    struct node {
+      node *next;
+      int value;
+    };
+    utl::pool_allocator<node> alloc;
+    node *nodes[16];
+    for (auto &n : nodes)
+      n = alloc.allocate(1);
+
+    auto lo = reinterpret_cast<std::uintptr_t>(nodes[0]);
+    auto hi = lo;
+    for (auto n : nodes) {
+      const auto addr = reinterpret_cast<std::uintptr_t>(n);
+      CHECK(addr % alignof(node) == 0);
+      lo = utl::min(lo, addr);
+      hi = utl::max(hi, addr);
+    }
+    CHECK(hi - lo < 2 * utl::detail::fixed_pool::slab_size);
+
+    for (auto n : nodes)
+      alloc.deallocate(n, 1);
+  }
+
+  TEST_CASE("pool_allocator rebinding gives each type its own pool") {
+    utl::pool_allocator<char> chars;
+    utl::pool_allocator<double> doubles(chars);
+    CHECK(&chars.pool() != &doubles.pool());
+    CHECK(chars.pool().block_size() == sizeof(void *));
+    CHECK(doubles.pool().block_size() == sizeof(double));
+    CHECK(chars == utl::pool_allocator<char>(doubles));
+  }
+
+  TEST_CASE("pool_allocator with node-based containers") {
+    std::list<int, utl::pool_allocator<int>> l;
+    for (int i = 0; i != 10000; ++i)
+      l.push_back(i);
+    l.remove_if([](int x) { return x % 2; });
+    CHECK(l.size() == 5000);
+
+    std::map<int, int, std::less<int>,
+             utl::pool_allocator<std::pair<const int, int>>>
+        m;
+    for (int i = 0; i != 1000; ++i)
+      m[i] = i * i;
+    CHECK(m.at(30) == 900);
+  }
+
+  TEST_CASE("pool_allocator frees blocks across threads") {
+    using list = std::list<int, utl::pool_allocator<int>>;
+
+    // Built on a thread that exits, destroyed here.
+    list l;
+    std::thread([&] {
+      list local;
+      for (int i = 0; i != 10000; ++i)
+        local.push_back(i);
+      l = std::move(local);
+    }).join();
+    CHECK(l.size() == 10000);
+    CHECK(l.back() == 9999);
+    l.clear();
+
+    // Allocated here, freed on another thread, then reused here.
+    utl::pool_allocator<int> alloc;
+    int *blocks[64];
+    for (auto &p : blocks)
+      p = alloc.allocate(1);
+    std::thread([&] {
+      for (auto p : blocks)
+        alloc.deallocate(p, 1);
+    }).join();
+    int *reused[64];
+    for (auto &p : reused) {
+      p = alloc.allocate(1);
+      CHECK(std::find(std::begin(blocks), std::end(blocks), p) !=
+            std::end(blocks));
+    }
+    for (auto p : reused)
+      alloc.deallocate(p, 1);
+
+    // Both sides at once.
+    std::map<int, int, std::less<int>,
+             utl::pool_allocator<std::pair<const int, int>>>
+        a, b;
+    std::thread t([&] {
+      for (int i = 0; i != 1000; ++i)
+        a[i] = i;
+    });
+    for (int i = 0; i != 1000; ++i)
+      b[i] = i;
+    t.join();
+    std::thread([&] { b.clear(); }).join();
+    a.clear();
+  }
+
+  TEST_CASE("pool_allocator forwards arrays") {
+    utl::vector<int, utl::pool_allocator<int>> v;
+    for (int i = 0; i != 100; ++i)
+      v.push_back(i);
+    CHECK(v.size() == 100);
+    CHECK(v[99] == 99);
+  }
+}
+
+TEST_SUITE("allocator") {
+  TEST_CASE("allocate_at_least reports the usable size") {
+    utl::allocator<char> alloc;
+    auto result = alloc.allocate_at_least(20);
+    CHECK(result.count == 32);
+    alloc.deallocate(result.ptr, result.count);
+
+    utl::allocator<int> pages;
+    auto large = pages.allocate_at_least(40000);
+    CHECK(large.count * sizeof(int) % 4096 == 0);
+    CHECK(large.count >= 40000);
+    pages.deallocate(large.ptr, large.count);
+  }
+
+  TEST_CASE("allocate_at_least falls back to allocate") {
+    utl::pool_allocator<int> alloc;
+    auto result = utl::allocate_at_least(alloc, 3);
+    CHECK(result.count == 3);
+    alloc.deallocate(result.ptr, result.count);
+  }
+
+  TEST_CASE("containers record the capacity they got") {
+    utl::vector<char> v;
+    v.push_back('a');
+    CHECK(v.capacity() == 16);
+    for (int i = 0; i != 16; ++i)
+      v.push_back('b');
+    CHECK(v.capacity() == 32);
+    v.shrink_to_fit();
+    CHECK(v.capacity() == v.size());
+
+    utl::basic_string<char> s(20, 'x');
+    CHECK(s.capacity() == 31);
+  }
+}
+
+TEST_SUITE("allocator") {
+  TEST_CASE("large blocks can grow without copying") {
+    utl::allocator<int> alloc;
+    const size_t n = (size_t(4) << 20) / sizeof(int);
+    auto block = alloc.allocate_at_least(n);
+    for (size_t i = 0; i != block.count; i += 1024)
+      block.ptr[i] = static_cast<int>(i);
+
+    if (const auto expanded =
+            utl::try_expand(alloc, block.ptr, block.count, 2 * n)) {
+      CHECK(expanded >= 2 * n);
+      block.count = expanded;
+    }
+
+    auto moved = utl::try_reallocate(alloc, block.ptr, block.count, 4 * n);
+#if UTL_HAS_MREMAP
+    REQUIRE(moved.ptr != nullptr);
+    CHECK(moved.count >= 4 * n);
+    bool intact = true;
+    for (size_t i = 0; i != n; i += 1024)
+      intact = intact && moved.ptr[i] == static_cast<int>(i);
+    CHECK(intact);
+    moved.ptr[4 * n - 1] = 1;
+    alloc.deallocate(moved.ptr, moved.count);
+#else
+    CHECK(moved.ptr == nullptr);
+    alloc.deallocate(block.ptr, block.count);
+#endif
+  }
+
+  TEST_CASE("allocators without growth hooks report failure") {
+    utl::pool_allocator<int> alloc;
+    auto p = alloc.allocate(4);
+    CHECK(utl::try_expand(alloc, p, 4, 8) == 0);
+    CHECK(utl::try_reallocate(alloc, p, 4, 8).ptr == nullptr);
+    alloc.deallocate(p, 4);
+  }
+
+  TEST_CASE("huge vectors keep their contents while growing in place") {
+    utl::vector<unsigned> v;
+    const unsigned n = (8u << 20) / sizeof(unsigned);
+    for (unsigned i = 0; i != n; ++i)
+      v.push_back(i);
+    CHECK(v.capacity() * sizeof(unsigned) % utl::detail::page_size == 0);
+    v.reserve(4 * n);
+    CHECK(v.capacity() >= 4 * n);
+    bool intact = true;
+    for (unsigned i = 0; i != n; ++i)
+      intact = intact && v[i] == i;
+    CHECK(intact);
+
+    utl::vector<utl::vector<int>> nested(200000u);
+    nested[199999].push_back(7);
+    nested.reserve(800000u);
+    CHECK(nested[199999][0] == 7);
+  }
+}
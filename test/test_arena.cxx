@@ -0,0 +1,112 @@
+#include "doctest.h"
+
+#include <utl/arena.hpp>
+#include <utl/string.hpp>
+#include <utl/vector.hpp>
+
+#include <algorithm>
+#include <cstdint>
+
+TEST_SUITE("arena") {
+  TEST_CASE("allocations are aligned and come from the arena") {
+    utl::arena a(1024);
+
+    auto p1 = a.allocate(3, 1);
+    auto p2 = a.allocate(sizeof(double), alignof(double));
+    auto p3 = a.allocate(64, 64);
+
+    CHECK(p1 != nullptr);
+    CHECK(reinterpret_cast<std::uintptr_t>(p2) % alignof(double) == 0);
+    CHECK(reinterpret_cast<std::uintptr_t>(p3) % 64 == 0);
+    CHECK(a.bytes_reserved() == 1024);
+  }
+
+  TEST_CASE("oversized allocations get their own block") {
+    utl::arena a(1024);
+    a.allocate(16);
+    auto p = a.allocate(100000);
+    CHECK(p != nullptr);
+    CHECK(a.bytes_reserved() > 100000);
+  }
+
+  TEST_CASE("last allocation is rolled back") {
+    utl::arena a(1024);
+    a.allocate(16);
+    const auto available = a.bytes_available();
+    auto p = a.allocate(100, 1);
+    a.deallocate(p, 100);
+    CHECK(a.bytes_available() == available);
+  }
+
+  TEST_CASE("reset keeps one block, release frees everything") {
+    utl::arena a(1024);
+    for (int i = 0; i != 100; ++i)
+      a.allocate(512);
+    CHECK(a.bytes_reserved() > 1024);
+
+    a.reset();
+    const auto reserved = a.bytes_reserved();
+    CHECK(reserved > 0);
+    CHECK(a.bytes_available() + 2 * sizeof(void *) == reserved);
+
+    a.release();
+    CHECK(a.bytes_reserved() == 0);
+    CHECK(a.allocate(8) != nullptr);
+  }
+
+  TEST_CASE("vector with arena allocator") {
+    utl::arena a;
+    utl::arena_allocator<int> alloc(a);
+
+    utl::vector<int, utl::arena_allocator<int>> v1(alloc);
+    for (int i = 0; i != 1000; ++i)
+      v1.push_back(i);
+    CHECK(v1.size() == 1000);
+    CHECK(v1[999] == 999);
+
+    SUBCASE("move assignment and swap only exchange pointers") {
+      utl::arena b;
+      utl::vector<int, utl::arena_allocator<int>> v2(
+          10u, 42, utl::arena_allocator<int>(b));
+      const auto data1 = v1.data();
+      const auto data2 = v2.data();
+
+      swap(v1, v2);
+      CHECK(v1.data() == data2);
+      CHECK(v2.data() == data1);
+      CHECK(&v1.get_allocator().resource() == &b);
+      CHECK(&v2.get_allocator().resource() == &a);
+
+      v1 = std::move(v2);
+      CHECK(v1.data() == data1);
+      CHECK(&v1.get_allocator().resource() == &a);
+    }
+
+    SUBCASE("copy assignment propagates the arena") {
+      utl::arena b;
+      utl::vector<int, utl::arena_allocator<int>> v2{
+          utl::arena_allocator<int>(b)};
+      v2 = v1;
+      CHECK(v2.get_allocator() == v1.get_allocator());
+      CHECK(std::equal(v1.begin(), v1.end(), v2.begin(), v2.end()));
+    }
+  }
+
+  TEST_CASE("basic_string with arena allocator") {
+    utl::arena a;
+    using string =
+        utl::basic_string<char, std::char_traits<char>,
+                          utl::arena_allocator<char>>;
+
+    string s1(40, 'x', utl::arena_allocator<char>(a));
+    string s2(s1);
+    string s3(std::move(s1));
+
+    CHECK(s2.size() == 40);
+    CHECK(s3.size() == 40);
+    CHECK(s1.size() == 0);
+    CHECK(s2.data() != s3.data());
+    CHECK(s2.get_allocator().resource().bytes_reserved() ==
+          a.bytes_reserved());
+  }
+}
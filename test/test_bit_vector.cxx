@@ -0,0 +1,111 @@
+#include "doctest.h"
+
+#include <utl/bit_vector.hpp>
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+TEST_SUITE("bit_vector") {
+  TEST_CASE("single bits") {
+    utl::bit_vector b{true, false, true};
+    CHECK(b.size() == 3);
+    CHECK(b[0]);
+    CHECK(!b[1]);
+    b.push_back(true);
+    b[1] = true;
+    b.reset(0);
+    b.flip(2);
+    CHECK(!b.test(0));
+    CHECK(b.test(1));
+    CHECK(!b.test(2));
+    CHECK(b.test(3));
+    CHECK(b.count() == 2);
+    b.pop_back();
+    CHECK(b.count() == 1);
+    CHECK_THROWS_AS(b.at(3), std::out_of_range);
+  }
+
+  TEST_CASE("ranges keep the tail clear") {
+    utl::bit_vector b(200);
+    b.set_range(3, 130);
+    CHECK(b.count() == 127);
+    CHECK(b.find_first() == 3);
+    b.flip_range(0, 200);
+    CHECK(b.count() == 73);
+    b.reset_range(0, 3);
+    CHECK(b.count() == 70);
+    b.flip();
+    CHECK(b.count() == 130);
+    b.resize(100);
+    CHECK(b.count() == 100);
+    b.reset(1);
+    b.resize(300, true);
+    CHECK(b.count() == 299);
+    b.resize(64);
+    CHECK(b.word_count() == 1);
+    CHECK(b.data()[0] == ~std::uint64_t(2));
+    b.set();
+    CHECK(b.all());
+    b.reset();
+    CHECK(b.none());
+  }
+
+  TEST_CASE("find_first and find_next") {
+    utl::bit_vector b(1000);
+    CHECK(b.find_first() == utl::bit_vector::npos);
+    const std::vector<size_t> ones = {0, 63, 64, 65, 500, 999};
+    for (auto i : ones)
+      b.set(i);
+    std::vector<size_t> found;
+    for (auto i = b.find_first(); i != utl::bit_vector::npos;
+         i = b.find_next(i))
+      found.push_back(i);
+    CHECK(found == ones);
+  }
+
+  TEST_CASE("rank and select match a scan") {
+    std::mt19937_64 rng(42);
+    for (const double density : {0.001, 0.1, 0.5, 0.97}) {
+      std::bernoulli_distribution bit(density);
+      utl::bit_vector b;
+      std::vector<size_t> ones;
+      for (size_t i = 0; i != 100000; ++i) {
+        const bool value = bit(rng);
+        b.push_back(value);
+        if (value)
+          ones.push_back(i);
+      }
+      REQUIRE(b.count() == ones.size());
+
+      for (const bool indexed : {false, true}) {
+        if (indexed)
+          b.build_index();
+        CHECK(b.has_index() == indexed);
+        bool ok = true;
+        for (size_t k = 0; k < ones.size(); k += 7) {
+          ok = ok && b.select(k) == ones[k];
+          ok = ok && b.rank(ones[k]) == k;
+          ok = ok && b.rank(ones[k] + 1) == k + 1;
+        }
+        CHECK(ok);
+        CHECK(b.rank(b.size()) == ones.size());
+        CHECK(b.select(ones.size()) == utl::bit_vector::npos);
+        CHECK(b.count(100, 5000) == b.rank(5000) - b.rank(100));
+      }
+      b.set(0);
+      CHECK(!b.has_index());
+    }
+  }
+
+  TEST_CASE("compare and swap") {
+    utl::bit_vector a(70, true);
+    utl::bit_vector b(70, true);
+    CHECK(a == b);
+    b.reset(69);
+    CHECK(a != b);
+    swap(a, b);
+    CHECK(!a[69]);
+    CHECK(b[69]);
+  }
+}
@@ -0,0 +1,161 @@
+#include "doctest.h"
+
+#include <utl/concurrent_vector.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+TEST_SUITE("concurrent_vector") {
+  TEST_CASE("appends keep element addresses") {
+    utl::concurrent_vector<std::string> v;
+    CHECK(v.empty());
+    v.push_back("first");
+    const std::string *const first = &v[0];
+    for (int i = 0; i != 1000; ++i)
+      v.emplace_back(std::to_string(i));
+    CHECK(first == &v.front());
+    CHECK(v.size() == 1001);
+    CHECK(v[1000] == "999");
+    CHECK(v.back() == "999");
+    CHECK(v.ready(1000));
+    CHECK(!v.ready(1001));
+    CHECK(v.capacity() >= 1001);
+    CHECK_THROWS_AS(v.at(1001), std::out_of_range);
+  }
+
+  TEST_CASE("grow_by") {
+    utl::concurrent_vector<int> v;
+    auto it = v.grow_by(20);
+    CHECK(it == v.begin());
+    CHECK(std::count(v.begin(), v.end(), 0) == 20);
+
+    it = v.grow_by(5, 7);
+    CHECK(it - v.begin() == 20);
+    CHECK(*it == 7);
+
+    const int values[] = {1, 2, 3};
+    it = v.grow_by(std::begin(values), std::end(values));
+    CHECK(v.size() == 28);
+    CHECK(std::equal(it, v.end(), std::begin(values)));
+
+    v.reserve(1000);
+    CHECK(v.capacity() >= 1000);
+    CHECK(v.size() == 28);
+  }
+
+  TEST_CASE("iterators") {
+    utl::concurrent_vector<int> v;
+    for (int i = 0; i != 500; ++i)
+      v.push_back(499 - i);
+    std::sort(v.begin(), v.end());
+    CHECK(std::is_sorted(v.cbegin(), v.cend()));
+    CHECK(v.begin()[123] == 123);
+    CHECK(*v.rbegin() == 499);
+    utl::concurrent_vector<int>::const_iterator it = v.begin() + 10;
+    CHECK(*++it == 11);
+  }
+
+  TEST_CASE("copy, move and swap") {
+    utl::concurrent_vector<std::string> a{"x", "y"};
+    auto b = a;
+    CHECK(b.size() == 2);
+    CHECK(b[1] == "y");
+    auto c = std::move(a);
+    CHECK(a.empty());
+    CHECK(c[0] == "x");
+    a.push_back("z");
+    swap(a, c);
+    CHECK(a.size() == 2);
+    CHECK(c[0] == "z");
+    c.clear();
+    CHECK(c.empty());
+  }
+
+  TEST_CASE("appends that throw leave valid slots") {
+    struct thrower {
+      int value = -1;
+      thrower() noexcept = default;
+      explicit thrower(int val) : value(val) {
+        if (val < 0)
+          throw std::runtime_error("thrower");
+      }
+    };
+    utl::concurrent_vector<thrower> v;
+    v.emplace_back(1);
+    const int values[] = {2, -3, 4};
+    CHECK_THROWS_AS(v.grow_by(std::begin(values), std::end(values)),
+                    std::runtime_error);
+    CHECK_THROWS_AS(v.emplace_back(-5), std::runtime_error);
+    REQUIRE(v.size() == 5);
+    CHECK(v.ready(2));
+    CHECK(v.ready(3));
+    CHECK(v.ready(4));
+    auto copy = v;
+    REQUIRE(copy.size() == 5);
+    CHECK(copy[1].value == 2);
+    CHECK(copy[2].value == -1);
+    CHECK(copy[3].value == -1);
+    CHECK(copy[4].value == -1);
+
+    struct strict {
+      std::string value;
+      explicit strict(const char *val) : value(val) {
+        if (value.empty())
+          throw std::runtime_error("strict");
+      }
+    };
+    utl::concurrent_vector<strict> w;
+    w.emplace_back("a");
+    CHECK_THROWS_AS(w.emplace_back(""), std::runtime_error);
+    w.emplace_back("b");
+    REQUIRE(w.size() == 3);
+    CHECK(!w.ready(1));
+    auto copy2 = w;
+    REQUIRE(copy2.size() == 2);
+    CHECK(copy2[0].value == "a");
+    CHECK(copy2[1].value == "b");
+  }
+
+  TEST_CASE("concurrent appends and reads") {
+    constexpr int threads = 4;
+    constexpr int per_thread = 20000;
+    utl::concurrent_vector<int> v;
+    std::atomic<bool> done{false};
+    std::atomic<long> seen{0};
+
+    std::thread reader([&] {
+      while (!done.load(std::memory_order_acquire)) {
+        long sum = 0;
+        const size_t size = v.size();
+        for (size_t i = 0; i < size; ++i)
+          if (v.ready(i))
+            sum += v[i] >= 0;
+        seen.store(sum, std::memory_order_relaxed);
+      }
+    });
+
+    std::vector<std::thread> writers;
+    for (int t = 0; t != threads; ++t)
+      writers.emplace_back([&v, t] {
+        for (int i = 0; i != per_thread; ++i)
+          v.push_back(t * per_thread + i);
+      });
+    for (auto &w : writers)
+      w.join();
+    done.store(true, std::memory_order_release);
+    reader.join();
+
+    REQUIRE(v.size() == threads * per_thread);
+    std::vector<int> values(v.begin(), v.end());
+    std::sort(values.begin(), values.end());
+    bool complete = true;
+    for (int i = 0; i != threads * per_thread; ++i)
+      complete = complete && values[i] == i;
+    CHECK(complete);
+    CHECK(seen.load() <= threads * per_thread);
+  }
+}
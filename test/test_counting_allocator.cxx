@@ -0,0 +1,151 @@
+#include "doctest.h"
+
+#include <utl/any.hpp>
+#include <utl/counting_allocator.hpp>
+#include <utl/string.hpp>
+#include <utl/unique_ptr.hpp>
+#include <utl/vector.hpp>
+
+#include <sstream>
+#include <thread>
+
+TEST_SUITE("counting_allocator") {
+  TEST_CASE("vector allocations are recorded") {
+    auto &site = UTL_ALLOCATION_SITE("test/vector");
+    const auto before = site.stats();
+    {
+      utl::vector<int, utl::counting_allocator<int>> v(
+          utl::counting_allocator<int>{site});
+      for (int i = 0; i != 1000; ++i)
+        v.push_back(i);
+      const auto during = site.stats();
+      CHECK(during.allocations > before.allocations);
+      CHECK(during.live_bytes - before.live_bytes >= 1000 * sizeof(int));
+      CHECK(during.peak_live_bytes >= during.live_bytes);
+    }
+    const auto after = site.stats();
+    CHECK(after.live_bytes == before.live_bytes);
+    CHECK(after.allocations - before.allocations ==
+          after.deallocations - before.deallocations);
+    CHECK(after.bytes_allocated - before.bytes_allocated ==
+          after.bytes_deallocated - before.bytes_deallocated);
+  }
+
+  TEST_CASE("string allocations are recorded") {
+    auto &site = UTL_ALLOCATION_SITE("test/string");
+    using string =
+        utl::basic_string<char, std::char_traits<char>,
+                          utl::counting_allocator<char>>;
+    const auto before = site.stats();
+    {
+      string s(1000, 'x', utl::counting_allocator<char>{site});
+      string copy(s);
+      CHECK(&copy.get_allocator().site() == &site);
+      CHECK(site.stats().allocations - before.allocations == 2);
+    }
+    CHECK(site.stats().live_bytes == before.live_bytes);
+  }
+
+  TEST_CASE("allocate_unique and any") {
+    auto &site = UTL_ALLOCATION_SITE("test/heap");
+    const utl::counting_allocator<int> alloc{site};
+    const auto before = site.stats();
+    {
+      auto p = utl::allocate_unique<double>(alloc, 1.5);
+      CHECK(*p == 1.5);
+      CHECK(site.stats().live_bytes - before.live_bytes == sizeof(double));
+
+      utl::any a(std::allocator_arg, alloc, utl::vector<int>{1, 2, 3});
+      utl::any b(a);
+      CHECK(utl::any_cast<utl::vector<int>>(b).size() == 3);
+      CHECK(site.stats().allocations - before.allocations == 3);
+    }
+    const auto after = site.stats();
+    CHECK(after.live_bytes == before.live_bytes);
+    CHECK(after.deallocations - before.deallocations == 3);
+  }
+
+  TEST_CASE("swap and move between sites") {
+    auto &left = UTL_ALLOCATION_SITE("test/swap-left");
+    auto &right = UTL_ALLOCATION_SITE("test/swap-right");
+    using alloc = utl::counting_allocator<int>;
+    CHECK(alloc{left} != alloc{right});
+    const auto left_before = left.stats().live_bytes;
+    const auto right_before = right.stats().live_bytes;
+    {
+      utl::vector<int, alloc> a(100u, 1, alloc{left});
+      utl::vector<int, alloc> b(10u, 2, alloc{right});
+      swap(a, b);
+      CHECK(&a.get_allocator().site() == &right);
+      CHECK(left.stats().live_bytes - left_before >= 100 * sizeof(int));
+
+      utl::vector<int, alloc> c(1000u, 3, alloc{left});
+      a = std::move(c);
+      CHECK(&a.get_allocator().site() == &left);
+      CHECK(right.stats().live_bytes == right_before);
+    }
+    CHECK(left.stats().live_bytes == left_before);
+    CHECK(right.stats().live_bytes == right_before);
+  }
+
+  TEST_CASE("histogram buckets by log2 size") {
+    static utl::allocation_site site("test/histogram", true);
+    site.record_allocate(0);
+    site.record_allocate(1);
+    site.record_allocate(48);
+    site.record_allocate(63);
+    site.record_deallocate(48);
+    const auto s = site.stats();
+    CHECK(s.histogram[0] == 1);
+    CHECK(s.histogram[1] == 1);
+    CHECK(s.histogram[6] == 2);
+    CHECK(s.live_bytes == 64);
+    CHECK(s.peak_live_bytes == 112);
+  }
+
+  TEST_CASE("peak is folded in coarse steps") {
+    static utl::allocation_site site("test/peak");
+    constexpr size_t step = utl::allocation_site::peak_granularity;
+    site.record_allocate(100);
+    CHECK(site.stats().peak_live_bytes == 100);
+    site.record_allocate(2 * step);
+    site.record_deallocate(2 * step);
+    const auto s = site.stats();
+    CHECK(s.live_bytes == 100);
+    CHECK(s.peak_live_bytes == 2 * step + 100);
+  }
+
+  TEST_CASE("counters are shared between threads") {
+    auto &site = UTL_ALLOCATION_SITE("test/threads");
+    const auto before = site.stats();
+    auto work = [&] {
+      utl::counting_allocator<long> alloc{site};
+      for (int i = 0; i != 1000; ++i)
+        alloc.deallocate(alloc.allocate(4), 4);
+    };
+    std::thread t1(work), t2(work);
+    t1.join();
+    t2.join();
+    const auto after = site.stats();
+    CHECK(after.allocations - before.allocations == 2000);
+    CHECK(after.bytes_allocated - before.bytes_allocated ==
+          2000 * 4 * sizeof(long));
+    CHECK(after.live_bytes == before.live_bytes);
+  }
+
+  TEST_CASE("registry dumps") {
+    auto &site = UTL_ALLOCATION_SITE("test/\"dump\"");
+    utl::counting_allocator<char> alloc{site};
+    alloc.deallocate(alloc.allocate(100), 100);
+
+    std::ostringstream text;
+    utl::allocation_registry::dump_text(text);
+    CHECK(text.str().find("test/\"dump\": allocations=1") != std::string::npos);
+    CHECK(text.str().find("  [64, 128): 1") != std::string::npos);
+
+    std::ostringstream json;
+    utl::allocation_registry::dump_json(json);
+    CHECK(json.str().find("\"name\": \"test/\\\"dump\\\"\", \"allocations\": 1") !=
+          std::string::npos);
+  }
+}
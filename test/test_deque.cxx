@@ -0,0 +1,129 @@
+#include "doctest.h"
+
+#include <utl/counting_allocator.hpp>
+#include <utl/deque.hpp>
+
+#include <algorithm>
+#include <memory>
+#include <numeric>
+#include <string>
+#include <vector>
+
+TEST_SUITE("deque") {
+  TEST_CASE("push and pop at both ends") {
+    utl::deque<int> d;
+    CHECK(d.empty());
+    for (int i = 0; i != 5000; ++i) {
+      d.push_back(i);
+      d.push_front(-i - 1);
+    }
+    CHECK(d.size() == 10000);
+    CHECK(d.front() == -5000);
+    CHECK(d.back() == 4999);
+    bool ordered = true;
+    for (int i = 0; i != 10000; ++i)
+      ordered = ordered && d[i] == i - 5000;
+    CHECK(ordered);
+
+    for (int i = 0; i != 4000; ++i) {
+      d.pop_front();
+      d.pop_back();
+    }
+    CHECK(d.size() == 2000);
+    CHECK(d.front() == -1000);
+    CHECK(d.back() == 999);
+    CHECK_THROWS_AS(d.at(2000), std::out_of_range);
+  }
+
+  TEST_CASE("references stay valid while growing") {
+    utl::deque<std::string> d;
+    d.push_back("first");
+    std::string *const first = &d.front();
+    for (int i = 0; i != 10000; ++i) {
+      d.emplace_back(3, 'x');
+      d.emplace_front(4, 'y');
+    }
+    CHECK(first == &d[10000]);
+    CHECK(*first == "first");
+  }
+
+  TEST_CASE("works as a queue without reallocating") {
+    auto &site = UTL_ALLOCATION_SITE("test/deque");
+    using alloc = utl::counting_allocator<int>;
+    utl::deque<int, alloc> d{alloc(site)};
+    for (int i = 0; i != 1000; ++i)
+      d.push_back(i);
+    const auto before = site.stats().allocations;
+    bool fifo = true;
+    for (int i = 1000; i != 100000; ++i) {
+      d.push_back(i);
+      fifo = fifo && d.front() == i - 1000;
+      d.pop_front();
+    }
+    CHECK(fifo);
+    // Freed blocks are recycled, so only the map can grow.
+    CHECK(site.stats().allocations - before < 16);
+    CHECK(d.size() == 1000);
+  }
+
+  TEST_CASE("iterators") {
+    utl::deque<int> d(3000);
+    std::iota(d.begin(), d.end(), 0);
+    CHECK(d.end() - d.begin() == 3000);
+    CHECK(*(d.begin() + 2999) == 2999);
+    CHECK(d.begin()[1234] == 1234);
+    CHECK(*d.rbegin() == 2999);
+    CHECK(std::is_sorted(d.cbegin(), d.cend()));
+
+    utl::deque<int>::const_iterator it = d.begin();
+    it += 100;
+    CHECK(*it-- == 100);
+    CHECK(*it == 99);
+    CHECK(it < d.cend());
+
+    std::reverse(d.begin(), d.end());
+    CHECK(d.front() == 2999);
+    CHECK(std::accumulate(d.begin(), d.end(), 0L) == 2999L * 3000 / 2);
+  }
+
+  TEST_CASE("insert and erase") {
+    utl::deque<int> d{1, 2, 6};
+    d.insert(d.begin() + 2, {3, 4, 5});
+    d.emplace(d.begin(), 0);
+    d.insert(d.end(), 2, 7);
+    CHECK(d == utl::deque<int>{0, 1, 2, 3, 4, 5, 6, 7, 7});
+    d.erase(d.begin() + 1);
+    d.erase(d.end() - 3, d.end() - 1);
+    CHECK(d == utl::deque<int>{0, 2, 3, 4, 5, 7});
+
+    const std::vector<int> v(1000, 9);
+    d.insert(d.begin() + 1, v.begin(), v.end());
+    CHECK(d.size() == 1006);
+    CHECK(d[1000] == 9);
+    CHECK(d[1001] == 2);
+  }
+
+  TEST_CASE("copy, move and swap") {
+    utl::deque<std::unique_ptr<int>> a;
+    for (int i = 0; i != 600; ++i)
+      a.push_back(std::make_unique<int>(i));
+    auto b = std::move(a);
+    CHECK(a.empty());
+    CHECK(*b[599] == 599);
+    a.push_front(std::make_unique<int>(-1));
+    swap(a, b);
+    CHECK(a.size() == 600);
+    CHECK(*b.front() == -1);
+
+    utl::deque<std::string> s(700, "s");
+    utl::deque<std::string> t{"t"};
+    t = s;
+    CHECK(t == s);
+    s.clear();
+    CHECK(s.empty());
+    s.push_back("again");
+    CHECK(s.front() == "again");
+    s = std::move(t);
+    CHECK(s.size() == 700);
+  }
+}
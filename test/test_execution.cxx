@@ -0,0 +1,63 @@
+#include "doctest.h"
+
+#include <utl/execution.hpp>
+#include <utl/vector.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <set>
+#include <thread>
+#include <vector>
+
+TEST_SUITE("execution") {
+  TEST_CASE("parallel_for runs every task once") {
+    std::vector<std::atomic<int>> hits(1000);
+    utl::parallel_for(hits.size(), [&](std::size_t i) { ++hits[i]; });
+    CHECK(std::all_of(hits.begin(), hits.end(),
+                      [](const auto &h) { return h == 1; }));
+
+    bool ran = false;
+    utl::parallel_for(1, [&](std::size_t) { ran = true; });
+    CHECK(ran);
+    utl::parallel_for(0, [](std::size_t) { CHECK(false); });
+  }
+
+  TEST_CASE("nested and concurrent calls") {
+    std::atomic<std::size_t> total{0};
+    utl::parallel_for(8, [&](std::size_t) {
+      utl::parallel_for(100, [&](std::size_t i) { total += i; });
+    });
+    CHECK(total == 8 * 4950);
+
+    total = 0;
+    std::thread other([&] {
+      for (int round = 0; round != 50; ++round)
+        utl::parallel_for(64, [&](std::size_t) { ++total; });
+    });
+    for (int round = 0; round != 50; ++round)
+      utl::parallel_for(64, [&](std::size_t) { ++total; });
+    other.join();
+    CHECK(total == 2 * 50 * 64);
+  }
+
+  TEST_CASE("fill") {
+    std::vector<std::uint32_t> v((std::size_t(1) << 22) + 3);
+    utl::fill(utl::par, v.begin(), v.end(), 7u);
+    CHECK(std::count(v.begin(), v.end(), 7u) ==
+          static_cast<std::ptrdiff_t>(v.size()));
+
+    std::uint16_t small[5] = {};
+    utl::fill(utl::par, small, small + 5, std::uint16_t{3});
+    CHECK(small[4] == 3);
+  }
+
+  TEST_CASE("chunks cover whole pages") {
+    const std::size_t count = std::size_t(1) << 24;
+    const std::size_t step = utl::detail::parallel_chunk_size(count, 4);
+    CHECK(step <= count);
+    CHECK((step == count || (step * 4) % 4096 == 0));
+    CHECK(utl::detail::parallel_chunk_size(100, 4) == 100);
+    CHECK(utl::detail::parallel_chunk_size(0, 4) == 0);
+  }
+}
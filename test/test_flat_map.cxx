@@ -0,0 +1,274 @@
+#include "doctest.h"
+
+#include <utl/flat_map.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace {
+
+struct ThrowOnCopy {
+  ThrowOnCopy() = default;
+  ThrowOnCopy(const ThrowOnCopy &) { throw std::runtime_error("copy"); }
+  ThrowOnCopy(ThrowOnCopy &&) noexcept = default;
+  ThrowOnCopy &operator=(const ThrowOnCopy &) = default;
+  ThrowOnCopy &operator=(ThrowOnCopy &&) noexcept = default;
+};
+
+// Moving a negative value throws.
+struct Fragile {
+  int value;
+  explicit Fragile(int val) noexcept : value(val) {}
+  Fragile(const Fragile &other) = default;
+  Fragile(Fragile &&other) : value(other.value) { check(); }
+  Fragile &operator=(const Fragile &other) = default;
+  Fragile &operator=(Fragile &&other) {
+    value = other.value;
+    check();
+    return *this;
+  }
+  void check() const {
+    if (value < 0)
+      throw std::runtime_error("move");
+  }
+};
+
+// Fails every request for more than 64 elements.
+template <typename T> struct SmallAllocator {
+  using value_type = T;
+  SmallAllocator() = default;
+  template <typename U> SmallAllocator(const SmallAllocator<U> &) noexcept {}
+
+  T *allocate(size_t n) {
+    if (n > 64)
+      throw std::bad_alloc();
+    return std::allocator<T>().allocate(n);
+  }
+  void deallocate(T *p, size_t n) noexcept {
+    std::allocator<T>().deallocate(p, n);
+  }
+
+  friend bool operator==(const SmallAllocator &,
+                         const SmallAllocator &) noexcept {
+    return true;
+  }
+  friend bool operator!=(const SmallAllocator &,
+                         const SmallAllocator &) noexcept {
+    return false;
+  }
+};
+
+} // namespace
+
+TEST_SUITE("flat_map") {
+  TEST_CASE("insert and lookup") {
+    utl::flat_map<int, std::string> m;
+    CHECK(m.empty());
+    CHECK(m.insert({3, "three"}).second);
+    CHECK(m.emplace(1, "one").second);
+    CHECK(m.try_emplace(2, 3, 'x').second);
+    CHECK_FALSE(m.try_emplace(2, "two").second);
+    CHECK(m.at(2) == "xxx");
+    CHECK_FALSE(m.insert_or_assign(2, "two").second);
+    CHECK(m[2] == "two");
+    m[5] = "five";
+    CHECK(m.size() == 4);
+    CHECK(m.keys() == utl::vector<int>{1, 2, 3, 5});
+    CHECK(m.values().back() == "five");
+
+    CHECK(m.contains(3));
+    CHECK_FALSE(m.contains(4));
+    CHECK(m.count(5) == 1);
+    CHECK(m.find(4) == m.end());
+    CHECK(m.find(3)->second == "three");
+    CHECK((*m.lower_bound(4)).first == 5);
+    CHECK(m.upper_bound(5) == m.end());
+    CHECK_THROWS_AS(m.at(4), std::out_of_range);
+
+    const auto &cm = m;
+    CHECK(cm.at(1) == "one");
+    CHECK(cm.find(1)->second == "one");
+    CHECK(cm.equal_range(2).first == cm.find(2));
+
+    m.find(1)->second = "uno";
+    (*m.begin()).second += "!";
+    CHECK(m.at(1) == "uno!");
+
+    CHECK(m.erase(2) == 1);
+    CHECK(m.erase(2) == 0);
+    const auto it = m.erase(m.begin());
+    CHECK(it->first == 3);
+    CHECK(m.size() == 2);
+  }
+
+  TEST_CASE("iterators") {
+    utl::flat_map<int, int> m{{2, 20}, {1, 10}, {3, 30}};
+    int sum = 0;
+    for (auto [key, value] : m)
+      sum += key * value;
+    CHECK(sum == 140);
+    for (auto elem : m)
+      elem.second += 1;
+    CHECK(m.at(3) == 31);
+
+    utl::flat_map<int, int>::const_iterator cit = m.begin();
+    CHECK(cit == m.cbegin());
+    CHECK(m.end() - m.begin() == 3);
+    CHECK(m.rbegin()->first == 3);
+    CHECK(m.begin()[2].second == 31);
+    CHECK(std::is_sorted(m.keys().begin(), m.keys().end()));
+  }
+
+  TEST_CASE("bulk construction and merge") {
+    utl::flat_map<int, char> m({{4, 'a'}, {2, 'b'}, {4, 'c'}, {8, 'd'}});
+    CHECK(m.keys() == utl::vector<int>{2, 4, 8});
+    CHECK(m.at(4) == 'a');
+
+    m.insert({{9, 'e'}, {1, 'f'}, {4, 'g'}, {5, 'h'}, {5, 'i'}});
+    CHECK(m.keys() == utl::vector<int>{1, 2, 4, 5, 8, 9});
+    CHECK(m.values() == utl::vector<char>{'f', 'b', 'a', 'h', 'd', 'e'});
+
+    // New keys past the end are appended.
+    m.insert(utl::sorted_unique, {{10, 'j'}, {11, 'k'}});
+    CHECK(m.size() == 8);
+    CHECK(m.at(11) == 'k');
+
+    const std::vector<std::pair<int, char>> more = {{0, 'l'}, {3, 'm'}};
+    m.insert_range(more);
+    CHECK(m.size() == 10);
+    CHECK(m.at(0) == 'l');
+
+    const utl::flat_map<int, char> from_containers(
+        utl::vector<int>{3, 1, 2, 1}, utl::vector<char>{'c', 'a', 'b', 'z'});
+    CHECK(from_containers.keys() == utl::vector<int>{1, 2, 3});
+    CHECK(from_containers.values() == utl::vector<char>{'a', 'b', 'c'});
+
+    const utl::flat_map<int, char> sorted(utl::sorted_unique,
+                                          utl::vector<int>{1, 2, 3},
+                                          utl::vector<char>{'a', 'b', 'c'});
+    CHECK(sorted == from_containers);
+    CHECK(sorted != m);
+  }
+
+  TEST_CASE("matches std::map") {
+    std::mt19937 rng(5);
+    utl::flat_map<unsigned, unsigned> m;
+    std::map<unsigned, unsigned> ref;
+    for (int round = 0; round != 50; ++round) {
+      std::vector<std::pair<unsigned, unsigned>> batch(
+          static_cast<std::size_t>(rng() % 200));
+      for (auto &x : batch)
+        x = {rng() % 5000, rng()};
+      m.insert(batch.begin(), batch.end());
+      ref.insert(batch.begin(), batch.end());
+      for (int i = 0; i != 20; ++i) {
+        const unsigned key = rng() % 5000;
+        CHECK(m.erase(key) == ref.erase(key));
+      }
+    }
+    REQUIRE(m.size() == ref.size());
+    CHECK(std::equal(m.begin(), m.end(), ref.begin(),
+                     [](auto x, const auto &y) {
+                       return x.first == y.first && x.second == y.second;
+                     }));
+  }
+
+  TEST_CASE("transparent lookup, erase_if and extract") {
+    utl::flat_map<std::string, int, std::less<>> m{
+        {"pear", 1}, {"apple", 2}, {"fig", 3}};
+    CHECK(m.contains("fig"));
+    CHECK(m.find("apple")->second == 2);
+    CHECK(m.count("kiwi") == 0);
+
+    CHECK(utl::erase_if(m, [](auto elem) { return elem.second > 1; }) == 2);
+    CHECK(m.keys() == utl::vector<std::string>{"pear"});
+
+    auto conts = std::move(m).extract();
+    CHECK(m.empty());
+    conts.keys.push_back("plum");
+    conts.values.push_back(4);
+    m.replace(std::move(conts.keys), std::move(conts.values));
+    CHECK(m.at("plum") == 4);
+  }
+
+  TEST_CASE("size_type follows the key container") {
+    using map = utl::flat_map<int, int, std::less<int>,
+                              utl::compact_vector<int>, utl::vector<int>>;
+    CHECK(std::is_same_v<map::size_type, std::uint32_t>);
+    map m{{3, 30}, {1, 10}};
+    m.emplace(2, 20);
+    CHECK(m.size() == 3u);
+    CHECK(m.max_size() <= UINT32_MAX);
+    CHECK(utl::erase_if(m, [](auto elem) { return elem.first > 1; }) == 2u);
+    CHECK(m.at(1) == 10);
+  }
+
+  TEST_CASE("failed bulk insertion leaves the map unchanged") {
+    using map = utl::flat_map<int, int, std::less<int>,
+                              utl::vector<int, SmallAllocator<int>>>;
+    std::vector<std::pair<int, int>> elems;
+    for (int i = 0; i != 40; ++i)
+      elems.emplace_back(2 * i, i);
+    map m(elems.begin(), elems.end());
+    REQUIRE(m.size() == 40);
+
+    std::vector<std::pair<int, int>> between, after;
+    for (int i = 0; i != 40; ++i) {
+      between.emplace_back(2 * i + 1, i);
+      after.emplace_back(100 + i, i);
+    }
+    CHECK_THROWS_AS(m.insert(between.begin(), between.end()), std::bad_alloc);
+    CHECK(m.size() == 40);
+    CHECK_THROWS_AS(m.insert(after.begin(), after.end()), std::bad_alloc);
+    CHECK(m.size() == 40);
+    CHECK(m.at(78) == 39);
+
+    utl::flat_map<int, Fragile> f;
+    for (int i = 0; i != 4; ++i)
+      f.try_emplace(i, i);
+    const std::pair<int, Fragile> tail[] = {{10, Fragile(1)}, {11, Fragile(2)}};
+    f.insert(std::begin(tail), std::end(tail));
+    const Fragile negative(-1);
+    const std::pair<int, Fragile> bad[] = {{20, Fragile(1)}, {21, negative}};
+    CHECK_THROWS_AS(
+        f.insert(utl::sorted_unique, std::begin(bad), std::end(bad)),
+        std::runtime_error);
+    CHECK(f.size() == 6);
+    CHECK(f.keys().size() == f.values().size());
+    CHECK(f.at(11).value == 2);
+  }
+
+  TEST_CASE("erase_if keeps the map when the predicate throws") {
+    utl::flat_map<int, std::string> m;
+    for (int i = 0; i != 10; ++i)
+      m.emplace(i, std::to_string(i));
+    CHECK_THROWS_AS(utl::erase_if(m,
+                                  [](auto elem) {
+                                    if (elem.first == 5)
+                                      throw std::runtime_error("pred");
+                                    return elem.first % 2 == 0;
+                                  }),
+                    std::runtime_error);
+    CHECK(m.keys() == utl::vector<int>{1, 3, 5, 6, 7, 8, 9});
+    CHECK(m.at(6) == "6");
+    CHECK(m.values().size() == 7);
+  }
+
+  TEST_CASE("failed value insertion removes the key") {
+    utl::flat_map<int, ThrowOnCopy> m;
+    m.try_emplace(1);
+    const ThrowOnCopy value;
+    CHECK_THROWS_AS(m.try_emplace(0, value), std::runtime_error);
+    CHECK(m.size() == 1);
+    CHECK(m.keys().size() == m.values().size());
+    CHECK(m.contains(1));
+  }
+}
@@ -0,0 +1,138 @@
+#include "doctest.h"
+
+#include <utl/flat_set.hpp>
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+TEST_SUITE("flat_set") {
+  TEST_CASE("branchless bounds agree with std") {
+    std::mt19937 rng(3);
+    for (int n = 0; n != 40; ++n) {
+      std::vector<int> v(static_cast<std::size_t>(n));
+      for (auto &x : v)
+        x = static_cast<int>(rng() % 20);
+      std::sort(v.begin(), v.end());
+      for (int key = -1; key != 21; ++key) {
+        CHECK(utl::lower_bound(v.begin(), v.end(), key, std::less<>()) ==
+              std::lower_bound(v.begin(), v.end(), key));
+        CHECK(utl::upper_bound(v.begin(), v.end(), key, std::less<>()) ==
+              std::upper_bound(v.begin(), v.end(), key));
+      }
+    }
+  }
+
+  TEST_CASE("insert and lookup") {
+    utl::flat_set<int> s;
+    CHECK(s.empty());
+    CHECK(s.insert(5).second);
+    CHECK(s.insert(1).second);
+    CHECK(s.insert(9).second);
+    CHECK_FALSE(s.insert(5).second);
+    CHECK(*s.emplace(3).first == 3);
+    CHECK(s.size() == 4);
+    CHECK(std::is_sorted(s.begin(), s.end()));
+
+    CHECK(s.contains(9));
+    CHECK_FALSE(s.contains(4));
+    CHECK(s.count(1) == 1);
+    CHECK(s.find(4) == s.end());
+    CHECK(*s.lower_bound(4) == 5);
+    CHECK(*s.upper_bound(5) == 9);
+    const auto range = s.equal_range(3);
+    CHECK(range.second - range.first == 1);
+
+    CHECK(s.erase(3) == 1);
+    CHECK(s.erase(3) == 0);
+    s.erase(s.begin());
+    CHECK(*s.begin() == 5);
+
+    // Hints are used when right and ignored when wrong.
+    const auto it = s.insert(s.end(), 20);
+    CHECK(*it == 20);
+    CHECK(*s.insert(s.end(), 7) == 7);
+    CHECK(*s.emplace_hint(s.begin(), 6) == 6);
+    CHECK(s.keys() == utl::vector<int>{5, 6, 7, 9, 20});
+  }
+
+  TEST_CASE("bulk construction and merge") {
+    utl::flat_set<int> s({4, 2, 4, 8, 6, 2});
+    CHECK(s.keys() == utl::vector<int>{2, 4, 6, 8});
+
+    s.insert({9, 1, 4, 5, 5});
+    CHECK(s.keys() == utl::vector<int>{1, 2, 4, 5, 6, 8, 9});
+
+    s.insert(utl::sorted_unique, {10, 11, 12});
+    CHECK(s.size() == 10);
+    CHECK(s.keys().back() == 12);
+
+    const std::vector<int> more = {0, 3, 7, 12, 13};
+    s.insert_range(more);
+    CHECK(s.size() == 14);
+    CHECK(std::is_sorted(s.begin(), s.end()));
+    CHECK(std::adjacent_find(s.begin(), s.end()) == s.end());
+
+    const utl::flat_set<int> sorted(utl::sorted_unique,
+                                    utl::vector<int>{1, 2, 3});
+    CHECK(sorted.size() == 3);
+    utl::flat_set<int> same{3, 2, 1, 1};
+    CHECK(same == sorted);
+    same.insert(0);
+    CHECK(same != sorted);
+    CHECK(same < sorted);
+  }
+
+  TEST_CASE("merge keeps the existing or first equivalent key") {
+    const auto by_length = [](const std::string &x, const std::string &y) {
+      return x.size() < y.size();
+    };
+    utl::flat_set<std::string, decltype(by_length)> s(by_length);
+    s.insert("bb");
+    s.insert({"a", "xx", "ccc", "z"});
+    CHECK(s.size() == 3);
+    CHECK(*s.begin() == "a");
+    CHECK(*std::next(s.begin()) == "bb");
+  }
+
+  TEST_CASE("matches std::set") {
+    std::mt19937 rng(11);
+    utl::flat_set<unsigned> s;
+    std::set<unsigned> ref;
+    for (int round = 0; round != 50; ++round) {
+      std::vector<unsigned> batch(static_cast<std::size_t>(rng() % 200));
+      for (auto &x : batch)
+        x = rng() % 5000;
+      s.insert(batch.begin(), batch.end());
+      ref.insert(batch.begin(), batch.end());
+      for (int i = 0; i != 20; ++i) {
+        const unsigned key = rng() % 5000;
+        CHECK(s.erase(key) == ref.erase(key));
+      }
+    }
+    CHECK(std::equal(s.begin(), s.end(), ref.begin(), ref.end()));
+  }
+
+  TEST_CASE("transparent lookup and erase_if") {
+    utl::flat_set<std::string, std::less<>> s{"pear", "apple", "fig"};
+    CHECK(s.contains("fig"));
+    CHECK(s.find("kiwi") == s.end());
+    CHECK(s.count("apple") == 1);
+
+    CHECK(utl::erase_if(s, [](const std::string &x) {
+            return x.size() > 3;
+          }) == 2);
+    CHECK(s.keys() == utl::vector<std::string>{"fig"});
+
+    auto keys = std::move(s).extract();
+    CHECK(s.empty());
+    CHECK(keys.size() == 1);
+    keys.push_back("grape");
+    s.replace(std::move(keys));
+    CHECK(s.size() == 2);
+  }
+}
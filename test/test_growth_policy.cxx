@@ -0,0 +1,71 @@
+#include "doctest.h"
+
+#include <utl/growth_policy.hpp>
+#include <utl/small_vector.hpp>
+#include <utl/vector.hpp>
+
+#include <cstdint>
+
+static_assert(utl::doubling_growth::grow(0, 1, 4) == 1);
+static_assert(utl::doubling_growth::grow(8, 9, 4) == 16);
+static_assert(utl::doubling_growth::grow(8, 100, 4) == 100);
+static_assert(utl::half_growth::grow(1, 2, 4) == 2);
+static_assert(utl::half_growth::grow(4, 5, 4) == 6);
+static_assert(utl::half_growth::grow(5, 6, 4) == 7);
+static_assert(utl::doubling_growth::grow(SIZE_MAX / 2 + 1, SIZE_MAX / 2 + 2,
+                                         1) == SIZE_MAX / 2 + 2);
+
+TEST_SUITE("growth_policy") {
+  TEST_CASE("size_class_growth fills whole size classes") {
+    using policy = utl::size_class_growth<>;
+    // 3 * 2 * 12 = 72 bytes rounds up to the 128 byte class.
+    CHECK(policy::grow(3, 4, 12) == 10);
+    CHECK(policy::grow(0, 1, 8) == 2);
+    // Past a page the buffer becomes a whole number of pages.
+    CHECK(policy::grow(1000, 1001, 24) * 24 % 4096 == 0);
+    CHECK(policy::grow(1000, 1001, 24) >= 2000);
+  }
+
+  TEST_CASE("linear_growth switches to fixed steps") {
+    using policy = utl::linear_growth<1024, 256>;
+    CHECK(policy::grow(16, 17, 8) == 32);
+    // Doubling stops at the threshold.
+    CHECK(policy::grow(100, 101, 8) == 128);
+    CHECK(policy::grow(128, 129, 8) == 160);
+    CHECK(policy::grow(160, 161, 8) == 192);
+    CHECK(policy::grow(160, 500, 8) == 500);
+  }
+
+  TEST_CASE("vector grows through its policy") {
+    utl::vector<std::uint64_t, utl::allocator<std::uint64_t>,
+                utl::half_growth>
+        v;
+    std::size_t last = 0;
+    int reallocations = 0;
+    for (std::uint64_t i = 0; i != 1000; ++i) {
+      v.push_back(i);
+      if (v.capacity() != last) {
+        CHECK(v.capacity() <= utl::max(last + last / 2, v.size()) + 16);
+        last = v.capacity();
+        ++reallocations;
+      }
+    }
+    CHECK(reallocations > 10);
+    v.insert(v.begin(), 1000, std::uint64_t{0});
+    CHECK(v.size() == 2000);
+    CHECK(v[1000] == 0);
+    CHECK(v[1999] == 999);
+
+    utl::vector<std::uint64_t, utl::allocator<std::uint64_t>,
+                utl::half_growth>
+        w(v.begin(), v.end());
+    CHECK(v == w);
+    swap(v, w);
+  }
+
+  TEST_CASE("small_vector keeps the default policy") {
+    utl::small_vector<int, 2> v{1, 2};
+    v.push_back(3);
+    CHECK(v.capacity() >= 3);
+  }
+}
@@ -0,0 +1,46 @@
+#include "doctest.h"
+
+#include <utl/hugepage_allocator.hpp>
+#include <utl/vector.hpp>
+
+#include <cstdint>
+
+TEST_SUITE("hugepage_allocator") {
+  TEST_CASE("small requests use the regular heap") {
+    utl::hugepage_allocator<int> alloc;
+    auto p = alloc.allocate(100);
+    p[99] = 1;
+    alloc.deallocate(p, 100);
+
+    auto result = alloc.allocate_at_least(100);
+    CHECK(result.count >= 100);
+    CHECK(result.count * sizeof(int) < alloc.threshold);
+    alloc.deallocate(result.ptr, result.count);
+  }
+
+  TEST_CASE("large requests are huge page aligned") {
+    utl::hugepage_allocator<std::uint64_t> alloc;
+    const size_t n = (size_t(5) << 20) / sizeof(std::uint64_t);
+    auto result = alloc.allocate_at_least(n);
+#if UTL_HAS_MMAP
+    CHECK(reinterpret_cast<std::uintptr_t>(result.ptr) %
+              utl::detail::huge_page_size ==
+          0);
+    CHECK(result.count * sizeof(std::uint64_t) ==
+          3 * utl::detail::huge_page_size);
+#endif
+    result.ptr[0] = 1;
+    result.ptr[result.count - 1] = 2;
+    alloc.deallocate(result.ptr, result.count);
+  }
+
+  TEST_CASE("vector with hugepage_allocator") {
+    utl::vector<std::uint64_t, utl::hugepage_allocator<std::uint64_t>> v;
+    for (std::uint64_t i = 0; i != 1000000; ++i)
+      v.push_back(i);
+    CHECK(v[999999] == 999999);
+    v.shrink_to_fit();
+    CHECK(v.capacity() == v.size());
+    CHECK(v[123456] == 123456);
+  }
+}
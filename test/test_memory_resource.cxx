@@ -0,0 +1,156 @@
+#include "doctest.h"
+
+#include <utl/memory_resource.hpp>
+#include <utl/string.hpp>
+#include <utl/vector.hpp>
+
+#include <cstdint>
+
+namespace {
+
+// Counts the bytes outstanding in an upstream resource.
+class tracking_resource : public utl::pmr::memory_resource {
+public:
+  size_t live = 0;
+  size_t calls = 0;
+
+private:
+  void *do_allocate(size_t bytes, size_t align) override {
+    live += bytes;
+    ++calls;
+    return utl::pmr::new_delete_resource()->allocate(bytes, align);
+  }
+
+  void do_deallocate(void *p, size_t bytes, size_t align) noexcept override {
+    live -= bytes;
+    utl::pmr::new_delete_resource()->deallocate(p, bytes, align);
+  }
+
+  bool do_is_equal(const memory_resource &other) const noexcept override {
+    return this == &other;
+  }
+};
+
+bool aligned(const void *p, size_t align) {
+  return reinterpret_cast<std::uintptr_t>(p) % align == 0;
+}
+
+} // namespace
+
+TEST_SUITE("memory_resource") {
+  TEST_CASE("default resource") {
+    using namespace utl::pmr;
+    CHECK(get_default_resource() == new_delete_resource());
+
+    tracking_resource tracking;
+    CHECK(set_default_resource(&tracking) == new_delete_resource());
+    {
+      utl::pmr::vector<int> v{1, 2, 3};
+      CHECK(v.get_allocator().resource() == &tracking);
+      CHECK(tracking.live >= 3 * sizeof(int));
+    }
+    CHECK(tracking.live == 0);
+    CHECK(set_default_resource(nullptr) == &tracking);
+    CHECK(get_default_resource() == new_delete_resource());
+  }
+
+  TEST_CASE("null resource throws") {
+    utl::pmr::polymorphic_allocator<int> alloc(
+        utl::pmr::null_memory_resource());
+    CHECK_THROWS_AS(alloc.allocate(1), std::bad_alloc);
+  }
+
+  TEST_CASE("monotonic_buffer_resource") {
+    utl::pmr::monotonic_buffer_resource resource(1024);
+    utl::pmr::vector<std::uint64_t> v(&resource);
+    for (std::uint64_t i = 0; i != 10000; ++i)
+      v.push_back(i);
+    CHECK(v[9999] == 9999);
+    CHECK(resource.buffer().bytes_reserved() >= 10000 * sizeof(std::uint64_t));
+
+    const auto p = resource.allocate(1, 64);
+    CHECK(aligned(p, 64));
+  }
+
+  TEST_CASE("unsynchronized_pool_resource reuses blocks") {
+    tracking_resource upstream;
+    utl::pmr::unsynchronized_pool_resource pool(&upstream);
+
+    const auto a = pool.allocate(24);
+    CHECK(aligned(a, alignof(std::max_align_t)));
+    pool.deallocate(a, 24);
+    CHECK(pool.allocate(32) == a);
+
+    const size_t slabs = upstream.live;
+    const auto large = pool.allocate(100000, 64);
+    CHECK(aligned(large, 64));
+    CHECK(upstream.live >= slabs + 100000);
+    pool.deallocate(large, 100000, 64);
+    CHECK(upstream.live == slabs);
+
+    pool.allocate(200000);
+    pool.allocate(300000, 32);
+    pool.release();
+    CHECK(upstream.live == 0);
+  }
+
+  TEST_CASE("pooled blocks come from upstream") {
+    tracking_resource upstream;
+    {
+      utl::pmr::unsynchronized_pool_resource pool(&upstream);
+      pool.allocate(8);
+      pool.allocate(512);
+      CHECK(upstream.calls == 2);
+      CHECK(upstream.live >= 2 * utl::detail::fixed_pool::slab_size);
+      pool.release();
+      CHECK(upstream.live == 0);
+      pool.allocate(8);
+      CHECK(upstream.calls == 3);
+    }
+    CHECK(upstream.live == 0);
+
+    utl::pmr::synchronized_pool_resource pool(
+        utl::pmr::null_memory_resource());
+    CHECK_THROWS_AS(pool.allocate(16), std::bad_alloc);
+    CHECK_THROWS_AS(pool.allocate(16), std::bad_alloc);
+  }
+
+  TEST_CASE("pool_options") {
+    utl::pmr::pool_options options;
+    options.largest_required_pool_block = 100;
+    utl::pmr::unsynchronized_pool_resource pool(options);
+    CHECK(pool.options().largest_required_pool_block == 128);
+  }
+
+  TEST_CASE("synchronized_pool_resource") {
+    utl::pmr::synchronized_pool_resource pool;
+    utl::pmr::vector<utl::pmr::vector<int>> outer(&pool);
+    for (int i = 0; i != 100; ++i) {
+      outer.emplace_back();
+      outer.back().push_back(i);
+    }
+    CHECK(outer[42].get_allocator().resource() == &pool);
+    CHECK(outer[42][0] == 42);
+  }
+
+  TEST_CASE("pmr::string") {
+    utl::pmr::monotonic_buffer_resource resource;
+    utl::pmr::string s(100, 'x', &resource);
+    CHECK(s.get_allocator().resource() == &resource);
+    CHECK(s.size() == 100);
+    CHECK(resource.buffer().bytes_reserved() != 0);
+
+    utl::pmr::string copy(s);
+    CHECK(copy.get_allocator().resource() == utl::pmr::get_default_resource());
+  }
+
+  TEST_CASE("vectors with different resources") {
+    utl::pmr::unsynchronized_pool_resource a, b;
+    utl::pmr::vector<int> x({1, 2, 3}, &a);
+    utl::pmr::vector<int> y(&b);
+    y = std::move(x);
+    CHECK(y.get_allocator().resource() == &b);
+    CHECK(y.size() == 3);
+    CHECK(y[2] == 3);
+  }
+}
@@ -0,0 +1,151 @@
+#include "doctest.h"
+
+#include <utl/mmap_vector.hpp>
+
+#include <cstdint>
+#include <filesystem>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+
+#if UTL_HAS_MMAP
+
+namespace {
+
+struct temp_file {
+  temp_file()
+      : path((std::filesystem::temp_directory_path() /
+              ("utl_mmap_vector_" +
+               std::to_string(reinterpret_cast<std::uintptr_t>(this))))
+                 .string()) {
+    std::filesystem::remove(path);
+  }
+  ~temp_file() { std::filesystem::remove(path); }
+
+  std::string path;
+};
+
+struct point {
+  double x, y;
+};
+
+} // namespace
+
+TEST_CASE("mmap_vector default constructed") {
+  utl::mmap_vector<int> v;
+  REQUIRE(!v.is_open());
+  REQUIRE(v.empty());
+  REQUIRE(v.capacity() == 0);
+  REQUIRE(v.begin() == v.end());
+}
+
+TEST_CASE("mmap_vector push_back and reopen") {
+  temp_file file;
+  {
+    utl::mmap_vector<std::uint64_t> v(file.path);
+    REQUIRE(v.is_open());
+    REQUIRE(!v.read_only());
+    REQUIRE(v.empty());
+    for (std::uint64_t i = 0; i != 10000; ++i)
+      v.push_back(i);
+    REQUIRE(v.size() == 10000);
+    REQUIRE(v.capacity() >= 10000);
+    REQUIRE(v.front() == 0);
+    REQUIRE(v.back() == 9999);
+    v.flush();
+  }
+  {
+    utl::mmap_vector<std::uint64_t> v(file.path, utl::mmap_mode::read_only);
+    REQUIRE(v.read_only());
+    REQUIRE(v.size() == 10000);
+    REQUIRE(std::accumulate(v.begin(), v.end(), std::uint64_t{0}) ==
+            9999u * 10000u / 2);
+    REQUIRE(v.at(1234) == 1234);
+    REQUIRE_THROWS_AS(v.at(10000), std::out_of_range);
+    REQUIRE_THROWS_AS(v.reserve(20000), std::logic_error);
+    REQUIRE_THROWS_AS(v.clear(), std::logic_error);
+    REQUIRE(v.size() == 10000);
+  }
+  {
+    utl::mmap_vector<std::uint64_t> v(file.path);
+    REQUIRE(v.size() == 10000);
+    v.push_back(10000);
+    v.pop_back();
+    v.resize(5);
+    REQUIRE(v.size() == 5);
+  }
+  {
+    utl::mmap_vector<std::uint64_t> v(file.path, utl::mmap_mode::truncate);
+    REQUIRE(v.empty());
+  }
+}
+
+TEST_CASE("mmap_vector modifiers") {
+  temp_file file;
+  utl::mmap_vector<point> v(file.path);
+  for (int i = 0; i != 10; ++i)
+    v.emplace_back(point{double(i), double(-i)});
+  REQUIRE(v.size() == 10);
+  REQUIRE(v[3].x == 3);
+
+  auto it = v.erase(v.begin() + 2, v.begin() + 4);
+  REQUIRE(it->x == 4);
+  REQUIRE(v.size() == 8);
+  it = v.erase(v.begin());
+  REQUIRE(it->x == 1);
+
+  const point extra[] = {{100, 100}, {200, 200}};
+  v.append(std::begin(extra), std::end(extra));
+  REQUIRE(v.size() == 9);
+  REQUIRE(v.back().x == 200);
+
+  // The argument lives in the mapping, which moves when it grows.
+  v.shrink_to_fit();
+  const auto cap = v.capacity();
+  v.resize(cap);
+  v.push_back(v[0]);
+  REQUIRE(v.back().x == 1);
+
+  v.resize(cap + 100, v[0]);
+  REQUIRE(v.back().y == -1);
+  REQUIRE(v.capacity() > cap);
+
+  v.clear();
+  REQUIRE(v.empty());
+  v.shrink_to_fit();
+  REQUIRE(v.capacity() == cap);
+}
+
+TEST_CASE("mmap_vector move and swap") {
+  temp_file a, b;
+  utl::mmap_vector<int> x(a.path), y(b.path);
+  x.push_back(1);
+  y.push_back(2);
+  y.push_back(3);
+  swap(x, y);
+  REQUIRE(x.size() == 2);
+  REQUIRE(y.size() == 1);
+
+  utl::mmap_vector<int> z(std::move(x));
+  REQUIRE(!x.is_open());
+  REQUIRE(z.size() == 2);
+  z = std::move(y);
+  REQUIRE(z.size() == 1);
+  REQUIRE(!y.is_open());
+}
+
+TEST_CASE("mmap_vector rejects mismatched files") {
+  temp_file file;
+  {
+    utl::mmap_vector<std::uint32_t> v(file.path);
+    v.push_back(1);
+  }
+  REQUIRE_THROWS_AS(utl::mmap_vector<std::uint64_t>(file.path),
+                    std::runtime_error);
+  REQUIRE_THROWS_AS(utl::mmap_vector<int>("/nonexistent/dir/file",
+                                          utl::mmap_mode::read_only),
+                    std::system_error);
+}
+
+#endif
@@ -0,0 +1,146 @@
+#include "doctest.h"
+
+#include <utl/counting_allocator.hpp>
+#include <utl/persistent_vector.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+TEST_SUITE("persistent_vector") {
+  TEST_CASE("push_back returns new versions") {
+    utl::persistent_vector<int> empty;
+    const auto one = empty.push_back(1);
+    const auto two = one.push_back(2);
+    CHECK(empty.empty());
+    CHECK(one.size() == 1);
+    CHECK(two.size() == 2);
+    CHECK(two[0] == 1);
+    CHECK(two.back() == 2);
+    CHECK_THROWS_AS(two.at(2), std::out_of_range);
+  }
+
+  TEST_CASE("large vectors keep every version") {
+    // Crosses the tail, one-level and two-level trie boundaries.
+    std::vector<utl::persistent_vector<std::size_t>> versions(1);
+    const std::size_t count = 40000;
+    for (std::size_t i = 0; i != count; ++i)
+      versions.push_back(versions.back().push_back(i));
+
+    bool ok = true;
+    for (std::size_t n : {0u, 1u, 31u, 32u, 33u, 1024u, 1056u, 1057u, 33825u,
+                          39999u, 40000u}) {
+      const auto &v = versions[n];
+      ok = ok && v.size() == n;
+      for (std::size_t i = 0; i != n; ++i)
+        ok = ok && v[i] == i;
+    }
+    CHECK(ok);
+
+    const auto &all = versions.back();
+    std::vector<std::size_t> expected(count);
+    std::iota(expected.begin(), expected.end(), 0);
+    CHECK(std::equal(all.begin(), all.end(), expected.begin(), expected.end()));
+    CHECK(all.end() - all.begin() == count);
+    CHECK(*(all.begin() + 12345) == 12345);
+    CHECK(all.begin()[33000] == 33000);
+    CHECK(*all.rbegin() == count - 1);
+  }
+
+  TEST_CASE("set and pop_back share structure") {
+    utl::persistent_vector<std::string> v;
+    for (int i = 0; i != 2000; ++i)
+      v = std::move(v).push_back(std::to_string(i));
+
+    const auto changed = v.set(5, "five").set(1500, "x");
+    CHECK(v[5] == "5");
+    CHECK(v[1500] == "1500");
+    CHECK(changed[5] == "five");
+    CHECK(changed[1500] == "x");
+    CHECK(changed[6] == "6");
+    CHECK(changed != v);
+
+    auto shrunk = v;
+    CHECK(shrunk.identical(v));
+    bool ok = true;
+    while (!shrunk.empty()) {
+      shrunk = shrunk.pop_back();
+      ok = ok && (shrunk.empty() || shrunk.back() ==
+                                        std::to_string(shrunk.size() - 1));
+    }
+    CHECK(ok);
+    CHECK(v.size() == 2000);
+    CHECK(v.back() == "1999");
+  }
+
+  TEST_CASE("transient builds in place") {
+    auto &site = UTL_ALLOCATION_SITE("test/persistent_vector");
+    using alloc = utl::counting_allocator<int>;
+    const auto live = site.stats().live_bytes;
+    {
+      utl::transient_vector<int, alloc> t{alloc(site)};
+      for (int i = 0; i != 5000; ++i)
+        t.push_back(i);
+      const auto built = site.stats().allocations;
+      for (int i = 0; i != 5000; ++i)
+        t.set(i, t[i] * 2);
+      // Nothing is shared, so updates never copy.
+      CHECK(site.stats().allocations == built);
+
+      const auto snapshot = t.persistent();
+      t.set(0, -1);
+      t.pop_back();
+      t.emplace_back(7);
+      CHECK(snapshot[0] == 0);
+      CHECK(snapshot.back() == 9998);
+      CHECK(t[0] == -1);
+      CHECK(t.back() == 7);
+
+      auto again = snapshot.transient();
+      for (int i = 0; i != 5000; ++i)
+        again.mutable_at(i) += 1;
+      CHECK(again[4999] == 9999);
+      CHECK(snapshot[4999] == 9998);
+
+      const auto moved = std::move(again).persistent();
+      CHECK(moved.size() == 5000);
+      CHECK(again.empty());
+    }
+    CHECK(site.stats().live_bytes == live);
+  }
+
+  TEST_CASE("equality") {
+    const utl::persistent_vector<int> a{1, 2, 3};
+    const utl::persistent_vector<int> b{1, 2, 3};
+    CHECK(a == b);
+    CHECK(!a.identical(b));
+    CHECK(a != a.push_back(4));
+    CHECK(a.set(1, 2) == a);
+  }
+
+  TEST_CASE("snapshots are safe to read from other threads") {
+    utl::persistent_vector<int> v;
+    for (int i = 0; i != 10000; ++i)
+      v = std::move(v).push_back(0);
+
+    std::atomic<bool> bad{false};
+    std::vector<std::thread> readers;
+    for (int r = 0; r != 4; ++r) {
+      readers.emplace_back([snapshot = v, &bad] {
+        for (int round = 0; round != 20; ++round)
+          if (std::accumulate(snapshot.begin(), snapshot.end(), 0) != 0)
+            bad = true;
+      });
+    }
+    for (int i = 0; i != 10000; ++i)
+      v = std::move(v).set(i, 1);
+    for (auto &t : readers)
+      t.join();
+    CHECK(!bad);
+    CHECK(std::accumulate(v.begin(), v.end(), 0) == 10000);
+  }
+}
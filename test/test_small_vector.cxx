@@ -0,0 +1,186 @@
+#include "doctest.h"
+
+#include <utl/counting_allocator.hpp>
+#include <utl/small_vector.hpp>
+
+#include <memory>
+#include <new>
+#include <string>
+#include <type_traits>
+
+namespace {
+
+// Allocators with different ids are unequal; allocation throws once
+// `fail` is set.
+template <typename T, bool Propagate> struct StatefulAllocator {
+  using value_type = T;
+  using propagate_on_container_move_assignment =
+      std::bool_constant<Propagate>;
+  using is_always_equal = std::false_type;
+
+  explicit StatefulAllocator(int id) noexcept : id(id) {}
+  template <typename U>
+  StatefulAllocator(const StatefulAllocator<U, Propagate> &other) noexcept
+      : id(other.id) {}
+
+  T *allocate(size_t n) {
+    if (fail)
+      throw std::bad_alloc();
+    return std::allocator<T>().allocate(n);
+  }
+  void deallocate(T *p, size_t n) noexcept {
+    std::allocator<T>().deallocate(p, n);
+  }
+
+  friend bool operator==(const StatefulAllocator &lhs,
+                         const StatefulAllocator &rhs) noexcept {
+    return lhs.id == rhs.id;
+  }
+  friend bool operator!=(const StatefulAllocator &lhs,
+                         const StatefulAllocator &rhs) noexcept {
+    return !(lhs == rhs);
+  }
+
+  static inline bool fail = false;
+  int id;
+};
+
+} // namespace
+
+TEST_SUITE("small_vector") {
+  TEST_CASE("stays inline up to N elements") {
+    auto &site = UTL_ALLOCATION_SITE("test/small_vector");
+    using alloc = utl::counting_allocator<int>;
+    const auto before = site.stats().allocations;
+
+    utl::small_vector<int, 4, alloc> v{alloc(site)};
+    for (int i = 0; i != 4; ++i)
+      v.push_back(i);
+    CHECK(v.is_inline());
+    CHECK(v.capacity() == 4);
+    CHECK(site.stats().allocations == before);
+
+    v.push_back(4);
+    CHECK(!v.is_inline());
+    CHECK(site.stats().allocations == before + 1);
+    CHECK(v[4] == 4);
+
+    v.resize(2);
+    v.shrink_to_fit();
+    CHECK(v.is_inline());
+    CHECK(v[1] == 1);
+    CHECK(site.stats().live_bytes == 0);
+  }
+
+  TEST_CASE("constructors") {
+    utl::small_vector<std::string, 2> a(3, "x");
+    CHECK(a.size() == 3);
+    CHECK(!a.is_inline());
+
+    utl::small_vector<std::string, 4> b{"a", "b"};
+    CHECK(b.is_inline());
+
+    const utl::small_vector<std::string, 4> c(b);
+    CHECK(c.is_inline());
+    CHECK(c.data() != b.data());
+    CHECK(c == b);
+
+    utl::small_vector<int, 8> d(5);
+    CHECK(d.size() == 5);
+    CHECK(d[4] == 0);
+  }
+
+  TEST_CASE("move") {
+    utl::small_vector<std::unique_ptr<int>, 2> inl;
+    inl.push_back(std::make_unique<int>(1));
+    utl::small_vector<std::unique_ptr<int>, 2> moved(std::move(inl));
+    CHECK(inl.empty());
+    CHECK(moved.is_inline());
+    CHECK(*moved[0] == 1);
+
+    utl::small_vector<std::unique_ptr<int>, 2> heap;
+    for (int i = 0; i != 5; ++i)
+      heap.push_back(std::make_unique<int>(i));
+    const auto data = heap.data();
+    utl::small_vector<std::unique_ptr<int>, 2> stolen(std::move(heap));
+    CHECK(stolen.data() == data);
+    CHECK(heap.empty());
+    CHECK(heap.is_inline());
+
+    moved = std::move(stolen);
+    CHECK(moved.data() == data);
+    CHECK(moved.size() == 5);
+
+    stolen.push_back(std::make_unique<int>(7));
+    moved = std::move(stolen);
+    CHECK(moved.size() == 1);
+    CHECK(moved.data() == data);
+    CHECK(*moved[0] == 7);
+    CHECK(std::is_nothrow_move_assignable_v<decltype(moved)>);
+  }
+
+  TEST_CASE("move assignment with unequal allocators") {
+    using fixed = StatefulAllocator<int, false>;
+    using vec = utl::small_vector<int, 2, fixed>;
+    CHECK(!std::is_nothrow_move_assignable_v<vec>);
+
+    vec a(fixed(1));
+    vec b({1, 2, 3, 4}, fixed(2));
+    a = std::move(b);
+    CHECK(a.size() == 4);
+    CHECK(a.inner_allocator().id == 1);
+
+    vec c({5, 6, 7}, fixed(3));
+    vec d(fixed(4));
+    fixed::fail = true;
+    CHECK_THROWS_AS(d = std::move(c), std::bad_alloc);
+    fixed::fail = false;
+    CHECK(d.empty());
+    CHECK(c.size() == 3);
+
+    using moving = StatefulAllocator<int, true>;
+    using pvec = utl::small_vector<int, 2, moving>;
+    CHECK(std::is_nothrow_move_assignable_v<pvec>);
+    pvec e({1, 2, 3}, moving(1));
+    pvec f({9, 9, 9, 9}, moving(2));
+    const auto data = f.data();
+    e = std::move(f);
+    CHECK(e.data() == data);
+    CHECK(e.inner_allocator().id == 2);
+    CHECK(e.size() == 4);
+
+    pvec g({7}, moving(3));
+    e = std::move(g);
+    CHECK(e.data() == data);
+    CHECK(e.inner_allocator().id == 2);
+    CHECK(e[0] == 7);
+  }
+
+  TEST_CASE("swap") {
+    utl::small_vector<int, 4> a{1, 2};
+    utl::small_vector<int, 4> b{3, 4, 5, 6, 7, 8};
+    swap(a, b);
+    CHECK(a.size() == 6);
+    CHECK(a[5] == 8);
+    CHECK(b.size() == 2);
+    CHECK(b[1] == 2);
+
+    utl::small_vector<int, 4> c{9, 9, 9, 9, 9};
+    const auto data = c.data();
+    a.swap(c);
+    CHECK(a.data() == data);
+    CHECK(c[0] == 3);
+  }
+
+  TEST_CASE("insert and erase") {
+    utl::small_vector<std::string, 3> v{"a", "c"};
+    v.insert(v.begin() + 1, "b");
+    CHECK(v.is_inline());
+    v.insert(v.end(), {"d", "e"});
+    CHECK(!v.is_inline());
+    v.erase(v.begin(), v.begin() + 2);
+    CHECK(v.size() == 3);
+    CHECK(v[0] == "c");
+    CHECK(v[2] == "e");
+  }
+}
@@ -0,0 +1,97 @@
+#include "doctest.h"
+
+#include <utl/counting_allocator.hpp>
+#include <utl/soa_vector.hpp>
+
+#include <numeric>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+struct ThrowOnCopy {
+  ThrowOnCopy() = default;
+  ThrowOnCopy(const ThrowOnCopy &) { throw std::runtime_error("copy"); }
+  ThrowOnCopy(ThrowOnCopy &&) noexcept = default;
+  ThrowOnCopy &operator=(const ThrowOnCopy &) = default;
+  ThrowOnCopy &operator=(ThrowOnCopy &&) noexcept = default;
+  bool operator==(const ThrowOnCopy &) const { return true; }
+};
+
+} // namespace
+
+TEST_SUITE("soa_vector") {
+  TEST_CASE("columns are contiguous") {
+    utl::soa_vector<int, double, std::string> v;
+    CHECK(v.empty());
+    for (int i = 0; i != 100; ++i)
+      v.emplace_back(i, i * 0.5, std::to_string(i));
+    v.push_back({100, 50.0, "100"});
+    CHECK(v.size() == 101);
+    CHECK(v.capacity() >= 101);
+
+    const auto ids = v.column<0>();
+    CHECK(ids.size() == 101);
+    CHECK(std::accumulate(ids.begin(), ids.end(), 0) == 5050);
+    for (auto &x : v.column<1>())
+      x *= 2;
+    CHECK(std::get<1>(v[10]) == 10.0);
+    CHECK(std::get<2>(v.back()) == "100");
+    CHECK_THROWS_AS(v.at(101), std::out_of_range);
+  }
+
+  TEST_CASE("rows are proxies") {
+    utl::soa_vector<int, std::string> v{{1, "a"}, {2, "b"}, {3, "c"}};
+    v[1] = std::make_tuple(20, "bb");
+    std::get<0>(v.front()) = 10;
+    const std::tuple<int, std::string> row = v[1];
+    CHECK(row == std::make_tuple(20, "bb"));
+    CHECK(std::get<0>(v[0]) == 10);
+
+    int sum = 0;
+    for (auto [id, name] : v)
+      sum += id + static_cast<int>(name.size());
+    CHECK(sum == 10 + 1 + 20 + 2 + 3 + 1);
+
+    const auto &cv = v;
+    CHECK(std::get<1>(*(cv.end() - 1)) == "c");
+    CHECK(std::get<1>(*v.rbegin()) == "c");
+
+    v.erase(v.begin());
+    CHECK(v.size() == 2);
+    CHECK(std::get<0>(v.front()) == 20);
+    CHECK(v.column<1>()[1] == "c");
+    v.pop_back();
+    CHECK(v.size() == 1);
+  }
+
+  TEST_CASE("failed append leaves the columns aligned") {
+    utl::soa_vector<int, ThrowOnCopy> v;
+    v.emplace_back(1, ThrowOnCopy());
+    const ThrowOnCopy t;
+    CHECK_THROWS_AS(v.emplace_back(2, t), std::runtime_error);
+    CHECK(v.size() == 1);
+    CHECK(v.column<0>().size() == 1);
+    CHECK(v.column<1>().size() == 1);
+  }
+
+  TEST_CASE("allocates every column through the allocator") {
+    auto &site = UTL_ALLOCATION_SITE("test/soa_vector");
+    using alloc = utl::counting_allocator<std::byte>;
+    const auto before = site.stats().allocations;
+    {
+      utl::basic_soa_vector<alloc, int, long> v{alloc(site)};
+      v.reserve(10);
+      CHECK(site.stats().allocations == before + 2);
+      v.resize(10);
+      CHECK(std::get<1>(v[9]) == 0);
+      auto w = v;
+      CHECK(w == v);
+      w.clear();
+      swap(v, w);
+      CHECK(v.empty());
+      CHECK(w.size() == 10);
+    }
+    CHECK(site.stats().live_bytes == 0);
+  }
+}
@@ -101,3 +101,16 @@ TEST_CASE("dynamic span") {
   auto wb = utl::as_writable_bytes(s4);
   CHECK(bytes.size() == wb.size());
 }
+
+TEST_CASE("span equality") {
+  int x[] = {1, 2, 3, 4};
+  const utl::vector<int> v{1, 2, 3, 4};
+  utl::span<int> a(x, 4);
+  utl::span<const int> b(v.data(), v.size());
+  CHECK(a == b);
+  CHECK(a.subspan(1) != b);
+  CHECK(a.subspan(1) == b.subspan(1));
+  x[3] = 5;
+  CHECK(a != b);
+  CHECK(utl::span<int>() == utl::span<const int>());
+}
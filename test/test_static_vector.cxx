@@ -0,0 +1,101 @@
+#include "doctest.h"
+
+#include <utl/static_vector.hpp>
+
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+constexpr int constexpr_sum() {
+  utl::static_vector<int, 8> v{1, 2, 3};
+  v.push_back(4);
+  v.emplace_back(5);
+  v.pop_back();
+  v.resize(6, 10);
+  int sum = 0;
+  for (auto it = v.begin(); it != v.end(); ++it)
+    sum += *it;
+  return sum;
+}
+
+static_assert(constexpr_sum() == 1 + 2 + 3 + 4 + 10 + 10);
+static_assert(utl::static_vector<int, 4>{1, 2} ==
+              utl::static_vector<int, 4>{1, 2});
+static_assert(std::is_trivially_copyable_v<utl::static_vector<int, 4>>);
+static_assert(std::is_trivially_copyable_v<utl::static_vector<int, 64>>);
+
+} // namespace
+
+TEST_SUITE("static_vector") {
+  TEST_CASE("stores elements inline") {
+    utl::static_vector<int, 4> v;
+    CHECK(v.empty());
+    CHECK(v.capacity() == 4);
+    for (int i = 0; i != 4; ++i)
+      v.push_back(i);
+    CHECK(v.full());
+    CHECK(reinterpret_cast<const char *>(v.data()) >=
+          reinterpret_cast<const char *>(&v));
+    CHECK(reinterpret_cast<const char *>(v.data() + v.size()) <=
+          reinterpret_cast<const char *>(&v + 1));
+    CHECK(v.back() == 3);
+  }
+
+  TEST_CASE("reports overflow") {
+    utl::static_vector<std::string, 2> v;
+    CHECK(v.try_push_back("a") != nullptr);
+    CHECK(*v.try_emplace_back(3, 'b') == "bbb");
+    CHECK(v.try_push_back("c") == nullptr);
+    CHECK(v.size() == 2);
+    CHECK_THROWS_AS(v.push_back("c"), std::bad_alloc);
+    CHECK_THROWS_AS(v.resize(3), std::bad_alloc);
+    CHECK_THROWS_AS(v.at(2), std::out_of_range);
+    CHECK(v[1] == "bbb");
+  }
+
+  TEST_CASE("insert and erase") {
+    utl::static_vector<std::string, 8> v{"a", "d"};
+    v.insert(v.begin() + 1, {"b", "c"});
+    v.emplace(v.end(), "e");
+    v.insert(v.begin(), 2, "z");
+    CHECK(v == utl::static_vector<std::string, 8>{"z", "z", "a", "b", "c",
+                                                  "d", "e"});
+    v.erase(v.begin(), v.begin() + 2);
+    v.erase(v.begin() + 1);
+    CHECK(v == utl::static_vector<std::string, 8>{"a", "c", "d", "e"});
+    CHECK_THROWS_AS(v.insert(v.begin(), 5, "x"), std::bad_alloc);
+    CHECK(v.size() == 4);
+
+    utl::static_vector<int, 8> ints{1, 2, 3, 4, 5};
+    ints.erase(ints.begin() + 1, ints.begin() + 3);
+    CHECK(ints == utl::static_vector<int, 8>{1, 4, 5});
+  }
+
+  TEST_CASE("copy, move and swap") {
+    utl::static_vector<std::unique_ptr<int>, 4> a;
+    a.push_back(std::make_unique<int>(1));
+    a.push_back(std::make_unique<int>(2));
+    auto b = std::move(a);
+    CHECK(b.size() == 2);
+    CHECK(*b[1] == 2);
+
+    utl::static_vector<std::unique_ptr<int>, 4> c;
+    c.push_back(std::make_unique<int>(3));
+    swap(b, c);
+    CHECK(b.size() == 1);
+    CHECK(*b[0] == 3);
+    CHECK(c.size() == 2);
+    CHECK(*c[0] == 1);
+
+    utl::static_vector<std::string, 4> s{"x", "y", "z"};
+    utl::static_vector<std::string, 4> t{"w"};
+    t = s;
+    CHECK(t == s);
+    s = {"q"};
+    CHECK(s.size() == 1);
+    CHECK(s < t);
+  }
+}
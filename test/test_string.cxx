@@ -19,3 +19,83 @@ TEST_SUITE("string") {
     }
   }
 }
+
+TEST_SUITE("string") {
+  TEST_CASE("copy and move") {
+    const utl::basic_string<char> small(5, 'a');
+    const utl::basic_string<char> large(100, 'b');
+    const utl::basic_string<wchar_t> wide(10, L'c');
+
+    utl::basic_string<char> s1(small);
+    CHECK(s1.size() == 5);
+    CHECK(s1[4] == 'a');
+    CHECK(s1[5] == '\0');
+
+    utl::basic_string<char> s2(large);
+    CHECK(s2.size() == 100);
+    CHECK(s2.data() != large.data());
+
+    utl::basic_string<wchar_t> s3(wide);
+    CHECK(s3.size() == 10);
+    CHECK(s3[9] == L'c');
+    CHECK(s3[10] == L'\0');
+
+    auto data = s2.data();
+    utl::basic_string<char> s4(std::move(s2));
+    CHECK(s4.data() == data);
+    CHECK(s2.size() == 0);
+    CHECK(s2[0] == '\0');
+
+    s1 = large;
+    CHECK(s1.size() == 100);
+    s4 = small;
+    CHECK(s4.size() == 5);
+    CHECK(s4[5] == '\0');
+    s2 = std::move(s1);
+    CHECK(s2.size() == 100);
+    CHECK(s2[99] == 'b');
+  }
+}
+
+TEST_SUITE("string") {
+  TEST_CASE("resize") {
+    utl::basic_string<char> s(3, 'a');
+    s.resize(5, 'b');
+    CHECK(s.size() == 5);
+    CHECK(s[2] == 'a');
+    CHECK(s[4] == 'b');
+    CHECK(s[5] == '\0');
+
+    s.resize(40, 'c');
+    CHECK(s.size() == 40);
+    CHECK(s[0] == 'a');
+    CHECK(s[39] == 'c');
+    CHECK(s.capacity() >= 40);
+
+    s.resize(2);
+    CHECK(s.size() == 2);
+    CHECK(s[2] == '\0');
+
+    s.reserve(1000);
+    CHECK(s.capacity() >= 1000);
+    CHECK(s[1] == 'a');
+  }
+
+  TEST_CASE("resize_and_overwrite") {
+    utl::basic_string<char> s(2, 'x');
+    s.resize_and_overwrite(100, [](char *p, size_t n) {
+      CHECK(p[1] == 'x');
+      for (size_t i = 2; i != n; ++i)
+        p[i] = 'y';
+      return size_t(50);
+    });
+    CHECK(s.size() == 50);
+    CHECK(s[0] == 'x');
+    CHECK(s[49] == 'y');
+    CHECK(s[50] == '\0');
+
+    s.resize_uninitialized(8);
+    CHECK(s.size() == 8);
+    CHECK(s[8] == '\0');
+  }
+}
@@ -0,0 +1,69 @@
+#include "doctest.h"
+
+#include <utl/thread_cache.hpp>
+#include <utl/vector.hpp>
+
+#include <cstdint>
+#include <thread>
+
+TEST_SUITE("thread_cache") {
+  using utl::detail::thread_cache;
+
+  TEST_CASE("size classes cover every request") {
+    size_t previous = 0;
+    for (size_t cls = 0; cls != thread_cache::class_count; ++cls) {
+      const auto size = thread_cache::class_size(cls);
+      CHECK(size > previous);
+      CHECK(thread_cache::size_class(size) == cls);
+      CHECK(thread_cache::size_class(previous + 1) == cls);
+      previous = size;
+    }
+    CHECK(previous == thread_cache::max_size);
+  }
+
+  TEST_CASE("blocks are aligned for their type") {
+    struct alignas(64) line {
+      char bytes[64];
+    };
+    utl::thread_cache_allocator<line> alloc;
+    for (size_t n = 1; n != 40; ++n) {
+      auto p = alloc.allocate(n);
+      CHECK(reinterpret_cast<std::uintptr_t>(p) % alignof(line) == 0);
+      alloc.deallocate(p, n);
+    }
+  }
+
+  TEST_CASE("vector with thread_cache_allocator") {
+    utl::vector<int, utl::thread_cache_allocator<int>> v;
+    for (int i = 0; i != 100000; ++i)
+      v.push_back(i);
+    CHECK(v.size() == 100000);
+    CHECK(v[4242] == 4242);
+
+    utl::vector<int, utl::thread_cache_allocator<int>> w(33u);
+    CHECK(w.capacity() * sizeof(int) == thread_cache::class_size(
+                                            thread_cache::size_class(132)));
+  }
+
+  TEST_CASE("blocks can be freed on another thread") {
+    utl::thread_cache_allocator<long> alloc;
+    utl::vector<long *> blocks;
+    std::thread producer([&] {
+      for (int i = 0; i != 10000; ++i) {
+        blocks.push_back(alloc.allocate(1));
+        *blocks.back() = i;
+      }
+    });
+    producer.join();
+
+    std::thread consumer([&] {
+      for (auto p : blocks)
+        alloc.deallocate(p, 1);
+    });
+    consumer.join();
+
+    auto p = alloc.allocate(1);
+    *p = 1;
+    alloc.deallocate(p, 1);
+  }
+}
@@ -1,9 +1,20 @@
 #include "doctest.h"
 
+#include <utl/any.hpp>
+#include <utl/string.hpp>
+#include <utl/unique_ptr.hpp>
 #include <utl/vector.hpp>
 
 #include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <numeric>
 #include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
 #include <string>
 
 TEST_SUITE("vector") {
@@ -74,6 +85,41 @@ TEST_SUITE("vector") {
                      std::crend(v)));
   }
 
+  TEST_CASE("resize value-initializes") {
+    utl::vector<int> v{1, 2, 3, 4, 5};
+    v.resize(1);
+    v.resize(5);
+    CHECK(v[0] == 1);
+    CHECK(std::all_of(v.begin() + 1, v.end(), [](int x) { return x == 0; }));
+  }
+
+  TEST_CASE("resize_uninitialized and resize_and_overwrite") {
+    utl::vector<char> buf;
+    buf.resize_uninitialized(1000);
+    CHECK(buf.size() == 1000);
+    buf[999] = 'x';
+
+    buf.resize_and_overwrite(64, [](char *p, size_t n) {
+      CHECK(n == 64);
+      for (size_t i = 0; i != 10; ++i)
+        p[i] = static_cast<char>('0' + i);
+      return size_t(10);
+    });
+    CHECK(buf.size() == 10);
+    CHECK(buf[9] == '9');
+
+    utl::vector<std::string> sv{"a"};
+    sv.resize_uninitialized(3);
+    CHECK(sv[0] == "a");
+    CHECK(sv[2].empty());
+    sv.resize_and_overwrite(5, [](std::string *p, size_t) {
+      p[1] = "b";
+      return size_t(2);
+    });
+    CHECK(sv.size() == 2);
+    CHECK(sv[1] == "b");
+  }
+
   TEST_CASE("capacity") {
     utl::vector<int> v{1, 2, 3, 4, 5};
     v.resize(1);
@@ -148,6 +194,26 @@ TEST_SUITE("vector") {
     CHECK(std::equal(v1.begin(), v1.end(), v3.begin(), v3.end()));
   }
 
+  TEST_CASE("relocating swap with nonequal allocators") {
+    using alloc = NonequalAllocator<utl::unique_ptr<int>>;
+    utl::vector<utl::unique_ptr<int>, alloc> a(alloc(1)), b(alloc(2));
+    for (int i = 0; i != 10; ++i)
+      a.push_back(utl::make_unique<int>(i));
+    b.push_back(utl::make_unique<int>(42));
+
+    a.swap(b);
+    REQUIRE(a.size() == 1);
+    REQUIRE(b.size() == 10);
+    CHECK(*a[0] == 42);
+    CHECK(*b[9] == 9);
+    CHECK(a.get_allocator().m_id == 1);
+
+    b.erase(b.begin() + 1, b.end());
+    a.swap(b);
+    CHECK(*a[0] == 0);
+    CHECK(*b[0] == 42);
+  }
+
   TEST_CASE("member access") {
     SUBCASE("vector front and back") {
       utl::vector<std::unique_ptr<int>> v;
@@ -243,3 +309,360 @@ TEST_SUITE("vector") {
     }
   }
 }
+
+namespace {
+
+// Counts moves and destructions so bitwise relocation can be observed.
+struct Relocatable {
+  static inline int moves = 0;
+  static inline int destroyed = 0;
+
+  explicit Relocatable(int v) : value(new int(v)) {}
+  Relocatable(Relocatable &&other) noexcept : value(other.value) {
+    other.value = nullptr;
+    ++moves;
+  }
+  Relocatable(const Relocatable &other) {
+    if (*other.value < 0)
+      UTL_THROW(std::runtime_error("Relocatable"));
+    value = new int(*other.value);
+  }
+  Relocatable &operator=(Relocatable &&other) noexcept {
+    std::swap(value, other.value);
+    ++moves;
+    return *this;
+  }
+  ~Relocatable() {
+    delete value;
+    ++destroyed;
+  }
+
+  int *value;
+};
+
+} // namespace
+
+template <> struct utl::is_trivially_relocatable<Relocatable> : std::true_type {};
+
+TEST_SUITE("vector") {
+  TEST_CASE("trivially relocatable trait") {
+    static_assert(utl::is_trivially_relocatable_v<int>);
+    static_assert(utl::is_trivially_relocatable_v<std::unique_ptr<int>>);
+    static_assert(utl::is_trivially_relocatable_v<utl::unique_ptr<int>>);
+    static_assert(utl::is_trivially_relocatable_v<utl::basic_string<char>>);
+    static_assert(utl::is_trivially_relocatable_v<utl::any>);
+    static_assert(utl::is_trivially_relocatable_v<utl::vector<std::string>>);
+    static_assert(!utl::is_trivially_relocatable_v<std::string>);
+  }
+
+  TEST_CASE("trivially relocatable elements") {
+    Relocatable::moves = 0;
+    Relocatable::destroyed = 0;
+    const Relocatable bad(-3);
+    {
+      utl::vector<Relocatable> v;
+      for (int i = 0; i != 100; ++i)
+        v.emplace_back(i);
+      v.shrink_to_fit();
+      CHECK(Relocatable::destroyed == 0);
+
+      v.emplace(v.begin() + 10, -1);
+      v.insert(v.begin(), Relocatable(-2));
+      CHECK(Relocatable::destroyed == 1);
+      CHECK(*v[0].value == -2);
+      CHECK(*v[11].value == -1);
+      CHECK(*v[12].value == 10);
+      CHECK(*v.back().value == 99);
+
+#if !UTL_NO_EXCEPTIONS
+      CHECK_THROWS(v.insert(v.begin() + 5, bad));
+      CHECK(v.size() == 102);
+      CHECK(*v[5].value == 4);
+      CHECK(*v[6].value == 5);
+#endif
+
+      Relocatable::destroyed = 0;
+      v.erase(v.begin(), v.begin() + 2);
+      CHECK(Relocatable::destroyed == 2);
+      CHECK(*v[0].value == 1);
+      CHECK(*v[9].value == -1);
+      CHECK(Relocatable::moves == 1);
+    }
+    CHECK(Relocatable::destroyed == 102);
+  }
+
+  TEST_CASE("relocating vector of unique_ptr") {
+    utl::vector<utl::unique_ptr<int>> v;
+    for (int i = 0; i != 1000; ++i)
+      v.push_back(utl::make_unique<int>(i));
+    v.erase(v.begin() + 1);
+    v.insert(v.begin(), utl::make_unique<int>(-1));
+    CHECK(*v[0] == -1);
+    CHECK(*v[1] == 0);
+    CHECK(*v[2] == 2);
+    CHECK(*v[999] == 999);
+  }
+}
+
+TEST_SUITE("vector") {
+  TEST_CASE("insert from input iterators") {
+    std::istringstream iss("10 20 30 40");
+    utl::vector<int> v{1, 2, 3};
+    const auto it = v.insert(v.begin() + 1, std::istream_iterator<int>{iss},
+                             std::istream_iterator<int>());
+    CHECK(it == v.begin() + 1);
+    const utl::vector<int> expected{1, 10, 20, 30, 40, 2, 3};
+    CHECK(v == expected);
+
+    std::istringstream words("b c");
+    utl::vector<std::string> sv{"a", "d"};
+    sv.insert(sv.begin() + 1, std::istream_iterator<std::string>{words},
+              std::istream_iterator<std::string>());
+    CHECK(sv.size() == 4);
+    CHECK(sv[1] == "b");
+    CHECK(sv[2] == "c");
+    CHECK(sv[3] == "d");
+
+    utl::vector<Relocatable> rv;
+    rv.emplace_back(1);
+    rv.emplace_back(4);
+    std::istringstream nums("2 3");
+    rv.insert(rv.begin() + 1, std::istream_iterator<int>{nums},
+              std::istream_iterator<int>());
+    CHECK(*rv[1].value == 2);
+    CHECK(*rv[2].value == 3);
+    CHECK(*rv[3].value == 4);
+  }
+
+  TEST_CASE("insert_range and append_range") {
+    utl::vector<int> v{1, 5};
+    const std::vector<int> mid{2, 3, 4};
+    v.insert_range(v.begin() + 1, mid);
+    v.append_range(std::vector<int>{6, 7});
+    const utl::vector<int> expected{1, 2, 3, 4, 5, 6, 7};
+    CHECK(v == expected);
+
+    std::istringstream iss("8 9");
+    v.append_range(std::vector<int>(std::istream_iterator<int>{iss},
+                                    std::istream_iterator<int>()));
+    CHECK(v.size() == 9);
+    CHECK(v.back() == 9);
+  }
+
+  TEST_CASE("comparisons") {
+    const utl::vector<int> a{1, 2, 3};
+    const utl::vector<int> b{1, 2, 4};
+    const utl::vector<int> prefix{1, 2};
+    CHECK(a == utl::vector<int>{1, 2, 3});
+    CHECK(a != b);
+    CHECK(a < b);
+    CHECK(b > a);
+    CHECK(a <= b);
+    CHECK(a <= a);
+    CHECK(b >= a);
+    CHECK(prefix < a);
+    CHECK(!(a < prefix));
+    CHECK(utl::vector<int>{} < prefix);
+
+    // Signed and multi-byte values must not be ordered bytewise.
+    CHECK(utl::vector<int>{-1} < utl::vector<int>{1});
+    CHECK(utl::vector<unsigned>{0x100} > utl::vector<unsigned>{0xff});
+    CHECK(utl::vector<signed char>{-1} < utl::vector<signed char>{0});
+    CHECK(utl::vector<unsigned char>{0xff} > utl::vector<unsigned char>{0});
+    CHECK(utl::vector<std::byte>{std::byte{2}} >
+          utl::vector<std::byte>{std::byte{1}, std::byte{9}});
+
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    CHECK(utl::vector<double>{nan} != utl::vector<double>{nan});
+    CHECK(utl::vector<double>{0.0} == utl::vector<double>{-0.0});
+
+    utl::vector<std::string> s1{"a", "b"}, s2{"a", "c"};
+    CHECK(s1 < s2);
+    CHECK(s1 != s2);
+  }
+
+  TEST_CASE("comparisons find mismatches at every offset") {
+    utl::vector<std::uint16_t> x(100, std::uint16_t{7});
+    bool ok = true;
+    for (std::size_t i = 0; i != x.size(); ++i) {
+      auto y = x;
+      ok = ok && x == y && !(x < y);
+      y[i] = 8;
+      ok = ok && x != y && x < y && y > x;
+      y[i] = 6;
+      ok = ok && x > y;
+    }
+    CHECK(ok);
+  }
+
+  TEST_CASE("erase_if keeps order") {
+    for (std::size_t n : {0u, 1u, 7u, 8u, 17u, 1000u, 1024u, 5000u}) {
+      utl::vector<int> v32;
+      utl::vector<std::uint64_t> v64;
+      utl::vector<double> vd;
+      std::vector<int> expected;
+      for (std::size_t i = 0; i != n; ++i) {
+        const int x = static_cast<int>((i * 7919) % 13);
+        v32.push_back(x);
+        v64.push_back(static_cast<std::uint64_t>(x));
+        vd.push_back(x);
+        if (x % 3)
+          expected.push_back(x);
+      }
+      const auto removed = n - expected.size();
+      CHECK(utl::erase_if(v32, [](int x) { return x % 3 == 0; }) == removed);
+      CHECK(utl::erase_if(v64, [](std::uint64_t x) { return x % 3 == 0; }) ==
+            removed);
+      CHECK(utl::erase_if(vd, [](double x) { return int(x) % 3 == 0; }) ==
+            removed);
+      CHECK(std::equal(v32.begin(), v32.end(), expected.begin(),
+                       expected.end()));
+      CHECK(std::equal(v64.begin(), v64.end(), expected.begin(),
+                       expected.end()));
+      CHECK(std::equal(vd.begin(), vd.end(), expected.begin(),
+                       expected.end()));
+    }
+
+    struct pair16 {
+      std::int64_t key, value;
+    };
+    utl::vector<pair16> pairs;
+    for (std::int64_t i = 0; i != 100; ++i)
+      pairs.push_back({i, -i});
+    CHECK(utl::erase_if(pairs, [](const pair16 &p) { return p.key & 1; }) ==
+          50);
+    CHECK(pairs.size() == 50);
+    CHECK(pairs[10].key == 20);
+    CHECK(pairs[10].value == -20);
+
+    utl::vector<std::string> strings{"a", "bb", "c", "dd"};
+    CHECK(utl::erase_if(strings, [](const std::string &s) {
+            return s.size() == 2;
+          }) == 2);
+    CHECK((strings == utl::vector<std::string>{"a", "c"}));
+  }
+
+  TEST_CASE("erase by value") {
+    utl::vector<int> v{1, 2, 3, 2, 1, 2};
+    CHECK(utl::erase(v, v[1]) == 3);
+    CHECK((v == utl::vector<int>{1, 3, 1}));
+    CHECK(utl::erase(v, 7) == 0);
+
+    utl::vector<std::string> strings{"a", "b", "a", "c", "a"};
+    CHECK(utl::erase(strings, strings[0]) == 3);
+    CHECK((strings == utl::vector<std::string>{"b", "c"}));
+  }
+
+  TEST_CASE("erase_if_unordered") {
+    utl::vector<int> v(1000);
+    std::iota(v.begin(), v.end(), 0);
+    CHECK(utl::erase_if_unordered(v, [](int x) { return x % 4 == 0; }) ==
+          250);
+    CHECK(v.size() == 750);
+    CHECK(std::none_of(v.begin(), v.end(), [](int x) { return x % 4 == 0; }));
+    std::sort(v.begin(), v.end());
+    CHECK(std::adjacent_find(v.begin(), v.end()) == v.end());
+
+    utl::vector<std::string> strings{"x", "a", "x", "b", "x"};
+    CHECK(utl::erase_if_unordered(
+              strings, [](const std::string &s) { return s == "x"; }) == 3);
+    std::sort(strings.begin(), strings.end());
+    CHECK((strings == utl::vector<std::string>{"a", "b"}));
+
+    utl::vector<int> all(10u, 1);
+    CHECK(utl::erase_if_unordered(all, [](int) { return true; }) == 10);
+    CHECK(all.empty());
+  }
+
+  TEST_CASE("parallel construction and resize") {
+    const std::size_t n = (std::size_t(1) << 22) + 17;
+    utl::vector<std::uint32_t> zeros(n, utl::par);
+    CHECK(zeros.size() == n);
+    CHECK(std::all_of(zeros.begin(), zeros.end(),
+                      [](std::uint32_t x) { return x == 0; }));
+
+    utl::vector<std::uint32_t> sevens(n, 7u, utl::par);
+    CHECK(std::count(sevens.begin(), sevens.end(), 7u) ==
+          static_cast<std::ptrdiff_t>(n));
+
+    sevens.resize(2 * n, 9u, utl::par);
+    CHECK(sevens[n - 1] == 7);
+    CHECK(sevens[n] == 9);
+    CHECK(sevens.back() == 9);
+    sevens.resize(10, utl::par);
+    CHECK(sevens.size() == 10);
+
+    utl::vector<std::string> strings(200000, std::string(40, 'x'), utl::par);
+    CHECK(strings.back() == std::string(40, 'x'));
+  }
+
+  TEST_CASE("parallel construction cleans up after a throw") {
+    static std::atomic<int> live{0};
+    static std::atomic<int> constructed{0};
+    struct fragile {
+      fragile() {
+        if (++constructed == 300000)
+          throw std::runtime_error("fragile");
+        ++live;
+      }
+      fragile(const fragile &) = delete;
+      ~fragile() { --live; }
+      char pad[32];
+    };
+    CHECK_THROWS_AS(utl::vector<fragile>(500000, utl::par), std::runtime_error);
+    CHECK(live == 0);
+  }
+
+  TEST_CASE("compact_vector") {
+    static_assert(sizeof(utl::vector<int>) == 3 * sizeof(void *));
+    static_assert(sizeof(utl::compact_vector<int>) == 16);
+    static_assert(std::is_same_v<utl::compact_vector<int>::size_type,
+                                 std::uint32_t>);
+
+    utl::compact_vector<std::string> v;
+    CHECK(v.max_size() <= std::numeric_limits<std::uint32_t>::max());
+    for (int i = 0; i != 1000; ++i)
+      v.push_back(std::to_string(i));
+    v.insert(v.begin(), 10u, std::string("x"));
+    v.erase(v.begin(), v.begin() + 10);
+    CHECK(v.size() == 1000);
+    CHECK(v.front() == "0");
+    CHECK(v.back() == "999");
+
+    utl::compact_vector<std::string> w = v;
+    CHECK(w == v);
+    w.resize(10);
+    w.shrink_to_fit();
+    CHECK(w.capacity() == 10);
+    swap(v, w);
+    CHECK(v.size() == 10);
+    CHECK(utl::erase_if(w, [](const std::string &x) {
+            return x.size() == 3;
+          }) == 900);
+  }
+
+  TEST_CASE("narrow size type limits growth") {
+    // The allocator hands out whole pages; capacity stops at max_size().
+    using tiny = utl::vector<char, utl::allocator<char>, utl::doubling_growth,
+                             std::uint8_t>;
+    tiny v;
+    CHECK(v.max_size() == 255);
+    for (int i = 0; i != 255; ++i)
+      v.push_back(static_cast<char>(i));
+    CHECK(v.size() == 255);
+    CHECK(v.capacity() == 255);
+    CHECK(v[254] == static_cast<char>(254));
+    CHECK_THROWS_AS(v.push_back('x'), std::length_error);
+    CHECK_THROWS_AS(v.insert(v.begin(), std::uint8_t{2}, 'x'),
+                    std::length_error);
+    CHECK(v.size() == 255);
+
+    v.resize(100);
+    const std::string more(200, 'y');
+    CHECK_THROWS_AS(v.insert(v.end(), more.begin(), more.end()),
+                    std::length_error);
+    CHECK(v.size() == 100);
+    v.insert(v.end(), more.begin(), more.begin() + 155);
+    CHECK(v.size() == 255);
+  }
+}